@@ -0,0 +1,90 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "AudioEndpointProvider.h"
+#include "ControllerStats.h"
+
+/// <summary>
+/// Friendly name -> endpoint id index of the active endpoints of one flow, with a sorted table of the lowercase names for the pattern lookups.
+/// Built with a single enumeration: hits and misses are both answered from the index, lookups never touch the backend
+/// until the directory is refreshed or invalidated.
+/// </summary>
+class AudioDeviceDirectory
+{
+public:
+	// pStats (optional) receives the enumeration latencies.
+	AudioDeviceDirectory(IAudioEndpointProvider* pProvider, EndpointFlow pFlow, ControllerStats* pStats);
+	~AudioDeviceDirectory();
+
+	// Enumerates the endpoints once and rebuilds the index.
+	bool Refresh();
+	// The next lookup will refresh the index.
+	inline void Invalidate() { _valid = false; }
+	inline bool IsValid()const { return _valid; }
+
+	// Returns false if no active endpoint has this friendly name.
+	bool FindIdByName(const std::string& pFriendlyName, std::string& pEndpointId);
+	// NULL if no active endpoint has this id.
+	const EndpointInfo* FindById(const std::string& pEndpointId);
+	// NULL if no active endpoint has this friendly name. Same as FindIdByName, without copying the id.
+	const EndpointInfo* FindByName(const std::string& pFriendlyName);
+	// First active endpoint matching pPattern, in lowercase name order. NULL if none.
+	// Prefix lookups are a binary search, substring and wildcard lookups a scan of the lowercase names (their results are cached until the next change).
+	const EndpointInfo* Match(const std::string& pPattern, WAIC_MatchMode pMode);
+
+	// Incremental updates, from the endpoint notifications. Ignored while the directory is invalid (the next refresh will see them).
+	void AddEndpoint(const EndpointInfo& pEndpoint);
+	void RemoveEndpoint(const std::string& pEndpointId);
+
+	inline const std::vector<EndpointInfo>& GetEndpoints()const { return _endpoints; }
+	inline uint64_t GetRefreshCount()const { return _refreshCount; }
+	inline uint64_t GetMissCount()const { return _missCount; }
+
+private:
+	void _IndexName(size_t pIndex);
+	static const size_t NO_MATCH = (size_t)-1;
+	static const size_t MATCHES_CAPACITY = 256;
+
+	void _SortNames();
+	static void _Normalize(const std::string& pName, std::string& pNormalizedName);
+	static bool _MatchWildcard(const char* pName, const char* pPattern);
+
+private:
+	IAudioEndpointProvider* _provider;
+	EndpointFlow _flow;
+	ControllerStats* _stats;
+	bool _valid;
+	uint64_t _refreshCount;
+	uint64_t _missCount;
+	std::vector<EndpointInfo> _endpoints;
+	std::unordered_map<std::string, size_t> _indicesByName;
+	std::unordered_map<std::string, size_t> _indicesById;
+	// (lowercase name, endpoint index), sorted. Rebuilt on the next pattern lookup after an incremental update.
+	std::vector<std::pair<std::string, size_t>> _sortedNames;
+	bool _sortedNamesValid;
+	std::string _normalizedPattern;
+	// Mode + lowercase pattern -> endpoint index (NO_MATCH if none), for the substring and wildcard lookups.
+	std::unordered_map<std::string, size_t> _matches;
+};
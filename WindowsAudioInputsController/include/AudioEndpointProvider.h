@@ -0,0 +1,242 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Result codes share the HRESULT layout, so the WASAPI backend can forward its HRESULTs unchanged.
+typedef int32_t EndpointResult;
+
+const EndpointResult ENDPOINT_OK = 0;
+const EndpointResult ENDPOINT_S_FALSE = 1;											// S_FALSE: succeeded, nothing had to be done
+const EndpointResult ENDPOINT_E_FAIL = (EndpointResult)0x80004005;				// E_FAIL
+const EndpointResult ENDPOINT_E_INVALIDARG = (EndpointResult)0x80070057;		// E_INVALIDARG
+const EndpointResult ENDPOINT_E_NOTFOUND = (EndpointResult)0x80070490;			// HRESULT_FROM_WIN32(ERROR_NOT_FOUND)
+const EndpointResult ENDPOINT_E_DEVICE_INVALIDATED = (EndpointResult)0x88890004;	// AUDCLNT_E_DEVICE_INVALIDATED
+const EndpointResult ENDPOINT_E_SERVICE_NOT_RUNNING = (EndpointResult)0x88890010;	// AUDCLNT_E_SERVICE_NOT_RUNNING
+const EndpointResult ENDPOINT_E_DISCONNECTED = (EndpointResult)0x80010108;			// RPC_E_DISCONNECTED
+const EndpointResult ENDPOINT_E_SERVER_UNAVAILABLE = (EndpointResult)0x800706BA;	// HRESULT_FROM_WIN32(RPC_S_SERVER_UNAVAILABLE)
+const EndpointResult ENDPOINT_E_CALL_REJECTED = (EndpointResult)0x80010001;		// RPC_E_CALL_REJECTED
+const EndpointResult ENDPOINT_E_RETRY_LATER = (EndpointResult)0x8001010A;			// RPC_E_SERVERCALL_RETRYLATER
+const EndpointResult ENDPOINT_E_BUSY = (EndpointResult)0x800700AA;				// HRESULT_FROM_WIN32(ERROR_BUSY)
+// Returned by the controller itself (see CallPolicy), never by a backend call.
+const EndpointResult ENDPOINT_E_TIMEOUT = (EndpointResult)0x800705B4;				// HRESULT_FROM_WIN32(ERROR_TIMEOUT): deadline of the call reached
+const EndpointResult ENDPOINT_E_CIRCUIT_OPEN = (EndpointResult)0x800704D5;		// HRESULT_FROM_WIN32(ERROR_RETRY): rejected by the circuit breaker of the device
+
+inline bool EndpointSucceeded(EndpointResult pResult) { return pResult >= 0; }
+// The object that returned pResult is no longer usable (device removed, audio service restarted): it must be opened again.
+inline bool EndpointIsDisconnected(EndpointResult pResult)
+{
+	return pResult == ENDPOINT_E_DEVICE_INVALIDATED || pResult == ENDPOINT_E_SERVICE_NOT_RUNNING || pResult == ENDPOINT_E_DISCONNECTED || pResult == ENDPOINT_E_SERVER_UNAVAILABLE;
+}
+// The call may succeed if made again a bit later (audio service restarting, busy driver). An invalidated device is not transient: it is gone.
+inline bool EndpointIsTransient(EndpointResult pResult)
+{
+	return pResult == ENDPOINT_E_SERVICE_NOT_RUNNING || pResult == ENDPOINT_E_DISCONNECTED || pResult == ENDPOINT_E_SERVER_UNAVAILABLE
+		|| pResult == ENDPOINT_E_CALL_REJECTED || pResult == ENDPOINT_E_RETRY_LATER || pResult == ENDPOINT_E_BUSY;
+}
+
+enum class EndpointFlow : uint8_t
+{
+	Capture,
+	Render
+};
+
+// Same values as DEVICE_STATE_XXX
+const uint32_t ENDPOINT_STATE_ACTIVE = 0x1;
+const uint32_t ENDPOINT_STATE_DISABLED = 0x2;
+const uint32_t ENDPOINT_STATE_NOTPRESENT = 0x4;
+const uint32_t ENDPOINT_STATE_UNPLUGGED = 0x8;
+const uint32_t ENDPOINT_STATE_ALL = 0xF;
+
+// Same memory layout as GUID / PROPERTYKEY.
+struct EndpointGuid
+{
+	uint32_t data1;
+	uint16_t data2;
+	uint16_t data3;
+	uint8_t data4[8];
+};
+
+struct EndpointPropertyKey
+{
+	EndpointGuid fmtid;
+	uint32_t pid;
+};
+
+bool operator==(const EndpointGuid& pLeft, const EndpointGuid& pRight);
+bool operator==(const EndpointPropertyKey& pLeft, const EndpointPropertyKey& pRight);
+
+// PKEY_Device_FriendlyName
+const EndpointPropertyKey ENDPOINT_PKEY_FRIENDLY_NAME = { { 0xA45C254E, 0xDF1C, 0x4EFD, { 0x80, 0x20, 0x67, 0xD1, 0x46, 0xA8, 0x50, 0xE0 } }, 14 };
+
+// Portable subset of PROPVARIANT: strings are stored as UTF-8.
+struct EndpointPropertyValue
+{
+	enum Type : uint8_t
+	{
+		Empty,
+		Bool,
+		String
+	};
+
+	EndpointPropertyValue() : type(Empty), boolValue(false), stringValue() {}
+	static EndpointPropertyValue FromBool(bool pValue);
+	static EndpointPropertyValue FromString(const std::string& pValue);
+
+	Type type;
+	bool boolValue;
+	std::string stringValue;
+};
+
+struct EndpointInfo
+{
+	std::string id;
+	std::string friendlyName;
+	EndpointFlow flow;
+	uint32_t state;
+};
+
+class IEndpointPropertyStore
+{
+public:
+	virtual ~IEndpointPropertyStore() {}
+
+	virtual EndpointResult GetValue(const EndpointPropertyKey& pKey, EndpointPropertyValue& pValue) = 0;
+	virtual EndpointResult SetValue(const EndpointPropertyKey& pKey, const EndpointPropertyValue& pValue) = 0;
+};
+
+// Level of an endpoint stream (same as IAudioMeterInformation). Keeps the endpoint alive: it can outlive its IAudioEndpoint.
+class IEndpointMeter
+{
+public:
+	virtual ~IEndpointMeter() {}
+
+	// Peak sample value of the last processing period, from 0.0 to 1.0.
+	virtual EndpointResult GetPeakValue(float& pPeak) = 0;
+};
+
+enum class EndpointSampleType : uint8_t
+{
+	Int16,
+	Int24,		// Packed, 3 bytes per sample.
+	Int32,		// Also used for 24 bits samples in a 32 bits container (left-aligned).
+	Float32
+};
+
+// Interleaved PCM format of a stream.
+struct EndpointStreamFormat
+{
+	uint32_t sampleRate;
+	uint16_t channels;
+	EndpointSampleType sampleType;
+
+	static inline uint32_t GetSampleSize(EndpointSampleType pSampleType) { return (pSampleType == EndpointSampleType::Int16) ? 2 : ((pSampleType == EndpointSampleType::Int24) ? 3 : 4); }
+	inline uint32_t GetFrameSize()const { return channels * GetSampleSize(sampleType); }
+};
+
+/// <summary>
+/// Shared-mode, event-driven stream on an endpoint (same as IAudioClient with IAudioCaptureClient or IAudioRenderClient).
+/// Capture streams are read with ReadPacket/ReleasePacket, render streams written with GetWriteBuffer/ReleaseWriteBuffer.
+/// Used by a single thread once opened.
+/// </summary>
+class IEndpointStream
+{
+public:
+	virtual ~IEndpointStream() {}
+
+	virtual bool IsCapture()const = 0;
+	virtual const EndpointStreamFormat& GetFormat()const = 0;
+	// Sizes in frames: endpoint buffer, processing period (time between two WaitPeriod wakeups) and latency added by the stream.
+	virtual uint32_t GetBufferFrames()const = 0;
+	virtual uint32_t GetPeriodFrames()const = 0;
+	virtual uint32_t GetLatencyFrames()const = 0;
+
+	virtual EndpointResult Start() = 0;
+	virtual EndpointResult Stop() = 0;
+	// Waits for the next processing period: ENDPOINT_S_FALSE after pTimeoutMs without one.
+	virtual EndpointResult WaitPeriod(uint32_t pTimeoutMs) = 0;
+
+	// Capture: next packet, pFrames is 0 when there is none. Each packet must be released before reading the next one.
+	virtual EndpointResult ReadPacket(const uint8_t*& pData, uint32_t& pFrames, bool& pSilent) = 0;
+	virtual EndpointResult ReleasePacket(uint32_t pFrames) = 0;
+
+	// Render: frames queued but not played yet.
+	virtual EndpointResult GetPadding(uint32_t& pFrames) = 0;
+	virtual EndpointResult GetWriteBuffer(uint32_t pFrames, uint8_t*& pData) = 0;
+	virtual EndpointResult ReleaseWriteBuffer(uint32_t pFrames) = 0;
+};
+
+class IAudioEndpoint
+{
+public:
+	virtual ~IAudioEndpoint() {}
+
+	virtual const std::string& GetId()const = 0;
+	virtual EndpointResult OpenPropertyStore(bool pReadWrite, std::unique_ptr<IEndpointPropertyStore>& pStore) = 0;
+	virtual EndpointResult OpenMeter(std::unique_ptr<IEndpointMeter>& pMeter) = 0;
+	// Shared-mode stream in the endpoint mix format, with a pBufferUs endpoint buffer.
+	// pSampleRate: 0 for the mix rate, otherwise the stream converts to/from the mix rate.
+	virtual EndpointResult OpenStream(uint32_t pBufferUs, uint32_t pSampleRate, std::unique_ptr<IEndpointStream>& pStream) = 0;
+};
+
+/// <summary>
+/// Receives the endpoint changes of the machine (same events as IMMNotificationClient).
+/// Can be called from any thread: implementations must not block, nor call back into the provider.
+/// </summary>
+class IEndpointNotificationClient
+{
+public:
+	virtual ~IEndpointNotificationClient() {}
+
+	virtual void OnEndpointAdded(const std::string& pEndpointId) = 0;
+	virtual void OnEndpointRemoved(const std::string& pEndpointId) = 0;
+	virtual void OnEndpointStateChanged(const std::string& pEndpointId, uint32_t pNewState) = 0;
+	virtual void OnEndpointPropertyChanged(const std::string& pEndpointId, const EndpointPropertyKey& pKey) = 0;
+};
+
+/// <summary>
+/// Backend giving access to the audio endpoints of the machine (WASAPI on Windows, in-memory mock elsewhere).
+/// </summary>
+class IAudioEndpointProvider
+{
+public:
+	virtual ~IAudioEndpointProvider() {}
+
+	// Must be called once, before any other call, on the thread that will use the provider.
+	virtual EndpointResult Initialize() = 0;
+	// Must be called by any additional thread using the provider (eg. worker threads), before its first call and after its last call.
+	virtual EndpointResult InitializeThread() = 0;
+	virtual void UninitializeThread() = 0;
+	// Lists the endpoints of the given flow whose state matches pStateMask, with their friendly names, in one pass.
+	virtual EndpointResult EnumerateEndpoints(EndpointFlow pFlow, uint32_t pStateMask, std::vector<EndpointInfo>& pEndpoints) = 0;
+	virtual EndpointResult GetEndpointInfo(const std::string& pEndpointId, EndpointInfo& pInfo) = 0;
+	virtual EndpointResult OpenEndpoint(const std::string& pEndpointId, std::unique_ptr<IAudioEndpoint>& pEndpoint) = 0;
+	// Default device of the given flow (console role).
+	virtual EndpointResult GetDefaultEndpointId(EndpointFlow pFlow, std::string& pEndpointId) = 0;
+
+	virtual EndpointResult RegisterNotificationClient(IEndpointNotificationClient* pClient) = 0;
+	virtual EndpointResult UnregisterNotificationClient(IEndpointNotificationClient* pClient) = 0;
+};
+
+// WASAPI provider on Windows, empty MockEndpointProvider on other platforms.
+IAudioEndpointProvider* CreateDefaultEndpointProvider();
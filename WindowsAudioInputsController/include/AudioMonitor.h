@@ -0,0 +1,89 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "AudioEndpointProvider.h"
+#include "SampleConversion.h"
+#include "SampleRing.h"
+#include "WindowsAudioInputsControllerC.h"
+
+/// <summary>
+/// Software monitor: a capture thread converts the input stream to float samples into a SampleRing, a render thread maps its channels,
+/// applies the gain and writes them to the output stream. Both threads are woken by their stream events, with small endpoint buffers.
+/// The render thread keeps the ring around its target fill: it waits for it before playing, and drops the excess (clock drift).
+/// </summary>
+class AudioMonitor
+{
+public:
+	AudioMonitor();
+	~AudioMonitor();
+
+	// Takes ownership of the streams (pRender at the capture sample rate) and starts them with the monitor threads, which use pProvider.
+	// Resets the channel map to the default one: input channel c on output channel c, a mono input on every output channel.
+	EndpointResult Start(IAudioEndpointProvider* pProvider, std::unique_ptr<IEndpointStream>& pCapture, std::unique_ptr<IEndpointStream>& pRender);
+	// Releases the streams: must be called on a thread on which the provider is initialized.
+	void Stop();
+	// False once stopped, or after a stream failure (see GetStats).
+	inline bool IsRunning()const { return _running.load(std::memory_order_acquire); }
+
+	// Any thread, applied from the next render period.
+	inline void SetGain(float pGain) { _gain.store(pGain, std::memory_order_relaxed); }
+	// pMap[c]: input channel played on the output channel c, negative for silence. The missing output channels are silent.
+	void SetChannelMap(const int8_t* pMap, int pCount);
+
+	// Any thread.
+	void GetStats(WAIC_MonitorStats& pStats)const;
+
+private:
+	void _Capture(IAudioEndpointProvider* pProvider);
+	void _Render(IAudioEndpointProvider* pProvider);
+	// Stops both threads, keeping the first failure.
+	void _Fail(EndpointResult pResult);
+	// Writes pFrames frames to the render stream: the first pInputFrames ones of _renderInput, then silence.
+	EndpointResult _WriteFrames(uint32_t pInputFrames, uint32_t pFrames);
+
+private:
+	std::unique_ptr<IEndpointStream> _capture;
+	std::unique_ptr<IEndpointStream> _render;
+	SampleRing _ring;
+	// Frames kept in the ring: one capture period, plus one render period of jitter.
+	uint32_t _targetFrames;
+	// Conversion buffers, allocated by Start().
+	std::vector<float> _captureSamples;
+	std::vector<float> _renderInput;
+	std::vector<float> _renderOutput;
+	std::atomic<bool> _stop;
+	std::atomic<bool> _running;
+	std::atomic<float> _gain;
+	std::atomic<int8_t> _channelMap[SAMPLES_MAX_CHANNELS];
+	std::atomic<uint64_t> _capturedFrames;
+	std::atomic<uint64_t> _renderedFrames;
+	std::atomic<uint64_t> _underruns;
+	std::atomic<uint64_t> _overruns;
+	std::atomic<uint64_t> _droppedFrames;
+	std::atomic<uint32_t> _latencyUs;
+	std::atomic<int32_t> _result;
+	std::thread _captureThread;
+	std::thread _renderThread;
+};
@@ -0,0 +1,128 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/// <summary>
+/// Thread owning the endpoint backend: every backend call is executed on it, in submission order.
+/// Requests are submitted through a lock-free intrusive MPSC queue, they are owned by the submitter (no allocation).
+/// </summary>
+class BackendThread
+{
+public:
+	struct Request
+	{
+		Request() : next(NULL) {}
+		virtual ~Request() {}
+		// Called on the backend thread.
+		virtual void Execute() = 0;
+
+		std::atomic<Request*> next;
+	};
+
+	BackendThread();
+	~BackendThread();
+
+	// pOnStart/pOnStop are called on the backend thread, before the first and after the last request.
+	// pOnTimer (optional) is called on the backend thread once the time given to SetTimer() is reached.
+	void Start(const std::function<void()>& pOnStart, const std::function<void()>& pOnStop, const std::function<void()>& pOnTimer = std::function<void()>());
+	// Executes the requests already submitted, then stops the thread.
+	void Stop();
+
+	// Lock-free. pRequest must stay alive until it has been executed.
+	void Submit(Request* pRequest);
+
+	// Backend thread only. Replaces the previous timer, if any.
+	void SetTimer(std::chrono::steady_clock::time_point pTime);
+
+	// Executes pFunction on the backend thread and waits for it (executed inline when called from the backend thread).
+	template<typename F>
+	void Call(F&& pFunction)
+	{
+		if (IsCurrentThread())
+		{
+			pFunction();
+			return;
+		}
+
+		CallRequest<F> request(pFunction);
+		Submit(&request);
+		request.Wait();
+	}
+
+	inline bool IsCurrentThread()const { return std::this_thread::get_id() == _threadId.load(); }
+	inline bool IsRunning()const { return _thread.joinable(); }
+
+private:
+	template<typename F>
+	struct CallRequest : Request
+	{
+		CallRequest(F& pFunction) : function(pFunction), mutex(), done(), completed(false) {}
+
+		void Execute() override
+		{
+			function();
+			std::lock_guard<std::mutex> lock(mutex);
+			completed = true;
+			done.notify_one();
+		}
+
+		void Wait()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this] { return completed; });
+		}
+
+		F& function;
+		std::mutex mutex;
+		std::condition_variable done;
+		bool completed;
+	};
+
+	struct StubRequest : Request
+	{
+		void Execute() override {}
+	};
+
+	void _Run(std::function<void()> pOnStart, std::function<void()> pOnStop, std::function<void()> pOnTimer);
+	void _Push(Request* pRequest);
+	Request* _Pop();
+
+private:
+	std::thread _thread;
+	std::atomic<std::thread::id> _threadId;
+	// Vyukov intrusive MPSC queue: producers exchange _head, the backend thread consumes from _tail.
+	std::atomic<Request*> _head;
+	Request* _tail;
+	StubRequest _stub;
+	std::atomic<int> _pendingCount;
+	std::atomic<bool> _sleeping;
+	std::atomic<bool> _stopping;
+	std::mutex _sleepMutex;
+	std::condition_variable _wakeUp;
+	// Only used by the backend thread.
+	bool _timerSet;
+	std::chrono::steady_clock::time_point _timerTime;
+};
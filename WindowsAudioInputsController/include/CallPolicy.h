@@ -0,0 +1,150 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "AudioEndpointProvider.h"
+#include "ControllerStats.h"
+
+/// <summary>
+/// Per-device circuit breaker: after a number of consecutive failures it opens, rejecting the calls for a cooldown, then lets a single
+/// trial call through (half-open) which closes it again on success or reopens it on failure. Not thread-safe: its owner serializes the calls.
+/// </summary>
+class CircuitBreaker
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	CircuitBreaker();
+
+	void Reset();
+	inline bool IsOpen()const { return _state == Open; }
+
+	// False while open. Once the cooldown has elapsed, allows the trial call.
+	bool Allow(Clock::time_point pNow);
+	/// <summary>
+	/// Counts the result of an allowed call.
+	/// </summary>
+	/// <returns>True if the breaker has just (re)opened</returns>
+	bool Record(bool pSuccess, int pFailureThreshold, int pCooldownMs, Clock::time_point pNow);
+
+private:
+	enum State { Closed, Open, HalfOpen };
+
+	State _state;
+	int _failures;
+	Clock::time_point _openUntil;
+};
+
+/// <summary>
+/// Failure handling of the backend calls: the transient failures (see EndpointIsTransient) are retried with exponential backoff,
+/// within the deadline of the calling thread, and the failures are counted by the circuit breaker of the device.
+/// The settings can be changed from any thread, a call in progress keeping the ones it started with.
+/// </summary>
+class CallPolicy
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	static const int DEFAULT_MAX_ATTEMPTS = 3;
+	static const int DEFAULT_INITIAL_BACKOFF_MS = 10;
+	static const int DEFAULT_MAX_BACKOFF_MS = 200;
+	static const int DEFAULT_COOLDOWN_MS = 5000;
+
+	/// <summary>
+	/// Deadline of the calls made by the current thread for the lifetime of the scope (none outside of any scope).
+	/// Scopes can be nested: the previous deadline is restored on exit.
+	/// </summary>
+	class DeadlineScope
+	{
+	public:
+		explicit DeadlineScope(Clock::time_point pDeadline);
+		~DeadlineScope();
+
+		DeadlineScope(const DeadlineScope&) = delete;
+		DeadlineScope& operator=(const DeadlineScope&) = delete;
+
+	private:
+		Clock::time_point _previous;
+	};
+
+	// pStats (optional) receives the retries, timeouts and breaker rejections.
+	explicit CallPolicy(ControllerStats* pStats);
+
+	// pMaxAttempts 1 disables the retries. The backoff starts at pInitialBackoffMs and doubles after each retry, up to pMaxBackoffMs.
+	void SetRetry(int pMaxAttempts, int pInitialBackoffMs, int pMaxBackoffMs);
+	// pFailureThreshold 0 disables the breakers.
+	void SetCircuitBreaker(int pFailureThreshold, int pCooldownMs);
+
+	// Time point::max() when the current thread has no deadline.
+	static Clock::time_point GetDeadline();
+
+	/// <summary>
+	/// Runs pCall (returning an EndpointResult) under the policy, pBreaker being the breaker of the device it accesses.
+	/// The retries stop before the deadline, the last failure being returned.
+	/// The backoff sleeps on the calling thread, ie. the backend thread (or a worker pool thread for the parallel reads): the requests
+	/// queued behind this call wait for it, at most (max attempts - 1) * max backoff, and never past the deadline.
+	/// </summary>
+	/// <returns>Result of the last attempt, ENDPOINT_E_CIRCUIT_OPEN if rejected by pBreaker, ENDPOINT_E_TIMEOUT if the deadline had passed</returns>
+	template<typename Call>
+	EndpointResult Run(CircuitBreaker& pBreaker, Call&& pCall)
+	{
+		if (Clock::now() >= GetDeadline())
+		{
+			_AddFault(WAIC_FAULT_TIMEOUT);
+			return ENDPOINT_E_TIMEOUT;
+		}
+		// Every allowed call is recorded: a half-open breaker would otherwise keep rejecting the calls.
+		int failureThreshold = _failureThreshold.load(std::memory_order_relaxed);
+		if (failureThreshold > 0 && !pBreaker.Allow(Clock::now()))
+		{
+			_AddFault(WAIC_FAULT_CIRCUIT_REJECTED);
+			return ENDPOINT_E_CIRCUIT_OPEN;
+		}
+
+		int maxAttempts = _maxAttempts.load(std::memory_order_relaxed);
+		EndpointResult hr = pCall();
+		for (int attempt = 1; attempt < maxAttempts && EndpointIsTransient(hr) && _Backoff(attempt); ++attempt)
+		{
+			_AddFault(WAIC_FAULT_RETRY);
+			hr = pCall();
+		}
+
+		if (failureThreshold > 0 && pBreaker.Record(EndpointSucceeded(hr), failureThreshold, _cooldownMs.load(std::memory_order_relaxed), Clock::now()))
+		{
+			_AddFault(WAIC_FAULT_CIRCUIT_OPENED);
+		}
+		return hr;
+	}
+
+private:
+	// Sleeps before the retry pAttempt (1 for the first one), blocking the calling thread. False, without waiting, if the retry would start past the deadline.
+	bool _Backoff(int pAttempt);
+	inline void _AddFault(WAIC_Fault pFault) { if (_stats != NULL) _stats->AddFault(pFault); }
+
+private:
+	ControllerStats* _stats;
+	std::atomic<int> _maxAttempts;
+	std::atomic<int> _initialBackoffMs;
+	std::atomic<int> _maxBackoffMs;
+	std::atomic<int> _failureThreshold;
+	std::atomic<int> _cooldownMs;
+};
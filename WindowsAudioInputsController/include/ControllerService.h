@@ -0,0 +1,80 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ServiceChannel.h"
+#include "WindowsAudioInputsControllerC.h"
+
+class WindowsAudioInputsController;
+
+/// <summary>
+/// Controller service: a single WindowsAudioInputsController (backend, caches, notifications) shared by all the clients
+/// connected to its channel (see ServiceClient). Each client is served by its own thread, its requests run one at a time.
+/// </summary>
+class ControllerService
+{
+public:
+	// Takes ownership of pController.
+	explicit ControllerService(WindowsAudioInputsController* pController);
+	~ControllerService();
+	ControllerService(const ControllerService&) = delete;
+	ControllerService& operator=(const ControllerService&) = delete;
+
+	bool Start(const std::string& pName);
+	// Disconnects the clients and waits for their threads.
+	void Stop();
+
+	inline int GetClientCount()const { return _clientCount; }
+
+private:
+	struct Client
+	{
+		Client() : channel(), thread(), done(false) {}
+
+		ServiceChannel channel;
+		std::thread thread;
+		std::atomic<bool> done;
+	};
+
+	void _Accept();
+	void _Serve(Client* pClient);
+	// Runs the operations of pRequest. False if the request is malformed.
+	bool _Execute(const std::vector<uint8_t>& pRequest, std::vector<uint8_t>& pResponse);
+	void _JoinDoneClients();
+
+private:
+	std::unique_ptr<WindowsAudioInputsController> _controller;
+	ServiceListener _listener;
+	std::thread _acceptThread;
+	std::mutex _clientsMutex;
+	std::list<Client> _clients;
+	std::atomic<int> _clientCount;
+	// Requests run one at a time, so that the errors they record go back to the right client.
+	std::mutex _executeMutex;
+	std::vector<WAIC_ErrorRecord> _errors;
+	std::vector<WAIC_DeviceSnapshot> _snapshot;
+};
@@ -0,0 +1,108 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "WindowsAudioInputsControllerC.h"
+
+// Set WAIC_ENABLE_STATS to 0 to compile the instrumentation out: the counters and timers then do nothing.
+#ifndef WAIC_ENABLE_STATS
+#define WAIC_ENABLE_STATS 1
+#endif
+
+/// <summary>
+/// Lock-free counters and log2 latency histograms of the backend stages. Recording never allocates nor locks.
+/// </summary>
+class ControllerStats
+{
+public:
+	ControllerStats();
+
+#if WAIC_ENABLE_STATS
+	void RecordLatency(WAIC_Stage pStage, uint64_t pNanoseconds);
+	inline void AddCacheHit(WAIC_Cache pCache) { _cacheHits[pCache].fetch_add(1, std::memory_order_relaxed); }
+	inline void AddCacheMiss(WAIC_Cache pCache) { _cacheMisses[pCache].fetch_add(1, std::memory_order_relaxed); }
+	inline void AddFault(WAIC_Fault pFault) { _faults[pFault].fetch_add(1, std::memory_order_relaxed); }
+#else
+	inline void RecordLatency(WAIC_Stage, uint64_t) {}
+	inline void AddCacheHit(WAIC_Cache) {}
+	inline void AddCacheMiss(WAIC_Cache) {}
+	inline void AddFault(WAIC_Fault) {}
+#endif
+
+	// Each counter is read atomically, but not the whole set: recordings made meanwhile may be partially visible.
+	void Read(WAIC_Stats& pStats)const;
+	void Reset();
+
+	// Appends pStats as a JSON object to pText.
+	static void FormatJson(const WAIC_Stats& pStats, std::string& pText);
+
+private:
+#if WAIC_ENABLE_STATS
+	struct Stage
+	{
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> totalNs;
+		std::atomic<uint64_t> maxNs;
+		std::atomic<uint64_t> buckets[WAIC_STATS_BUCKETS];
+	};
+
+	Stage _stages[WAIC_STAGE_COUNT];
+	std::atomic<uint64_t> _cacheHits[WAIC_CACHE_COUNT];
+	std::atomic<uint64_t> _cacheMisses[WAIC_CACHE_COUNT];
+	std::atomic<uint64_t> _faults[WAIC_FAULT_COUNT];
+#endif
+};
+
+/// <summary>
+/// Records the time spent in its scope as one sample of a stage. pStats can be NULL.
+/// </summary>
+class StatsTimer
+{
+public:
+#if WAIC_ENABLE_STATS
+	inline StatsTimer(ControllerStats* pStats, WAIC_Stage pStage) : _stats(pStats), _stage(pStage), _start()
+	{
+		if (_stats != NULL) _start = std::chrono::steady_clock::now();
+	}
+
+	inline ~StatsTimer()
+	{
+		if (_stats != NULL)
+		{
+			_stats->RecordLatency(_stage, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+		}
+	}
+#else
+	inline StatsTimer(ControllerStats*, WAIC_Stage) {}
+#endif
+
+	StatsTimer(const StatsTimer&) = delete;
+	StatsTimer& operator=(const StatsTimer&) = delete;
+
+#if WAIC_ENABLE_STATS
+private:
+	ControllerStats* _stats;
+	WAIC_Stage _stage;
+	std::chrono::steady_clock::time_point _start;
+#endif
+};
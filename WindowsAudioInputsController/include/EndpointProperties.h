@@ -0,0 +1,222 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "AudioEndpointProvider.h"
+#include "ControllerStats.h"
+
+/// <summary>
+/// Endpoint property known at compile time: its value type, GUID (pData4 holds the 8 last bytes, big-endian as written) and pid.
+/// </summary>
+template<typename T, uint32_t pData1, uint16_t pData2, uint16_t pData3, uint64_t pData4, uint32_t pPid>
+struct EndpointProperty
+{
+	typedef T ValueType;
+
+	static EndpointPropertyKey GetKey()
+	{
+		EndpointPropertyKey key = { { pData1, pData2, pData3, {} }, pPid };
+		for (int i = 0; i < 8; ++i)
+		{
+			key.fmtid.data4[i] = (uint8_t)(pData4 >> (56 - 8 * i));
+		}
+		return key;
+	}
+};
+
+// "Listen to this device" setting (Sound panel > Recording > Properties > Listen).
+typedef EndpointProperty<bool, 0x24DBB0FC, 0x9311, 0x4B3D, 0x9CF018FF155639D4ull, 1> ListenEnabledProperty;
+// Output device id, empty for the default output device.
+typedef EndpointProperty<std::string, 0x24DBB0FC, 0x9311, 0x4B3D, 0x9CF018FF155639D4ull, 0> ListenTargetProperty;
+// "Continue running when on battery power" (Listen tab, "Power Management"). Undocumented, as the other listen settings.
+typedef EndpointProperty<bool, 0x24DBB0FC, 0x9311, 0x4B3D, 0x9CF018FF155639D4ull, 2> ListenContinueOnBatteryProperty;
+// PKEY_Device_FriendlyName, eg. "Microphone (USB Audio Device)".
+typedef EndpointProperty<std::string, 0xA45C254E, 0xDF1C, 0x4EFD, 0x802067D146A850E0ull, 14> FriendlyNameProperty;
+// PKEY_Device_DeviceDesc, eg. "Microphone".
+typedef EndpointProperty<std::string, 0xA45C254E, 0xDF1C, 0x4EFD, 0x802067D146A850E0ull, 2> DeviceDescriptionProperty;
+// PKEY_DeviceInterface_FriendlyName, eg. "USB Audio Device".
+typedef EndpointProperty<std::string, 0x026E516E, 0xB814, 0x414B, 0x83CD856D6FEF4822ull, 2> InterfaceFriendlyNameProperty;
+
+/// <summary>
+/// Conversion between the property value types and EndpointPropertyValue.
+/// </summary>
+template<typename T>
+struct EndpointPropertyTraits;
+
+template<>
+struct EndpointPropertyTraits<bool>
+{
+	static inline EndpointPropertyValue ToValue(bool pValue) { return EndpointPropertyValue::FromBool(pValue); }
+	// An unset property reads as false.
+	static inline void FromValue(const EndpointPropertyValue& pValue, bool& pResult) { pResult = (pValue.type == EndpointPropertyValue::Bool && pValue.boolValue); }
+};
+
+template<>
+struct EndpointPropertyTraits<std::string>
+{
+	// An empty string is written as an empty (VT_EMPTY) value.
+	static inline EndpointPropertyValue ToValue(const std::string& pValue) { return pValue.empty() ? EndpointPropertyValue() : EndpointPropertyValue::FromString(pValue); }
+	static inline void FromValue(const EndpointPropertyValue& pValue, std::string& pResult)
+	{
+		if (pValue.type == EndpointPropertyValue::String)
+		{
+			pResult = pValue.stringValue;
+		}
+		else
+		{
+			pResult.clear();
+		}
+	}
+};
+
+/// <summary>
+/// Property store session on an endpoint: the store is opened by the first access and reused by the next ones, until Close().
+/// It is opened read-only, and reopened read-write by the first write. A disconnected store (see EndpointIsDisconnected) is closed,
+/// and the access retried once on a new one.
+/// Read<ListenEnabledProperty, ListenTargetProperty>(isListening, outputDeviceID) stops at the first failure and returns its result.
+/// Not thread-safe.
+/// </summary>
+class EndpointPropertySession
+{
+public:
+	EndpointPropertySession() : _endpoint(NULL), _store(), _readWrite(false), _result(ENDPOINT_OK), _stats(NULL) {}
+	// pStats (optional) receives the store openings (a reused store is a WAIC_CACHE_PROPERTY_STORE hit) and the Get/Set latencies.
+	explicit EndpointPropertySession(IAudioEndpoint* pEndpoint, ControllerStats* pStats = NULL)
+		: _endpoint(pEndpoint), _store(), _readWrite(false), _result(ENDPOINT_OK), _stats(pStats) {}
+
+	// Closes the store, the next access opens one on pEndpoint.
+	inline void Reset(IAudioEndpoint* pEndpoint, ControllerStats* pStats)
+	{
+		Close();
+		_endpoint = pEndpoint;
+		_stats = pStats;
+		_result = ENDPOINT_OK;
+	}
+	inline void Close()
+	{
+		_store.reset();
+		_readWrite = false;
+	}
+	inline bool IsOpen()const { return _store != NULL; }
+	inline bool IsReadWrite()const { return _store != NULL && _readWrite; }
+	// Result of the last store opening.
+	inline EndpointResult GetResult()const { return _result; }
+
+	// Opens the store if needed, or reopens it read-write. Done by the accesses.
+	EndpointResult Open(bool pReadWrite)
+	{
+		if (_store != NULL && (_readWrite || !pReadWrite))
+		{
+			if (_stats != NULL) _stats->AddCacheHit(WAIC_CACHE_PROPERTY_STORE);
+			return ENDPOINT_OK;
+		}
+		if (_stats != NULL) _stats->AddCacheMiss(WAIC_CACHE_PROPERTY_STORE);
+		if (_endpoint == NULL) return ENDPOINT_E_FAIL;
+
+		Close();
+		StatsTimer timer(_stats, WAIC_STAGE_OPEN_PROPERTY_STORE);
+		_result = _endpoint->OpenPropertyStore(pReadWrite, _store);
+		if (!EndpointSucceeded(_result))
+		{
+			_store.reset();
+			return _result;
+		}
+		_readWrite = pReadWrite;
+		return _result;
+	}
+
+	template<typename Property>
+	EndpointResult Get(typename Property::ValueType& pValue)
+	{
+		EndpointPropertyValue value;
+		EndpointResult hr = _Access(false, [&]
+		{
+			StatsTimer timer(_stats, WAIC_STAGE_GET_VALUE);
+			return _store->GetValue(Property::GetKey(), value);
+		});
+		if (EndpointSucceeded(hr))
+		{
+			EndpointPropertyTraits<typename Property::ValueType>::FromValue(value, pValue);
+		}
+		return hr;
+	}
+
+	template<typename Property>
+	EndpointResult Set(const typename Property::ValueType& pValue)
+	{
+		EndpointPropertyValue value = EndpointPropertyTraits<typename Property::ValueType>::ToValue(pValue);
+		return _Access(true, [&]
+		{
+			StatsTimer timer(_stats, WAIC_STAGE_SET_VALUE);
+			return _store->SetValue(Property::GetKey(), value);
+		});
+	}
+
+	template<typename... Properties>
+	EndpointResult Read(typename Properties::ValueType&... pValues)
+	{
+		EndpointResult hr = ENDPOINT_OK;
+		(void)(EndpointSucceeded(hr) && ... && EndpointSucceeded(hr = Get<Properties>(pValues)));
+		return hr;
+	}
+
+	// Written in order: a failure leaves the previous properties written.
+	template<typename... Properties>
+	EndpointResult Write(const typename Properties::ValueType&... pValues)
+	{
+		EndpointResult hr = ENDPOINT_OK;
+		(void)(EndpointSucceeded(hr) && ... && EndpointSucceeded(hr = Set<Properties>(pValues)));
+		return hr;
+	}
+
+private:
+	template<typename F>
+	EndpointResult _Access(bool pReadWrite, F&& pAccess)
+	{
+		EndpointResult hr = Open(pReadWrite);
+		if (!EndpointSucceeded(hr)) return hr;
+
+		hr = pAccess();
+		if (EndpointIsDisconnected(hr))
+		{
+			// Stale store: once more on a new one (fails again if the device itself is gone).
+			Close();
+			hr = Open(pReadWrite);
+			if (EndpointSucceeded(hr))
+			{
+				hr = pAccess();
+			}
+			if (EndpointIsDisconnected(hr))
+			{
+				Close();
+			}
+		}
+		return hr;
+	}
+
+private:
+	IAudioEndpoint* _endpoint;
+	std::unique_ptr<IEndpointPropertyStore> _store;
+	bool _readWrite;
+	EndpointResult _result;
+	ControllerStats* _stats;
+};
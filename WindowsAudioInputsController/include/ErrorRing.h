@@ -0,0 +1,59 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "AudioEndpointProvider.h"
+#include "WindowsAudioInputsControllerC.h"
+
+/// <summary>
+/// Fixed-capacity ring of the latest errors. Recording never allocates: records are only formatted to text when read.
+/// </summary>
+class ErrorRing
+{
+public:
+	static const int CAPACITY = 64;
+
+	ErrorRing();
+
+	// pListen: requested state for write operations, -1 otherwise.
+	void Record(WAIC_ErrorCode pCode, WAIC_Operation pOperation, EndpointResult pResult, const char* pDevice, int pListen = -1);
+
+	inline bool HasErrors()const { return _count.load(std::memory_order_acquire) > 0; }
+	// Number of errors overwritten before being drained.
+	inline uint64_t GetDroppedCount()const { return _dropped; }
+
+	// Copies the pending records, oldest first, and removes them.
+	int Drain(WAIC_ErrorRecord* pRecords, int pCapacity);
+	void Clear();
+
+	// Appends the text of pRecord (one line) to pText.
+	static void Format(const WAIC_ErrorRecord& pRecord, std::string& pText);
+
+private:
+	std::mutex _mutex;
+	WAIC_ErrorRecord _records[CAPACITY];
+	int _first;
+	std::atomic<int> _count;
+	uint64_t _sequence;
+	std::atomic<uint64_t> _dropped;
+};
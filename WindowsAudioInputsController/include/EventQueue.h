@@ -0,0 +1,60 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "WindowsAudioInputsControllerC.h"
+
+/// <summary>
+/// Bounded single-producer queue of the listen state change events. Pushing (backend thread only) is lock-free and never allocates;
+/// draining takes a lock only when there are events, so an empty queue costs two atomic loads.
+/// When full, new events are dropped (and counted): the sequence numbers of the drained events then have gaps.
+/// </summary>
+class EventQueue
+{
+public:
+	// Power of two.
+	static const uint32_t CAPACITY = 256;
+
+	EventQueue();
+
+	// Single producer. pEvent.sequence is set by the queue. Returns false if the queue is full.
+	bool Push(WAIC_Event& pEvent);
+
+	// Single producer: numbers an event delivered without the queue (eg. to a callback).
+	inline uint64_t NextSequence() { return ++_sequence; }
+
+	inline bool IsEmpty()const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+	inline uint64_t GetDroppedCount()const { return _dropped.load(std::memory_order_relaxed); }
+
+	// Any thread. Copies the pending events, oldest first, and removes them.
+	int Drain(WAIC_Event* pEvents, int pCapacity);
+
+private:
+	WAIC_Event _events[CAPACITY];
+	// Consumer position, only moved under _drainMutex.
+	std::atomic<uint32_t> _head;
+	// Producer position.
+	std::atomic<uint32_t> _tail;
+	uint64_t _sequence;
+	std::atomic<uint64_t> _dropped;
+	std::mutex _drainMutex;
+};
@@ -0,0 +1,96 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "AudioEndpointProvider.h"
+#include "WindowsAudioInputsControllerC.h"
+
+/// <summary>
+/// Input level metering: a sampler thread polls the peak level of the watched devices at a fixed rate and publishes
+/// the latest levels in seqlock-protected slots. Read() never blocks and never calls the backend.
+/// </summary>
+class LevelMeter
+{
+public:
+	static const int CAPACITY = 64;
+	static const int MIN_RATE_HZ = 1;
+	static const int MAX_RATE_HZ = 1000;
+	// The RMS is computed over the peaks sampled during the last 100 ms.
+	static const int RMS_WINDOW_MS = 100;
+
+	LevelMeter();
+	~LevelMeter();
+
+	// (Re)starts the sampler thread, which uses pProvider (InitializeThread/UninitializeThread).
+	bool Start(IAudioEndpointProvider* pProvider, int pRateHz);
+	void Stop();
+	inline bool IsRunning()const { return _thread.joinable(); }
+
+	// Takes ownership of pMeter. False if CAPACITY devices are already watched, true (pMeter left unused) if pDevice already is.
+	bool Watch(WAIC_DeviceHandle pDevice, std::unique_ptr<IEndpointMeter>& pMeter);
+	void Unwatch(WAIC_DeviceHandle pDevice);
+	// Releases the meters: must be called on a thread on which the provider is initialized.
+	void UnwatchAll();
+
+	// Any thread. Copies the latest levels of the watched devices (at most pCapacity of them).
+	int Read(WAIC_Level* pLevels, int pCapacity)const;
+
+private:
+	// Published level of a watched device. Written by the sampler thread only: odd sequence while being written.
+	struct Slot
+	{
+		std::atomic<uint32_t> sequence;
+		std::atomic<uint64_t> device;
+		std::atomic<int64_t> timestampUs;
+		std::atomic<float> peak;
+		std::atomic<float> rms;
+		std::atomic<int32_t> hresult;
+	};
+
+	// Sampler state of a watched device, under _mutex.
+	struct Watched
+	{
+		WAIC_DeviceHandle device;
+		std::unique_ptr<IEndpointMeter> meter;
+		float peaks[MAX_RATE_HZ * RMS_WINDOW_MS / 1000];
+		int peakCount;
+		int peakIndex;
+	};
+
+	void _Run(IAudioEndpointProvider* pProvider);
+	void _Sample(int pIndex, int pWindowSize, int64_t pTimestampUs);
+	void _Publish(int pIndex, WAIC_DeviceHandle pDevice, int64_t pTimestampUs, float pPeak, float pRms, int32_t pResult);
+
+private:
+	mutable std::mutex _mutex;
+	std::condition_variable _stopRequested;
+	bool _stop;
+	int _rateHz;
+	std::thread _thread;
+	Watched _watched[CAPACITY];
+	Slot _slots[CAPACITY];
+	// Number of slots to read: one past the last one used.
+	std::atomic<int> _slotCount;
+};
@@ -0,0 +1,50 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct ListenProfileEntry
+{
+	std::string endpointId;
+	bool listen;
+	// Output device endpoint id, empty for the default output device.
+	std::string listenTarget;
+};
+
+/// <summary>
+/// Versioned binary form of a listen configuration, keyed by capture endpoint id. Little-endian:
+/// header { char magic[4] = "WAIP"; uint16 version; uint16 entryCount; }
+/// entry  { uint8 listen; uint8 reserved; uint16 idLength; uint16 targetLength; char id[idLength]; char target[targetLength]; }
+/// </summary>
+class ListenProfile
+{
+public:
+	static const uint16_t VERSION = 1;
+	static const size_t MAX_ENTRIES = 0xFFFF;
+	static const size_t MAX_STRING_SIZE = 0xFFFF;
+
+	// Returns the size of the profile. It is only written when it fits in pSize bytes (pBuffer can be NULL to get the size).
+	static size_t Write(const std::vector<ListenProfileEntry>& pEntries, uint8_t* pBuffer, size_t pSize);
+	// Returns false if pBuffer is not a valid profile of a supported version.
+	static bool Read(const uint8_t* pBuffer, size_t pSize, std::vector<ListenProfileEntry>& pEntries);
+};
@@ -0,0 +1,131 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AudioEndpointProvider.h"
+
+// Backend calls of the mock, as a mask selecting the calls of a MockFault.
+enum MockCall : uint32_t
+{
+	MOCK_CALL_ENUMERATE = 1,	// EnumerateEndpoints, GetEndpointInfo, GetDefaultEndpointId.
+	MOCK_CALL_OPEN = 2,			// OpenEndpoint, OpenPropertyStore, OpenMeter, OpenStream.
+	MOCK_CALL_GET_VALUE = 4,	// Property reads, meter reads.
+	MOCK_CALL_SET_VALUE = 8,	// Property writes.
+	MOCK_CALL_ALL = 15
+};
+
+// Failure or stall injected into the matching backend calls.
+struct MockFault
+{
+	MockFault() : calls(MOCK_CALL_ALL), endpointId(), result(ENDPOINT_E_FAIL), probability(1.0), count(-1), stall(0) {}
+
+	uint32_t calls;						// MockCall mask.
+	std::string endpointId;				// Only the calls on this endpoint, any endpoint if empty (the enumeration calls have no endpoint).
+	EndpointResult result;				// Returned instead of doing the call. ENDPOINT_OK only adds the stall.
+	double probability;					// Of each matching call, drawn from the seeded generator (see SetFaultSeed).
+	int count;							// Number of injections left, unlimited if negative.
+	std::chrono::microseconds stall;	// Added to the latency of the faulty calls.
+};
+
+/// <summary>
+/// In-memory endpoint backend, used to run the controller without WASAPI (Linux CI, tests and benchmarks).
+/// Every backend call (enumeration, endpoint/store/meter opening, property get/set, meter read) sleeps for the configured latency,
+/// and can be made to fail or stall by the injected faults: with a given seed, the same sequence of calls fails the same way.
+/// </summary>
+class MockEndpointProvider : public IAudioEndpointProvider
+{
+public:
+	struct Endpoint;
+
+	MockEndpointProvider();
+	~MockEndpointProvider();
+
+	// IAudioEndpointProvider
+	EndpointResult Initialize() override;
+	EndpointResult InitializeThread() override;
+	void UninitializeThread() override;
+	EndpointResult EnumerateEndpoints(EndpointFlow pFlow, uint32_t pStateMask, std::vector<EndpointInfo>& pEndpoints) override;
+	EndpointResult GetEndpointInfo(const std::string& pEndpointId, EndpointInfo& pInfo) override;
+	EndpointResult OpenEndpoint(const std::string& pEndpointId, std::unique_ptr<IAudioEndpoint>& pEndpoint) override;
+	EndpointResult GetDefaultEndpointId(EndpointFlow pFlow, std::string& pEndpointId) override;
+	EndpointResult RegisterNotificationClient(IEndpointNotificationClient* pClient) override;
+	EndpointResult UnregisterNotificationClient(IEndpointNotificationClient* pClient) override;
+
+	// Simulation: changing the endpoints fires the matching notifications, synchronously, on the calling thread.
+	bool AddEndpoint(EndpointFlow pFlow, const std::string& pEndpointId, const std::string& pFriendlyName, uint32_t pState = ENDPOINT_STATE_ACTIVE);
+	// Adds pCount capture endpoints named "<pNamePrefix> <i>", with ids "{mock.capture.<i>}".
+	void AddCaptureEndpoints(int pCount, const std::string& pNamePrefix = "Microphone");
+	bool RemoveEndpoint(const std::string& pEndpointId);
+	bool SetEndpointState(const std::string& pEndpointId, uint32_t pState);
+	// Changes a property from "outside" (eg. from the Windows Sound panel). As with writes through a property store, it fires OnEndpointPropertyChanged.
+	bool SetEndpointProperty(const std::string& pEndpointId, const EndpointPropertyKey& pKey, const EndpointPropertyValue& pValue);
+	bool GetEndpointProperty(const std::string& pEndpointId, const EndpointPropertyKey& pKey, EndpointPropertyValue& pValue)const;
+	// Peak level returned by the meters of the endpoint (negative: synthetic level, a sine whose frequency depends on the endpoint).
+	bool SetEndpointLevel(const std::string& pEndpointId, float pPeak);
+	// Mix format of the streams opened afterwards (default: 48 kHz stereo, 16 bits for capture endpoints, float for render ones).
+	bool SetEndpointFormat(const std::string& pEndpointId, const EndpointStreamFormat& pFormat);
+	// Frames written to the render streams of the endpoint, and peak of the last written buffer.
+	bool GetRenderedFrames(const std::string& pEndpointId, uint64_t& pFrames, float& pLastPeak)const;
+
+	inline void SetLatency(std::chrono::microseconds pLatency) { _latencyUs = pLatency.count(); }
+	inline std::chrono::microseconds GetLatency()const { return std::chrono::microseconds(_latencyUs.load()); }
+	// Number of simulated backend calls since creation.
+	inline uint64_t GetCallCount()const { return _callCount; }
+	// Number of simulated property writes (SetValue calls, failed ones included) since creation.
+	inline uint64_t GetWriteCount()const { return _writeCount; }
+
+	// The first matching fault drawn is injected, in the order they were added.
+	void AddFault(const MockFault& pFault);
+	void ClearFaults();
+	void SetFaultSeed(uint64_t pSeed);
+	// Number of calls failed or stalled by the faults since creation.
+	inline uint64_t GetInjectedFaultCount()const { return _injectedFaults; }
+
+	// Used by the mock endpoints and property stores: sleeps for the latency, returns the injected failure (ENDPOINT_OK if none).
+	EndpointResult SimulateCall(MockCall pCall, const std::string* pEndpointId = NULL)const;
+	void NotifyPropertyChanged(const std::string& pEndpointId, const EndpointPropertyKey& pKey)const;
+	std::mutex& GetMutex()const { return _mutex; }
+
+private:
+	std::shared_ptr<Endpoint> _Find(const std::string& pEndpointId)const;
+	std::vector<IEndpointNotificationClient*> _GetNotificationClients()const;
+
+private:
+	mutable std::mutex _mutex;
+	std::vector<std::shared_ptr<Endpoint>> _endpoints;
+	std::unordered_map<std::string, std::shared_ptr<Endpoint>> _endpointsById;
+	std::vector<IEndpointNotificationClient*> _notificationClients;
+	std::atomic<int64_t> _latencyUs;
+	mutable std::atomic<uint64_t> _callCount;
+	mutable std::atomic<uint64_t> _writeCount;
+	// The calls only take _faultsMutex when some faults are set.
+	std::atomic<bool> _hasFaults;
+	mutable std::mutex _faultsMutex;
+	mutable std::vector<MockFault> _faults;
+	mutable std::mt19937_64 _faultRandom;
+	mutable std::atomic<uint64_t> _injectedFaults;
+};
@@ -0,0 +1,56 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "AudioEndpointProvider.h"
+
+// SSE2 kernels on x86/x64, scalar code elsewhere.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WAIC_SAMPLES_SSE2 1
+#else
+#define WAIC_SAMPLES_SSE2 0
+#endif
+
+// Channels of a monitored stream (WAIC_MONITOR_MAX_CHANNELS).
+const int SAMPLES_MAX_CHANNELS = 8;
+
+/// <summary>
+/// Converts pSampleCount interleaved samples of pType to float samples in [-1, 1].
+/// </summary>
+void ConvertToFloat(EndpointSampleType pType, const void* pInput, float* pOutput, size_t pSampleCount);
+
+/// <summary>
+/// Converts pSampleCount float samples to pType, clamped to [-1, 1] and rounded to the nearest integer value. NaN gives 0.
+/// </summary>
+void ConvertFromFloat(EndpointSampleType pType, const float* pInput, void* pOutput, size_t pSampleCount);
+
+// Same as ConvertFromFloat to Float32, in place: clamped to [-1, 1], NaN gives 0.
+void ClampSamples(float* pSamples, size_t pSampleCount);
+
+/// <summary>
+/// pOutput[frame][c] = pInput[frame][pMap[c]] * pGain, or 0 when pMap[c] is negative (or not an input channel).
+/// pInput and pOutput must not overlap.
+/// </summary>
+void MapChannels(const float* pInput, int pInputChannels, float* pOutput, int pOutputChannels, const int8_t* pMap, float pGain, size_t pFrameCount);
+
+// In place.
+void ApplyGain(float* pSamples, size_t pSampleCount, float pGain);
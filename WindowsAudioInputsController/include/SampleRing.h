@@ -0,0 +1,54 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// Lock-free single-producer single-consumer ring of float samples, between the capture and render threads of an AudioMonitor.
+/// Write() and Read() copy as much as they can and never block nor allocate.
+/// </summary>
+class SampleRing
+{
+public:
+	SampleRing();
+
+	// Not thread-safe: called before the producer and the consumer start. The capacity is rounded up to a power of two.
+	void Reset(size_t pCapacity);
+	inline size_t GetCapacity()const { return _buffer.size(); }
+
+	// Samples ready to be read.
+	inline size_t GetAvailable()const { return _writeIndex.load(std::memory_order_acquire) - _readIndex.load(std::memory_order_acquire); }
+
+	// Producer. Returns the number of samples written: less than pCount when the ring is full.
+	size_t Write(const float* pSamples, size_t pCount);
+	// Consumer. Returns the number of samples read.
+	size_t Read(float* pSamples, size_t pCount);
+	// Consumer: drops up to pCount samples.
+	size_t Skip(size_t pCount);
+
+private:
+	std::vector<float> _buffer;
+	size_t _mask;
+	// Monotonic positions (wrapped with _mask), on their own cache lines: each one is written by a single thread.
+	alignas(64) std::atomic<size_t> _writeIndex;
+	alignas(64) std::atomic<size_t> _readIndex;
+};
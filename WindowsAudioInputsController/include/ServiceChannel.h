@@ -0,0 +1,87 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Channel of the controller service when none is given.
+#define WAIC_DEFAULT_SERVICE_NAME "WindowsAudioInputsController"
+
+/// <summary>
+/// Local stream connection between a client and the controller service: a named pipe (\\.\pipe\<name>) on Windows,
+/// a Unix domain socket (/tmp/<name>.sock, or <name> if it is a path) elsewhere. Messages are framed by their size.
+/// </summary>
+class ServiceChannel
+{
+public:
+	// Larger messages are rejected (protects the service from a broken client).
+	static const uint32_t MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+
+	ServiceChannel();
+	~ServiceChannel();
+	ServiceChannel(const ServiceChannel&) = delete;
+	ServiceChannel& operator=(const ServiceChannel&) = delete;
+
+	bool Connect(const std::string& pName);
+	inline bool IsOpen()const { return _handle != INVALID_HANDLE; }
+	// Unblocks a pending read, then releases the connection.
+	void Close();
+
+	// Blocking. False if the connection is closed or broken.
+	bool WriteMessage(const std::vector<uint8_t>& pMessage);
+	bool ReadMessage(std::vector<uint8_t>& pMessage);
+
+	static std::string GetPath(const std::string& pName);
+
+private:
+	friend class ServiceListener;
+	static const intptr_t INVALID_HANDLE = -1;
+
+	bool _Write(const void* pData, size_t pSize);
+	bool _Read(void* pData, size_t pSize);
+
+private:
+	// HANDLE on Windows, file descriptor elsewhere.
+	std::atomic<intptr_t> _handle;
+};
+
+/// <summary>
+/// Service side: accepts the client connections.
+/// </summary>
+class ServiceListener
+{
+public:
+	ServiceListener();
+	~ServiceListener();
+
+	bool Listen(const std::string& pName);
+	// Blocks until a client connects. False once Close() has been called.
+	bool Accept(ServiceChannel& pChannel);
+	// Any thread: unblocks Accept().
+	void Close();
+
+private:
+	std::string _path;
+	std::atomic<bool> _closed;
+	// Listening socket (not used on Windows: each pipe instance is created by Accept()).
+	std::atomic<intptr_t> _handle;
+};
@@ -0,0 +1,76 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ErrorRing.h"
+#include "ServiceChannel.h"
+#include "ServiceProtocol.h"
+#include "WindowsAudioInputsControllerC.h"
+
+/// <summary>
+/// Client of the controller service (see ControllerService): each call is one request/response over the service channel,
+/// the batch calls send all their devices in a single request. Connects on the first call and reconnects after a failure.
+/// The errors recorded by the service for these requests are kept in this client's own ErrorRing.
+/// </summary>
+class ServiceClient
+{
+public:
+	explicit ServiceClient(const std::string& pServiceName);
+
+	// Connects now, instead of on the first call.
+	bool Connect();
+
+	bool IsListening(const char* pDeviceName);
+	bool SetListenToAudioInputDevice(const char* pDeviceName, bool pListen);
+	int SetListenToAudioInputDevices(const char* const* pDeviceNames, const bool* pListen, int pCount, bool* pResults);
+	int GetListenStates(const char* const* pDeviceNames, int pCount, bool* pIsListening, bool* pResults);
+	bool SetListenToAudioInputDeviceTarget(const char* pDeviceName, bool pListen, const char* pOutputDeviceName);
+	// Handles are the service ones: they stay valid as long as the service runs, and can be shared between its clients.
+	WAIC_DeviceHandle OpenDevice(const char* pDeviceName);
+	bool IsDeviceListening(WAIC_DeviceHandle pDevice);
+	bool SetListenToDevice(WAIC_DeviceHandle pDevice, bool pListen);
+	bool IsDeviceHandleValid(WAIC_DeviceHandle pDevice);
+	int SetListenToDevices(const WAIC_DeviceHandle* pDevices, const bool* pListen, int pCount, bool* pResults);
+	int GetDeviceListenStates(const WAIC_DeviceHandle* pDevices, int pCount, bool* pIsListening, bool* pResults);
+	bool RefreshAudioInputs();
+	int Snapshot(WAIC_DeviceSnapshot* pRecords, int pCapacity, int* pRequiredCount);
+
+	inline bool HasError()const { return _errors.HasErrors(); }
+	const char* GetErrors();
+	inline int DrainErrors(WAIC_ErrorRecord* pRecords, int pCapacity) { return _errors.Drain(pRecords, pCapacity); }
+	inline void ClearErrors() { _errors.Clear(); }
+
+private:
+	// Sends _request and receives _response. Must be called with _mutex locked.
+	bool _Send(WAIC_Operation pOperation, const char* pDevice);
+	// Reads the errors ending _response. False if the response is malformed.
+	bool _ReadErrors(MessageReader& pReader, WAIC_Operation pOperation);
+
+private:
+	std::string _serviceName;
+	std::mutex _mutex;
+	ServiceChannel _channel;
+	std::vector<uint8_t> _request;
+	std::vector<uint8_t> _response;
+	ErrorRing _errors;
+};
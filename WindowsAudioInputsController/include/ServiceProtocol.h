@@ -0,0 +1,144 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "WindowsAudioInputsControllerC.h"
+
+/// <summary>
+/// Messages exchanged with the controller service. Both ends run on the same machine, so values are written in native byte order.
+/// Request: uint32 count, then count operations (uint8 ServiceOp + arguments).
+/// Response: the results of each operation in the same order, then uint32 count + the WAIC_ErrorRecord recorded while running them.
+/// </summary>
+enum ServiceOp : uint8_t
+{
+	SERVICE_OP_IS_LISTENING = 1,			// name -> bool
+	SERVICE_OP_SET_LISTEN = 2,				// name, bool -> bool
+	SERVICE_OP_SET_LISTEN_BATCH = 3,		// uint32 n, n * (name, bool) -> int32 succeeded, n * bool
+	SERVICE_OP_GET_LISTEN_STATES = 4,		// uint32 n, n * name -> int32 succeeded, n * (bool listening, bool result)
+	SERVICE_OP_SET_LISTEN_TARGET = 5,		// name, bool, bool hasOutput, [output name] -> bool
+	SERVICE_OP_OPEN_DEVICE = 6,				// name -> uint64 handle
+	SERVICE_OP_IS_DEVICE_LISTENING = 7,		// uint64 handle -> bool
+	SERVICE_OP_SET_LISTEN_TO_DEVICE = 8,	// uint64 handle, bool -> bool
+	SERVICE_OP_REFRESH = 9,					// -> bool
+	SERVICE_OP_SNAPSHOT = 10,				// uint32 capacity -> int32 required, uint32 n, n * WAIC_DeviceSnapshot
+	SERVICE_OP_IS_DEVICE_HANDLE_VALID = 11,	// uint64 handle -> bool
+	SERVICE_OP_SET_LISTEN_TO_DEVICES = 12,	// uint32 n, n * (uint64 handle, bool) -> int32 succeeded, n * bool
+	SERVICE_OP_GET_DEVICE_LISTEN_STATES = 13	// uint32 n, n * uint64 handle -> int32 succeeded, n * (bool listening, bool result)
+};
+
+class MessageWriter
+{
+public:
+	explicit MessageWriter(std::vector<uint8_t>& pMessage) : _message(pMessage) { _message.clear(); }
+
+	template<typename T>
+	inline void Write(const T& pValue)
+	{
+		size_t offset = _message.size();
+		_message.resize(offset + sizeof(T));
+		memcpy(&_message[offset], &pValue, sizeof(T));
+	}
+
+	inline void WriteBool(bool pValue) { Write<uint8_t>(pValue ? 1 : 0); }
+
+	// NULL is written as an empty string.
+	inline void WriteString(const char* pValue)
+	{
+		uint32_t size = (pValue != NULL) ? (uint32_t)strlen(pValue) : 0;
+		Write(size);
+		_message.insert(_message.end(), (const uint8_t*)pValue, (const uint8_t*)pValue + size);
+	}
+
+private:
+	std::vector<uint8_t>& _message;
+};
+
+/// <summary>
+/// Reads a message written by MessageWriter. Reading past the end fails the reader, and then only returns zeros.
+/// </summary>
+class MessageReader
+{
+public:
+	explicit MessageReader(const std::vector<uint8_t>& pMessage) : _message(pMessage), _offset(0), _failed(false) {}
+
+	template<typename T>
+	inline T Read()
+	{
+		T value;
+		memset(&value, 0, sizeof(T));
+		if (_Take(sizeof(T)))
+		{
+			memcpy(&value, &_message[_offset - sizeof(T)], sizeof(T));
+		}
+		return value;
+	}
+
+	inline bool ReadBool() { return Read<uint8_t>() != 0; }
+
+	inline void ReadString(std::string& pValue)
+	{
+		uint32_t size = Read<uint32_t>();
+		if (_Take(size))
+		{
+			// data(): an empty string at the end of the message has no element to index.
+			pValue.assign((const char*)_message.data() + _offset - size, size);
+		}
+		else
+		{
+			pValue.clear();
+		}
+	}
+
+	// Count read from the message, bounded by the remaining bytes (each item takes at least pMinItemSize bytes).
+	inline uint32_t ReadCount(size_t pMinItemSize)
+	{
+		uint32_t count = Read<uint32_t>();
+		if (count > (_message.size() - _offset) / pMinItemSize)
+		{
+			_failed = true;
+			return 0;
+		}
+		return count;
+	}
+
+	inline bool HasFailed()const { return _failed; }
+	inline bool IsAtEnd()const { return _offset == _message.size(); }
+
+private:
+	inline bool _Take(size_t pSize)
+	{
+		if (_failed || pSize > _message.size() - _offset)
+		{
+			_failed = true;
+			return false;
+		}
+		_offset += pSize;
+		return true;
+	}
+
+private:
+	const std::vector<uint8_t>& _message;
+	size_t _offset;
+	bool _failed;
+};
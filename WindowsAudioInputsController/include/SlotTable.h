@@ -0,0 +1,131 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+/// <summary>
+/// Table of T in fixed-size chunks (never moved), addressed by handles made of the slot index and a generation.
+/// Releasing a slot bumps its generation, so that the handles still pointing to it are detected as stale.
+/// Acquire/Release must be called from a single thread, Get/IsCurrent can be called from any thread without locking.
+/// </summary>
+template<typename T>
+class SlotTable
+{
+public:
+	static const uint32_t CHUNK_SIZE = 256;
+	static const uint32_t MAX_CHUNKS = 64;
+	static const uint32_t CAPACITY = CHUNK_SIZE * MAX_CHUNKS;
+
+	SlotTable() : _chunks(), _chunkCount(0), _freeIndices()
+	{
+		for (uint32_t i = 0; i < MAX_CHUNKS; ++i)
+		{
+			_chunks[i] = NULL;
+		}
+	}
+
+	~SlotTable()
+	{
+		for (uint32_t i = 0; i < MAX_CHUNKS; ++i)
+		{
+			delete[] _chunks[i].load();
+		}
+	}
+
+	// Returns the handle of a free slot, 0 if the table is full. Its value is left as the last Release() left it.
+	uint64_t Acquire()
+	{
+		if (_freeIndices.empty() && !_AddChunk()) return 0;
+
+		uint32_t index = _freeIndices.back();
+		_freeIndices.pop_back();
+		Slot& slot = _GetSlot(index);
+		// Odd generations are live slots.
+		uint32_t generation = slot.generation.load(std::memory_order_relaxed) + 1;
+		slot.generation.store(generation, std::memory_order_release);
+		return _MakeHandle(index, generation);
+	}
+
+	void Release(uint64_t pHandle)
+	{
+		if (!IsCurrent(pHandle)) return;
+
+		uint32_t index = (uint32_t)(pHandle & 0xFFFFFFFF) - 1;
+		_GetSlot(index).generation.fetch_add(1, std::memory_order_acq_rel);
+		_freeIndices.push_back(index);
+	}
+
+	// NULL if the handle is stale. From another thread, the value may be released meanwhile: check IsCurrent() after reading it.
+	T* Get(uint64_t pHandle)const
+	{
+		Slot* slot = _FindSlot(pHandle);
+		return (slot != NULL) ? &slot->value : NULL;
+	}
+
+	inline bool IsCurrent(uint64_t pHandle)const { return _FindSlot(pHandle) != NULL; }
+
+private:
+	struct Slot
+	{
+		Slot() : generation(0), value() {}
+
+		std::atomic<uint32_t> generation;
+		T value;
+	};
+
+	static inline uint64_t _MakeHandle(uint32_t pIndex, uint32_t pGeneration) { return ((uint64_t)pGeneration << 32) | (pIndex + 1); }
+
+	inline Slot& _GetSlot(uint32_t pIndex)const { return _chunks[pIndex / CHUNK_SIZE].load(std::memory_order_relaxed)[pIndex % CHUNK_SIZE]; }
+
+	Slot* _FindSlot(uint64_t pHandle)const
+	{
+		uint32_t index = (uint32_t)(pHandle & 0xFFFFFFFF);
+		uint32_t generation = (uint32_t)(pHandle >> 32);
+		if (index == 0 || index > CAPACITY || (generation & 1) == 0) return NULL;
+
+		--index;
+		Slot* chunk = _chunks[index / CHUNK_SIZE].load(std::memory_order_acquire);
+		if (chunk == NULL) return NULL;
+
+		Slot& slot = chunk[index % CHUNK_SIZE];
+		return (slot.generation.load(std::memory_order_acquire) == generation) ? &slot : NULL;
+	}
+
+	bool _AddChunk()
+	{
+		if (_chunkCount == MAX_CHUNKS) return false;
+
+		Slot* chunk = new Slot[CHUNK_SIZE];
+		// Lowest indices are acquired first.
+		for (uint32_t i = CHUNK_SIZE; i > 0; --i)
+		{
+			_freeIndices.push_back(_chunkCount * CHUNK_SIZE + i - 1);
+		}
+		_chunks[_chunkCount++].store(chunk, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::atomic<Slot*> _chunks[MAX_CHUNKS];
+	uint32_t _chunkCount;
+	std::vector<uint32_t> _freeIndices;
+};
@@ -0,0 +1,51 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include "AudioEndpointProvider.h"
+
+struct IMMDeviceEnumerator;
+class WasapiNotificationClient;
+
+/// <summary>
+/// Endpoint backend built on top of the Windows Core Audio API (IMMDeviceEnumerator / IMMDevice / IPropertyStore).
+/// </summary>
+class WasapiEndpointProvider : public IAudioEndpointProvider
+{
+public:
+	WasapiEndpointProvider();
+	~WasapiEndpointProvider();
+
+	EndpointResult Initialize() override;
+	// Joins the multithreaded apartment.
+	EndpointResult InitializeThread() override;
+	void UninitializeThread() override;
+	EndpointResult EnumerateEndpoints(EndpointFlow pFlow, uint32_t pStateMask, std::vector<EndpointInfo>& pEndpoints) override;
+	EndpointResult GetEndpointInfo(const std::string& pEndpointId, EndpointInfo& pInfo) override;
+	EndpointResult OpenEndpoint(const std::string& pEndpointId, std::unique_ptr<IAudioEndpoint>& pEndpoint) override;
+	EndpointResult GetDefaultEndpointId(EndpointFlow pFlow, std::string& pEndpointId) override;
+	EndpointResult RegisterNotificationClient(IEndpointNotificationClient* pClient) override;
+	EndpointResult UnregisterNotificationClient(IEndpointNotificationClient* pClient) override;
+
+private:
+	bool _comInitialized;
+	IMMDeviceEnumerator* _deviceEnumerator;
+	// One IMMNotificationClient per registered client.
+	std::vector<WasapiNotificationClient*> _notificationClients;
+};
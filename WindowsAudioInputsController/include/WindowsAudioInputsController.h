@@ -18,46 +18,482 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
 
-struct IMMDevice;
-struct IMMDeviceEnumerator;
+#include "AudioEndpointProvider.h"
+#include "AudioMonitor.h"
+#include "BackendThread.h"
+#include "CallPolicy.h"
+#include "ControllerStats.h"
+#include "EndpointProperties.h"
+#include "ErrorRing.h"
+#include "EventQueue.h"
+#include "LevelMeter.h"
+#include "SlotTable.h"
 
+class AudioDeviceDirectory;
+class WorkerPool;
+
+/// <summary>
+/// Audio input opened by name. Instances live in the SlotTable of the controller: they are opened and closed in place.
+/// </summary>
 class WindowsAudioInput
 {
-private:
-	WindowsAudioInput(IMMDevice* pAudioDevice);
-
 public:
+	WindowsAudioInput();
 	~WindowsAudioInput();
-	static WindowsAudioInput* Create(IMMDeviceEnumerator* pDeviceEnumerator, const char* pDeviceName);
 
-	bool IsListening(bool& pIsListening)const;
-	bool SetListen(bool pListen);
+	// pPropertyReads counts the property reads done when the cached listen state is unknown, pStats (optional) receives the backend latencies.
+	// pPolicy (optional) retries the failed property accesses, this device having its own circuit breaker.
+	EndpointResult Open(IAudioEndpointProvider* pProvider, const std::string& pEndpointId, const char* pName, std::atomic<uint64_t>* pPropertyReads,
+		ControllerStats* pStats, CallPolicy* pPolicy);
+	void Close();
+	inline bool IsOpen()const { return _audioEndpoint != NULL; }
+
+	// Served from the pending or cached listen state; the properties are only read when it is unknown.
+	EndpointResult IsListening(bool& pIsListening)const;
+	// Output device id of the "Listen to Device" setting (empty for the default output device).
+	EndpointResult GetListenTarget(std::string& pOutputDeviceID)const;
+	// From the cached state only: false if unknown, pending or different.
+	bool MatchesListenState(bool pListen, const std::string& pOutputDeviceID)const;
+	// Last read or written state, ignoring the pending one. False if unknown.
+	bool GetCachedListenState(bool& pListen, std::string& pOutputDeviceID)const;
+	// "Continue running when on battery power" listen setting. Not cached: each call reads or writes the property (through the property session).
+	EndpointResult GetContinueOnBattery(bool& pContinueOnBattery)const;
+	EndpointResult SetContinueOnBattery(bool pContinueOnBattery);
+	// Metering mode: the meter is sampled by the LevelMeter of the controller, and can outlive this input.
+	EndpointResult OpenMeter(std::unique_ptr<IEndpointMeter>& pMeter)const;
+	// Monitor mode: capture stream of the device (see IAudioEndpoint::OpenStream).
+	EndpointResult OpenStream(uint32_t pBufferUs, std::unique_ptr<IEndpointStream>& pStream)const;
+	// Copies the cached output device id (truncated), without allocating. Empty if unknown or default.
+	void CopyListenTarget(char* pBuffer, size_t pSize)const;
+	// pOutputDeviceID is the render endpoint to listen with (empty for the default output device).
+	// Returns ENDPOINT_S_FALSE without writing when the device is known to already be in the requested state. Discards the pending state.
+	EndpointResult SetListen(bool pListen, const std::string& pOutputDeviceID);
+
+	// Write coalescing: the requested state is only written by CommitPendingListen(), the previous pending one being dropped.
+	// Returns true if a pending state has been replaced.
+	bool SetPendingListen(bool pListen, const std::string& pOutputDeviceID);
+	// Writes the pending state, if any (ENDPOINT_S_FALSE otherwise, or if the write was not needed).
+	EndpointResult CommitPendingListen();
+	inline bool HasPendingListen()const { return _pendingListenState.load(std::memory_order_acquire) != LISTEN_STATE_UNKNOWN; }
+
+	// Reads the listen properties again (eg. after they have been changed outside of the controller).
+	EndpointResult RefreshListenState()const;
+	// True if a listen property notification is the echo of a write made through this device within the last OWN_WRITE_ECHO_MS:
+	// the written state is already cached, so it does not need to be read again.
+	bool ConsumeOwnWriteNotification();
+	// The next property access opens a new store.
+	void ClosePropertySession();
+	inline void InvalidateListenState() { _listenState = LISTEN_STATE_UNKNOWN; }
+	inline bool IsListenStateKnown()const { return HasPendingListen() || _listenState.load(std::memory_order_acquire) != LISTEN_STATE_UNKNOWN; }
+	// Never calls the backend: false if the listen state is unknown.
+	inline bool TryGetCachedListenState(bool& pIsListening)const
+	{
+		uint8_t listenState = _pendingListenState.load(std::memory_order_acquire);
+		if (listenState == LISTEN_STATE_UNKNOWN)
+		{
+			listenState = _listenState.load(std::memory_order_acquire);
+		}
+		pIsListening = (listenState == LISTEN_STATE_ON);
+		return listenState != LISTEN_STATE_UNKNOWN;
+	}
+
+	inline const std::string& GetEndpointId()const { return _audioEndpoint->GetId(); }
+	// Name used to open the device (truncated to WAIC_DEVICE_NAME_SIZE).
+	inline const char* GetName()const { return _name; }
 
 private:
-	IMMDevice* _audioDevice;
+	enum ListenState : uint8_t
+	{
+		LISTEN_STATE_UNKNOWN,
+		LISTEN_STATE_OFF,
+		LISTEN_STATE_ON
+	};
+
+	// A notification is received for each listen property written.
+	static const int OWN_WRITE_ECHO_MS = 1000;
+
+	void _CacheListenState(bool pListen, const std::string& pOutputDeviceID)const;
+	void _ExpectOwnWriteNotifications(int pCount);
+	EndpointResult _WriteListen(bool pListen, const std::string& pOutputDeviceID);
+	// Runs pAccess (using _properties) under the properties lock and the call policy.
+	template<typename F>
+	EndpointResult _AccessProperties(F&& pAccess)const
+	{
+		std::lock_guard<std::mutex> lock(_propertiesMutex);
+		return (_policy != NULL) ? _policy->Run(_breaker, pAccess) : pAccess();
+	}
+
+private:
+	IAudioEndpoint* _audioEndpoint;
+	std::atomic<uint64_t>* _propertyReads;
+	ControllerStats* _stats;
+	CallPolicy* _policy;
+	// Property store of the endpoint, opened on first use and kept until Close(). The same device may be used by several batch workers.
+	mutable std::mutex _propertiesMutex;
+	mutable EndpointPropertySession _properties;
+	// Under _propertiesMutex, like the session.
+	mutable CircuitBreaker _breaker;
+	mutable std::atomic<uint8_t> _listenState;
+	// LISTEN_STATE_UNKNOWN when no write is pending.
+	std::atomic<uint8_t> _pendingListenState;
+	mutable std::mutex _listenTargetMutex;
+	mutable std::string _listenTarget;
+	std::string _pendingListenTarget;
+	// Notifications still expected from the writes made through this device, and the time of the last one.
+	std::atomic<int> _ownWriteNotifications;
+	std::atomic<int64_t> _ownWriteTimeNs;
+	char _name[WAIC_DEVICE_NAME_SIZE];
 };
 
-class WindowsAudioInputsController
+/// <summary>
+/// Thread-safe: every backend call runs on a dedicated worker thread (a COM MTA thread on Windows), the public methods only submit to it.
+/// IsListening() is served on the calling thread when the cached listen state is up to date.
+/// </summary>
+class WindowsAudioInputsController : private IEndpointNotificationClient
 {
 public:
-	WindowsAudioInputsController();
+	struct InitOptions
+	{
+		InitOptions() : prewarmDeviceNames(), async(false), failFast(false) {}
+
+		// Opened, with their listen state read, once the endpoints are enumerated.
+		std::vector<std::string> prewarmDeviceNames;
+		// The constructor returns without waiting for the initialization (see IsReady/WaitReady).
+		bool async;
+		// Until ready, the calls fail with WAIC_ERROR_NOT_READY instead of waiting for the initialization.
+		bool failFast;
+	};
+
+	// Uses the default endpoint provider of the platform.
+	WindowsAudioInputsController(const InitOptions& pOptions = InitOptions());
+	// Takes ownership of pProvider.
+	WindowsAudioInputsController(IAudioEndpointProvider* pProvider, const InitOptions& pOptions = InitOptions());
 	~WindowsAudioInputsController();
 
-	inline bool HasError()const { return _hasError; }
-	inline const char* GetErrors()const { return _errorsLog.c_str(); }
+	// Initialized, and the prewarm devices resolved.
+	inline bool IsReady()const { return _initState.load(std::memory_order_acquire) == InitState::Ready; }
+	// pTimeoutMs < 0 waits without limit. Returns false on timeout, or if the initialization failed.
+	bool WaitReady(int pTimeoutMs);
+
+	inline bool HasError()const { return _errors.HasErrors(); }
+	// Formats the pending errors and removes them. The text is valid until the next call on the same thread.
+	const char* GetErrors();
+	inline int DrainErrors(WAIC_ErrorRecord* pRecords, int pCapacity) { return _errors.Drain(pRecords, pCapacity); }
+	inline void ClearErrors() { _errors.Clear(); }
 	
 	bool IsListening(const char* pDeviceName);
 	bool SetListenToAudioInputDevice(const char* pDeviceName, bool pListen);
+	// Batched versions: devices are resolved once, then their backend calls run in parallel on a worker pool sized to the batch (up to 32 at once).
+	// pResults[i] (optional) receives the result for pDeviceNames[i]. Return the number of succeeded devices.
+	int SetListenToAudioInputDevices(const char* const* pDeviceNames, const bool* pListen, int pCount, bool* pResults);
+	int GetListenStates(const char* const* pDeviceNames, int pCount, bool* pIsListening, bool* pResults);
+	// Re-enumerates the audio inputs (the notifications already keep them up to date: only needed after missed ones).
+	bool RefreshAudioInputs();
+	// Copies the active audio inputs and their listen state. pRequiredCount (optional) receives the number of audio inputs.
+	int Snapshot(WAIC_DeviceSnapshot* pRecords, int pCapacity, int* pRequiredCount);
+	// Binary listen configuration, keyed by endpoint id. Save returns the profile size (written only if it fits in pSize bytes),
+	// Restore writes only the devices differing from the profile and returns how many were written (-1 if the profile is invalid).
+	int SaveListenProfile(void* pBuffer, int pSize);
+	int RestoreListenProfile(const void* pBuffer, int pSize);
+
+	// Handle versions: the device is resolved once by OpenDevice(), then the calls do no lookup nor allocation.
+	WAIC_DeviceHandle OpenDevice(const char* pDeviceName);
+	// Pattern or endpoint id matching, against the name index of the capture directory.
+	WAIC_DeviceHandle OpenDeviceMatching(const char* pPattern, WAIC_MatchMode pMode);
+	bool GetMatchingDeviceName(const char* pPattern, WAIC_MatchMode pMode, char* pName, int pSize);
+	inline bool IsDeviceHandleValid(WAIC_DeviceHandle pDevice)const { return _devices.IsCurrent(pDevice); }
+	bool IsDeviceListening(WAIC_DeviceHandle pDevice);
+	bool SetListenToDevice(WAIC_DeviceHandle pDevice, bool pListen);
+	int SetListenToDevices(const WAIC_DeviceHandle* pDevices, const bool* pListen, int pCount, bool* pResults);
+	int GetDeviceListenStates(const WAIC_DeviceHandle* pDevices, int pCount, bool* pIsListening, bool* pResults);
+	bool GetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool& pContinueOnBattery);
+	bool SetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool pContinueOnBattery);
+
+	// Listen with a given output device (pOutputDeviceName NULL/empty or pOutput WAIC_INVALID_DEVICE for the default one).
+	// Output devices are resolved from a render endpoints index, kept up to date by the endpoint notifications.
+	WAIC_OutputHandle OpenOutputDevice(const char* pOutputDeviceName);
+	inline bool IsOutputHandleValid(WAIC_OutputHandle pOutput)const { return _outputDevices.IsCurrent(pOutput); }
+	bool SetListenToAudioInputDeviceTarget(const char* pDeviceName, bool pListen, const char* pOutputDeviceName);
+	bool SetListenToDeviceTarget(WAIC_DeviceHandle pDevice, bool pListen, WAIC_OutputHandle pOutput);
+
+	// Asynchronous versions: return a ticket (0 if the request could not be queued), the result is given to pCallback or to PollTicket().
+	uint64_t IsListeningAsync(const char* pDeviceName, WAIC_Callback pCallback, void* pUserData);
+	uint64_t SetListenToAudioInputDeviceAsync(const char* pDeviceName, bool pListen, WAIC_Callback pCallback, void* pUserData);
+	WAIC_TicketStatus PollTicket(uint64_t pTicket, bool* pSuccess, bool* pValue);
+
+	// Bounded versions: past pTimeoutMs, the caller stops waiting and WAIC_ERROR_TIMEOUT is recorded (0: no limit).
+	bool IsListeningWithTimeout(const char* pDeviceName, int pTimeoutMs);
+	bool SetListenToAudioInputDeviceWithTimeout(const char* pDeviceName, bool pListen, int pTimeoutMs);
+	// Timeout of IsListening, SetListenToAudioInputDevice, IsDeviceListening and SetListenToDevice (0: no limit).
+	inline void SetCallTimeout(int pMilliseconds) { _callTimeoutMs = (pMilliseconds > 0) ? pMilliseconds : 0; }
+	// Retries and circuit breakers of the property accesses (see CallPolicy).
+	inline void SetRetryPolicy(int pMaxAttempts, int pInitialBackoffMs, int pMaxBackoffMs) { _callPolicy.SetRetry(pMaxAttempts, pInitialBackoffMs, pMaxBackoffMs); }
+	inline void SetCircuitBreaker(int pFailureThreshold, int pCooldownMs) { _callPolicy.SetCircuitBreaker(pFailureThreshold, pCooldownMs); }
+
+	// Number of "Listen" property reads done because the cached state was unknown or has been changed outside of the controller.
+	inline uint64_t GetListenStateReads()const { return _listenStateReads; }
+
+	// Single device writes are delayed by up to pMilliseconds, only the last requested state of a device being written (0: written immediately).
+	inline void SetWriteCoalescingWindow(int pMilliseconds) { _writeCoalescingWindowMs = (pMilliseconds > 0) ? pMilliseconds : 0; }
+	// Number of writes not sent to the backend: already in the requested state, or superseded by a later request.
+	inline uint64_t GetSavedWrites()const { return _savedWrites; }
+
+	// Changes seen through the endpoint notifications (see WAIC_Event).
+	inline int DrainEvents(WAIC_Event* pEvents, int pCapacity) { return _events.Drain(pEvents, pCapacity); }
+	void SetEventCallback(WAIC_EventCallback pCallback, void* pUserData);
+	inline uint64_t GetDroppedEventCount()const { return _events.GetDroppedCount(); }
+
+	// Level metering (see LevelMeter): the levels are read without calling the backend.
+	bool StartLevelMetering(int pRateHz);
+	inline void StopLevelMetering() { _levelMeter.Stop(); }
+	bool WatchDeviceLevels(WAIC_DeviceHandle pDevice, bool pWatch);
+	inline int ReadLevels(WAIC_Level* pLevels, int pCapacity)const { return _levelMeter.Read(pLevels, pCapacity); }
+
+	// Software monitor of a device (see AudioMonitor). pOutput: WAIC_INVALID_DEVICE for the default output device.
+	bool StartMonitor(WAIC_DeviceHandle pDevice, WAIC_OutputHandle pOutput, int pBufferMs);
+	bool StopMonitor(WAIC_DeviceHandle pDevice);
+	bool SetMonitorGain(WAIC_DeviceHandle pDevice, float pGain);
+	bool SetMonitorChannelMap(WAIC_DeviceHandle pDevice, const int* pMap, int pCount);
+	bool GetMonitorStats(WAIC_DeviceHandle pDevice, WAIC_MonitorStats& pStats);
+
+	// Backend stages latencies and cache counters (see WAIC_ENABLE_STATS).
+	inline void GetStats(WAIC_Stats& pStats)const { _stats.Read(pStats); }
+	// JSON version of GetStats. The text is valid until the next call on the same thread.
+	const char* GetStatsJson()const;
+	inline void ResetStats() { _stats.Reset(); }
 
 private:
-	WindowsAudioInput* _GetOrCreate(const char* pDeviceName);
+	struct EndpointNotification
+	{
+		enum Type
+		{
+			Added,
+			Removed,
+			StateChanged,
+			ListenPropertyChanged
+		};
+		Type type;
+		std::string endpointId;
+	};
+
+	// Pending asynchronous request. The slots are preallocated, a ticket is made of the slot index and its generation.
+	// Timed calls use them too: their caller waits for the completion until the deadline, then abandons the request.
+	struct AsyncRequest : BackendThread::Request
+	{
+		enum State : uint32_t
+		{
+			Free,
+			Queued,
+			Done,
+			// Timed call given up by its caller: skipped if not started yet, released by the backend thread.
+			Abandoned
+		};
+
+		void Execute() override;
+
+		WindowsAudioInputsController* controller;
+		std::atomic<uint32_t> state;
+		std::atomic<uint32_t> generation;
+		WAIC_Operation operation;
+		// Device handle, or WAIC_INVALID_DEVICE to use deviceName.
+		WAIC_DeviceHandle device;
+		char deviceName[WAIC_DEVICE_NAME_SIZE];
+		bool listen;
+		bool timed;
+		// Of the policy calls made by the request (time_point::max() if not timed).
+		std::chrono::steady_clock::time_point deadline;
+		WAIC_Callback callback;
+		void* userData;
+		bool success;
+		bool value;
+	};
+
+	// Applies the queued notifications on the backend thread, as soon as they are received.
+	struct NotificationsRequest : BackendThread::Request
+	{
+		void Execute() override;
+
+		WindowsAudioInputsController* controller;
+	};
+
+	// Resolves one prewarm device, then submits itself again for the next one: the calls submitted meanwhile are not delayed by the whole list.
+	struct PrewarmRequest : BackendThread::Request
+	{
+		void Execute() override;
+
+		WindowsAudioInputsController* controller;
+		size_t next;
+	};
+
+	enum class InitState : uint8_t
+	{
+		Initializing,
+		Ready,
+		Failed
+	};
+
+	static const int ASYNC_REQUESTS_CAPACITY = 256;
+
+	// IEndpointNotificationClient: only queues the notification, it is applied on the backend thread.
+	void OnEndpointAdded(const std::string& pEndpointId) override;
+	void OnEndpointRemoved(const std::string& pEndpointId) override;
+	void OnEndpointStateChanged(const std::string& pEndpointId, uint32_t pNewState) override;
+	void OnEndpointPropertyChanged(const std::string& pEndpointId, const EndpointPropertyKey& pKey) override;
+	void _QueueNotification(EndpointNotification::Type pType, const std::string& pEndpointId);
+
+	void _Start(const InitOptions& pOptions);
+	void _SetInitState(InitState pState);
+	// Runs pFunction on the backend thread. In fail-fast mode, fails with WAIC_ERROR_NOT_READY while initializing.
+	template<typename F>
+	void _Call(WAIC_Operation pOperation, F&& pFunction)
+	{
+		if (_failFast && _initState.load(std::memory_order_acquire) == InitState::Initializing)
+		{
+			_errors.Record(WAIC_ERROR_NOT_READY, pOperation, 0, NULL);
+			return;
+		}
+		_backendThread.Call(std::forward<F>(pFunction));
+	}
+
+	// Executed on the backend thread.
+	void _Init();
+	// Returns false once all the prewarm devices are resolved.
+	bool _PrewarmNext();
+	void _Shutdown();
+	bool _IsListening(const char* pDeviceName, bool& pIsListening);
+	bool _SetListenToAudioInputDevice(const char* pDeviceName, bool pListen);
+	int _SetListenToAudioInputDevices(const char* const* pDeviceNames, const bool* pListen, int pCount, bool* pResults);
+	int _GetListenStates(const char* const* pDeviceNames, int pCount, bool* pIsListening, bool* pResults);
+	bool _RefreshAudioInputs();
+	int _Snapshot(WAIC_DeviceSnapshot* pRecords, int pCapacity, int* pRequiredCount);
+	int _SaveListenProfile(void* pBuffer, int pSize);
+	int _RestoreListenProfile(const void* pBuffer, int pSize);
+	// Opens the first pCount endpoints of the capture directory into _snapshotAudioInputs and reads their unknown listen states.
+	void _OpenCaptureEndpoints(int pCount, WAIC_Operation pOperation);
+	bool _IsDeviceListening(WAIC_DeviceHandle pDevice, bool& pIsListening);
+	bool _SetListenToDevice(WAIC_DeviceHandle pDevice, bool pListen);
+	bool _GetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool& pContinueOnBattery);
+	bool _SetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool pContinueOnBattery);
+	bool _WatchDeviceLevels(WAIC_DeviceHandle pDevice, bool pWatch);
+	bool _StartMonitor(WAIC_DeviceHandle pDevice, WAIC_OutputHandle pOutput, int pBufferMs);
+	// NULL (and records an error) if the device handle is invalid, or if pRecordNotMonitored and the device is not monitored.
+	AudioMonitor* _GetMonitor(WAIC_DeviceHandle pDevice, bool pRecordNotMonitored);
+	bool _SetListenToAudioInputDeviceTarget(const char* pDeviceName, bool pListen, const char* pOutputDeviceName);
+	bool _SetListenToDeviceTarget(WAIC_DeviceHandle pDevice, bool pListen, WAIC_OutputHandle pOutput);
+	int _SetListenToDevices(const WAIC_DeviceHandle* pDevices, const bool* pListen, int pCount, bool* pResults);
+	int _GetDeviceListenStates(const WAIC_DeviceHandle* pDevices, int pCount, bool* pIsListening, bool* pResults);
+	// Record the errors of the single device calls, pAudioInput is NULL for an unresolved device.
+	bool _ReadListenState(WindowsAudioInput* pAudioInput, bool& pIsListening);
+	bool _WriteListenState(WindowsAudioInput* pAudioInput, bool pListen, const std::string& pOutputDeviceID);
+	// Writes now, or queues the write when coalescing is enabled.
+	bool _SetListen(WAIC_DeviceHandle pDevice, WindowsAudioInput* pAudioInput, bool pListen, const std::string& pOutputDeviceID);
+	void _CommitPendingWrites();
+	// Common part of the batched calls, pAudioInputs[i] is NULL for the unresolved devices.
+	// pOutputDeviceIDs (optional) gives the listen target of each device, the default output device otherwise.
+	int _SetListenBatch(const std::vector<WindowsAudioInput*>& pAudioInputs, const bool* pListen, const std::string* pOutputDeviceIDs,
+		bool* pResults, WAIC_Operation pOperation);
+	int _GetListenStatesBatch(const std::vector<WindowsAudioInput*>& pAudioInputs, bool* pIsListening, bool* pResults, WAIC_Operation pOperation);
+	void _ApplyNotifications();
+	void _ReleaseAudioInputs(const std::string& pEndpointId);
+	// Raises the listen/target changed events of the opened devices. Returns false if their states were not read (echo of their own writes).
+	bool _RefreshListenStates(const std::string& pEndpointId);
+	// pAudioInput/pDevice: opened device, or NULL/WAIC_INVALID_DEVICE.
+	void _RaiseEvent(WAIC_EventType pType, const EndpointInfo* pEndpoint, const WindowsAudioInput* pAudioInput, WAIC_DeviceHandle pDevice);
+	WAIC_DeviceHandle _Open(const char* pDeviceName, WAIC_Operation pOperation);
+	WAIC_DeviceHandle _OpenMatching(const char* pPattern, WAIC_MatchMode pMode, WAIC_Operation pOperation);
+	// Opens pEndpoint (an endpoint of the valid _audioInputsDirectory) under its name, or under its endpoint id when another endpoint
+	// has the same name. No allocation once opened.
+	WAIC_DeviceHandle _OpenByEndpoint(const EndpointInfo& pEndpoint, WAIC_Operation pOperation);
+	// Opens pEndpointId and registers it in _audioInputs under pKey.
+	WAIC_DeviceHandle _OpenEndpoint(const std::string& pKey, const std::string& pEndpointId, const char* pName, WAIC_Operation pOperation);
+	inline WindowsAudioInput* _GetOrCreate(const char* pDeviceName, WAIC_Operation pOperation) { return _devices.Get(_Open(pDeviceName, pOperation)); }
+	WindowsAudioInput* _Resolve(WAIC_DeviceHandle pDevice, WAIC_Operation pOperation);
+	WAIC_OutputHandle _OpenOutput(const char* pOutputDeviceName, WAIC_Operation pOperation);
+	void _ReleaseOutputDevices(const std::string& pEndpointId);
+	// Grows the pool to run pBatchSize calls at once (up to a cap).
+	WorkerPool* _GetWorkerPool(int pBatchSize);
+
+	// Any thread.
+	bool _TryGetCachedListenState(const char* pDeviceName, bool& pIsListening);
+	bool _TryGetCachedListenState(WAIC_DeviceHandle pDevice, bool& pIsListening);
+	uint64_t _SubmitAsync(WAIC_Operation pOperation, const char* pDeviceName, bool pListen, WAIC_Callback pCallback, void* pUserData);
+	// Reserves a free request slot (Queued state, new generation), NULL if all are in use.
+	AsyncRequest* _AcquireAsyncRequest();
+	/// <summary>
+	/// Runs pOperation (WAIC_OP_IS_LISTENING or WAIC_OP_SET_LISTEN) on pDevice, or pDeviceName if WAIC_INVALID_DEVICE, waiting at most pTimeoutMs.
+	/// pValue receives the listen state read. Returns false on failure or timeout (WAIC_ERROR_TIMEOUT recorded).
+	/// </summary>
+	bool _CallWithTimeout(WAIC_Operation pOperation, const char* pDeviceName, WAIC_DeviceHandle pDevice, bool pListen, int pTimeoutMs, bool& pValue);
+	// Backend thread: publishes the result of a timed call, or releases its slot if abandoned.
+	void _CompleteTimedCall(AsyncRequest& pRequest);
 
 private:
-	bool _hasError;
-	std::string _errorsLog;
-	IMMDeviceEnumerator* _deviceEnumerator;
-	std::map<std::string, WindowsAudioInput*> _audioInputs;
+	ErrorRing _errors;
+	ControllerStats _stats;
+	IAudioEndpointProvider* _provider;
+	std::atomic<bool> _providerReady;
+	std::atomic<InitState> _initState;
+	std::mutex _initStateMutex;
+	std::condition_variable _initStateChanged;
+	bool _failFast;
+	std::vector<std::string> _prewarmDeviceNames;
+	PrewarmRequest _prewarmRequest;
+	// Set when terminating: the remaining prewarm devices are skipped.
+	std::atomic<bool> _prewarmCancelled;
+	bool _notificationsRegistered;
+	AudioDeviceDirectory* _audioInputsDirectory;
+	AudioDeviceDirectory* _outputsDirectory;
+	std::atomic<bool> _hasNotifications;
+	std::mutex _notificationsMutex;
+	std::vector<EndpointNotification> _notifications;
+	std::atomic<bool> _notificationsScheduled;
+	NotificationsRequest _notificationsRequest;
+	std::atomic<uint64_t> _listenStateReads;
+	std::atomic<int> _writeCoalescingWindowMs;
+	CallPolicy _callPolicy;
+	std::atomic<int> _callTimeoutMs;
+	// Completion of the timed calls, which their callers wait for.
+	std::mutex _timedCallsMutex;
+	std::condition_variable _timedCallDone;
+	// Devices with a pending (coalesced) write, committed by the backend thread timer.
+	std::vector<WAIC_DeviceHandle> _pendingWrites;
+	std::atomic<uint64_t> _savedWrites;
+	EventQueue _events;
+	// Its meters are opened and released on the backend thread, its sampler thread is stopped before the backend.
+	LevelMeter _levelMeter;
+	// Monitored devices, only used on the backend thread: their streams are opened and released on it.
+	std::map<WAIC_DeviceHandle, std::unique_ptr<AudioMonitor>> _monitors;
+	// Only used on the backend thread.
+	WAIC_EventCallback _eventCallback;
+	void* _eventCallbackUserData;
+	typedef std::map<std::string, WAIC_DeviceHandle, std::less<>> AudioInputsMap;
+	// Opened devices by name. Only modified on the backend thread, under the exclusive lock: other threads read it under the shared lock.
+	std::shared_mutex _audioInputsMutex;
+	AudioInputsMap _audioInputs;
+	// The same devices by endpoint id (an endpoint may be opened under its name and under its id). Only used on the backend thread.
+	std::unordered_multimap<std::string, AudioInputsMap::iterator> _audioInputsByEndpointId;
+	// Only acquired/released on the backend thread.
+	SlotTable<WindowsAudioInput> _devices;
+	// Opened output devices (render endpoint ids), only used on the backend thread.
+	std::map<std::string, WAIC_OutputHandle, std::less<>> _outputs;
+	SlotTable<std::string> _outputDevices;
+	WorkerPool* _workerPool;
+	// Reused by Snapshot(), so that it does not allocate once its capacity is reached.
+	std::vector<WindowsAudioInput*> _snapshotAudioInputs;
+	std::vector<WindowsAudioInput*> _snapshotUnknownStates;
+	AsyncRequest _asyncRequests[ASYNC_REQUESTS_CAPACITY];
+	std::atomic<uint32_t> _asyncCursor;
+	// Last member: started once everything else is constructed, stopped first.
+	BackendThread _backendThread;
 };
\ No newline at end of file
@@ -18,28 +18,480 @@
 
 #pragma once
 
-#ifdef WAIC_EXPORTS
+#if defined(WAIC_STATIC)
+#define WAIC_API
+#elif !defined(_WIN32)
+#define WAIC_API __attribute__((visibility("default")))
+#elif defined(WAIC_EXPORTS)
 #define WAIC_API __declspec(dllexport)
 #else
 #define WAIC_API __declspec(dllimport)
 #endif
 
+#include <stdint.h>
+
+#define WAIC_DEVICE_NAME_SIZE 128
+#define WAIC_ENDPOINT_ID_SIZE 128
+#define WAIC_INVALID_DEVICE 0
+#define WAIC_STATS_BUCKETS 32
+#define WAIC_MONITOR_MAX_CHANNELS 8
+
+class IAudioEndpointProvider;
+
 extern "C"
 {
-	// Must be called first, before any other call.
+	enum WAIC_ErrorCode
+	{
+		WAIC_ERROR_INIT_FAILED = 1,
+		WAIC_ERROR_NOT_INITIALIZED = 2,
+		WAIC_ERROR_DEVICE_NOT_FOUND = 3,
+		WAIC_ERROR_READ_FAILED = 4,
+		WAIC_ERROR_WRITE_FAILED = 5,
+		WAIC_ERROR_ENUMERATION_FAILED = 6,
+		WAIC_ERROR_INVALID_HANDLE = 7,
+		WAIC_ERROR_TOO_MANY_DEVICES = 8,
+		WAIC_ERROR_OUTPUT_NOT_FOUND = 9,
+		WAIC_ERROR_INVALID_PROFILE = 10,
+		WAIC_ERROR_NOT_READY = 11,
+		WAIC_ERROR_SERVICE_UNAVAILABLE = 12,	// Client mode: the controller service could not be reached.
+		WAIC_ERROR_TIMEOUT = 13,				// The call did not complete within its timeout (see SetCallTimeout).
+		WAIC_ERROR_CIRCUIT_OPEN = 14			// Rejected without calling the backend: the device failed too often lately (see SetCircuitBreaker).
+	};
+
+	enum WAIC_Operation
+	{
+		WAIC_OP_INIT = 1,
+		WAIC_OP_IS_LISTENING = 2,
+		WAIC_OP_SET_LISTEN = 3,
+		WAIC_OP_GET_LISTEN_STATES = 4,
+		WAIC_OP_SET_LISTEN_BATCH = 5,
+		WAIC_OP_REFRESH = 6,
+		WAIC_OP_OPEN_DEVICE = 7,
+		WAIC_OP_OPEN_OUTPUT = 8,
+		WAIC_OP_SET_LISTEN_TARGET = 9,
+		WAIC_OP_SNAPSHOT = 10,
+		WAIC_OP_SAVE_PROFILE = 11,
+		WAIC_OP_RESTORE_PROFILE = 12,
+		WAIC_OP_CONTINUE_ON_BATTERY = 13,
+		WAIC_OP_LEVEL_METERING = 14,
+		WAIC_OP_MONITOR = 15
+	};
+
+	// Opened audio input, made of a slot index and a generation. WAIC_INVALID_DEVICE (0) is never a valid handle.
+	typedef uint64_t WAIC_DeviceHandle;
+	// Opened audio output (render endpoint), used as a "Listen to Device" target. WAIC_INVALID_DEVICE stands for the default output device.
+	typedef uint64_t WAIC_OutputHandle;
+
+	struct WAIC_ErrorRecord
+	{
+		uint64_t sequence;		// Increases with each recorded error, gaps mean dropped errors.
+		int64_t timestampUs;	// Microseconds since the Unix epoch.
+		int32_t code;			// WAIC_ErrorCode
+		int32_t operation;		// WAIC_Operation
+		int32_t hresult;		// Backend HRESULT, 0 if none.
+		int32_t listen;			// Requested listen state for write operations, -1 otherwise.
+		char device[WAIC_DEVICE_NAME_SIZE];	// UTF-8, truncated.
+	};
+
+	// One capture endpoint in a Snapshot. Fixed size, strings are UTF-8, null terminated and truncated.
+	struct WAIC_DeviceSnapshot
+	{
+		char name[WAIC_DEVICE_NAME_SIZE];			// Friendly name.
+		char endpointId[WAIC_ENDPOINT_ID_SIZE];
+		char listenTarget[WAIC_ENDPOINT_ID_SIZE];	// Endpoint id of the output device, empty for the default one.
+		uint32_t state;								// DEVICE_STATE_XXX
+		int32_t listen;								// 1 listening, 0 not listening, -1 could not be read.
+	};
+
+	// Device matching (OpenDeviceMatching). Except WAIC_MATCH_NAME, names are compared case-insensitively (ASCII).
+	enum WAIC_MatchMode
+	{
+		WAIC_MATCH_NAME = 0,			// Exact friendly name, as OpenDevice.
+		WAIC_MATCH_ENDPOINT_ID = 1,		// Endpoint id: stable when the device is renamed (eg. "2- Microphone" once moved to another USB port).
+		WAIC_MATCH_PREFIX = 2,
+		WAIC_MATCH_SUBSTRING = 3,
+		WAIC_MATCH_WILDCARD = 4			// '*' matches any sequence of characters, '?' any single character.
+	};
+
+	enum WAIC_TicketStatus
+	{
+		WAIC_TICKET_INVALID = 0,	// Unknown ticket, already polled, or completed through a callback.
+		WAIC_TICKET_PENDING = 1,
+		WAIC_TICKET_DONE = 2
+	};
+
+	// Instrumented backend stages.
+	enum WAIC_Stage
+	{
+		WAIC_STAGE_ENUMERATE = 0,				// Endpoints enumeration (with their friendly names).
+		WAIC_STAGE_OPEN_PROPERTY_STORE = 1,
+		WAIC_STAGE_GET_VALUE = 2,				// One property read.
+		WAIC_STAGE_SET_VALUE = 3,				// One property write.
+		WAIC_STAGE_LOOKUP = 4,					// Device name to opened device (opening it on a cache miss).
+		WAIC_STAGE_COUNT = 5
+	};
+
+	enum WAIC_Cache
+	{
+		WAIC_CACHE_DEVICE = 0,					// Opened devices, by name.
+		WAIC_CACHE_LISTEN_STATE = 1,			// Cached listen states.
+		WAIC_CACHE_PROPERTY_STORE = 2,			// Property store sessions of the opened devices, reused or (re)opened.
+		WAIC_CACHE_COUNT = 3
+	};
+
+	// Failure handling of the backend calls (see SetRetryPolicy / SetCircuitBreaker / SetCallTimeout).
+	enum WAIC_Fault
+	{
+		WAIC_FAULT_RETRY = 0,					// Backend call made again after a transient failure.
+		WAIC_FAULT_TIMEOUT = 1,					// Call given up at its deadline.
+		WAIC_FAULT_CIRCUIT_REJECTED = 2,		// Call rejected by the open circuit breaker of its device.
+		WAIC_FAULT_CIRCUIT_OPENED = 3,			// Circuit breaker opened after consecutive failures of its device.
+		WAIC_FAULT_COUNT = 4
+	};
+
+	struct WAIC_StageStats
+	{
+		uint64_t count;
+		uint64_t totalNs;
+		uint64_t maxNs;
+		uint64_t buckets[WAIC_STATS_BUCKETS];	// buckets[i]: number of calls which took [2^i, 2^(i+1)) ns, the last bucket also counts the slower ones.
+	};
+
+	struct WAIC_Stats
+	{
+		WAIC_StageStats stages[WAIC_STAGE_COUNT];	// Indexed by WAIC_Stage.
+		uint64_t cacheHits[WAIC_CACHE_COUNT];		// Indexed by WAIC_Cache.
+		uint64_t cacheMisses[WAIC_CACHE_COUNT];
+		uint64_t faults[WAIC_FAULT_COUNT];			// Indexed by WAIC_Fault.
+		bool enabled;								// false when the library is built with WAIC_ENABLE_STATS=0: everything else is 0.
+	};
+
+	// Changes seen through the endpoint notifications, ie. not made by this library (eg. from the Windows Sound panel, or by another process).
+	enum WAIC_EventType
+	{
+		WAIC_EVENT_LISTEN_CHANGED = 1,		// Listen checkbox of an opened audio input.
+		WAIC_EVENT_TARGET_CHANGED = 2,		// Output device of an opened audio input.
+		WAIC_EVENT_DEVICE_ADDED = 3,		// Audio input plugged or enabled.
+		WAIC_EVENT_DEVICE_REMOVED = 4		// Audio input unplugged or disabled: its handles are stale.
+	};
+
+	// Fixed size, strings are UTF-8, null terminated and truncated.
+	struct WAIC_Event
+	{
+		uint64_t sequence;							// Increases with each event, gaps mean dropped events.
+		int32_t type;								// WAIC_EventType
+		int32_t listen;								// New listen state for WAIC_EVENT_LISTEN_CHANGED / WAIC_EVENT_TARGET_CHANGED, -1 otherwise.
+		WAIC_DeviceHandle device;					// Opened device, WAIC_INVALID_DEVICE for the added/removed devices.
+		char name[WAIC_DEVICE_NAME_SIZE];			// Friendly name.
+		char endpointId[WAIC_ENDPOINT_ID_SIZE];
+		char listenTarget[WAIC_ENDPOINT_ID_SIZE];	// New output device id for WAIC_EVENT_TARGET_CHANGED / WAIC_EVENT_LISTEN_CHANGED (empty for the default one).
+	};
+
+	// Latest input level of a watched device (see StartLevelMetering).
+	struct WAIC_Level
+	{
+		WAIC_DeviceHandle device;
+		int64_t timestampUs;		// Time of the last sample, in microseconds since the Unix epoch (0 before the first one).
+		float peak;					// Last sampled peak, from 0.0 to 1.0.
+		float rms;					// RMS of the peaks sampled during the last 100 ms.
+		int32_t hresult;			// 0, or the backend HRESULT of the last sample when it failed (the levels are then 0).
+	};
+
+	// Software monitor of a device (see StartMonitor). The counters restart with each StartMonitor.
+	struct WAIC_MonitorStats
+	{
+		uint64_t capturedFrames;
+		uint64_t renderedFrames;
+		uint64_t underruns;			// Render periods padded with silence because the capture was late.
+		uint64_t overruns;			// Capture packets partly dropped because the render was late.
+		uint64_t droppedFrames;		// By the overruns, and to catch up with the capture clock.
+		uint32_t sampleRate;
+		int32_t inputChannels;
+		int32_t outputChannels;
+		float latencyMs;			// End-to-end: capture stream, ring and render buffer, render stream.
+		int32_t hresult;			// 0, or the backend HRESULT that stopped the monitor.
+		bool running;
+	};
+
+	// Called on the library worker thread for each event. It must return quickly and must not call back into the library.
+	typedef void (*WAIC_EventCallback)(const WAIC_Event* pEvent, void* pUserData);
+
+	// Called on the library worker thread when an asynchronous request completes. It must return quickly and must not wait for another request.
+	typedef void (*WAIC_Callback)(uint64_t pTicket, bool pSuccess, bool pValue, void* pUserData);
+
+	/// <summary>
+	/// Must be called first, before any other call. All the other functions can then be called from any thread.
+	/// The Init functions and Terminate() must not run concurrently with any other call. Once initialized, the Init functions do nothing
+	/// until Terminate() (InitClient returns false, the providers given to the other ones are deleted).
+	/// </summary>
 	WAIC_API void Init();
 
+	/// <summary>
+	/// Instead of Init(): client mode, the calls are sent to the controller service (WindowsAudioInputsControllerService) listening on
+	/// pServiceName (NULL for the default name), which owns the backend and the device cache shared by all its clients.
+	/// Only IsListening, SetListenToAudioInputDevice(s), GetListenStates, SetListenToAudioInputDeviceTarget, OpenDevice, IsDeviceHandleValid,
+	/// IsDeviceListening, SetListenToDevice(s), GetDeviceListenStates, RefreshAudioInputs, Snapshot and the error functions are forwarded: the other ones fail as if not initialized.
+	/// </summary>
+	/// <returns>false if the service could not be reached yet (the calls retry to connect, and fail with WAIC_ERROR_SERVICE_UNAVAILABLE meanwhile)</returns>
+	WAIC_API bool InitClient(const char* pServiceName);
+
+	// Same as Init(), but using the given endpoint backend (eg. a MockEndpointProvider). Takes ownership of pProvider.
+	WAIC_API void InitWithProvider(IAudioEndpointProvider* pProvider);
+
+	/// <summary>
+	/// Same as Init(), but returns right away: the backend initialization and the endpoints enumeration run on the library worker thread,
+	/// then the pPrewarmDeviceNames devices (optional) are opened and their listen state read.
+	/// Calls made meanwhile wait for the initialization, the devices they need being resolved ahead of the remaining prewarm devices.
+	/// With pFailFast, they fail with WAIC_ERROR_NOT_READY instead of waiting (IsListening still succeeds for the devices already prewarmed).
+	/// </summary>
+	WAIC_API void InitAsync(const char* const* pPrewarmDeviceNames, int pCount, bool pFailFast);
+	WAIC_API void InitAsyncWithProvider(IAudioEndpointProvider* pProvider, const char* const* pPrewarmDeviceNames, int pCount, bool pFailFast);
+
+	// True once initialized and the prewarm devices resolved.
+	WAIC_API bool IsReady();
+
+	/// <summary>
+	/// Waits for IsReady(), at most pTimeoutMs milliseconds (no limit if negative).
+	/// </summary>
+	/// <returns>False on timeout, or if the initialization failed</returns>
+	WAIC_API bool WaitReady(int pTimeoutMs);
+
 	WAIC_API bool IsListening(const char* pDeviceName);
 
 	/// <summary>
 	/// Enable/Disable to listen to the given audio input using default audio output (eg. listen to a microphone using default speakers).
+	/// </summary>
 	/// <returns>True if operation succeeded, False if pDeviceName not found</returns>
 	WAIC_API bool SetListenToAudioInputDevice(const char* pDeviceName, bool pListen);
 
+	/// <summary>
+	/// Batched version of SetListenToAudioInputDevice: pListen[i] is applied to pDeviceNames[i], the devices being processed in parallel.
+	/// pResults[i] (optional) receives the result for pDeviceNames[i].
+	/// </summary>
+	/// <returns>Number of devices successfully set</returns>
+	WAIC_API int SetListenToAudioInputDevices(const char* const* pDeviceNames, const bool* pListen, int pCount, bool* pResults);
+
+	/// <summary>
+	/// Batched version of IsListening: pIsListening[i] receives the state of pDeviceNames[i], pResults[i] (optional) whether it could be read.
+	/// </summary>
+	/// <returns>Number of devices successfully read</returns>
+	WAIC_API int GetListenStates(const char* const* pDeviceNames, int pCount, bool* pIsListening, bool* pResults);
+
+	/// <summary>
+	/// Resolves the device name once. The handle can then be used instead of the name, without any per-call lookup or allocation.
+	/// It becomes stale when the device is unplugged or changed: OpenDevice must then be called again.
+	/// </summary>
+	/// <returns>Handle of the device, WAIC_INVALID_DEVICE if not found</returns>
+	WAIC_API WAIC_DeviceHandle OpenDevice(const char* pDeviceName);
+
+	/// <summary>
+	/// Same as OpenDevice, for the audio input matching pPattern. If several match, the first one in (case-insensitive) name order is opened.
+	/// Matching runs on a name index built when the devices are enumerated: it does no backend call.
+	/// </summary>
+	WAIC_API WAIC_DeviceHandle OpenDeviceMatching(const char* pPattern, WAIC_MatchMode pMode);
+
+	/// <summary>
+	/// Copies the friendly name of the audio input matching pPattern (same rules as OpenDeviceMatching), truncated to pSize bytes.
+	/// </summary>
+	/// <returns>False if no audio input matches</returns>
+	WAIC_API bool GetMatchingDeviceName(const char* pPattern, WAIC_MatchMode pMode, char* pName, int pSize);
+
+	// False if the handle is unknown or stale.
+	WAIC_API bool IsDeviceHandleValid(WAIC_DeviceHandle pDevice);
+
+	WAIC_API bool IsDeviceListening(WAIC_DeviceHandle pDevice);
+
+	// Same as SetListenToAudioInputDevice, using a handle returned by OpenDevice.
+	WAIC_API bool SetListenToDevice(WAIC_DeviceHandle pDevice, bool pListen);
+
+	// Same as SetListenToAudioInputDevices / GetListenStates, using handles returned by OpenDevice.
+	WAIC_API int SetListenToDevices(const WAIC_DeviceHandle* pDevices, const bool* pListen, int pCount, bool* pResults);
+	WAIC_API int GetDeviceListenStates(const WAIC_DeviceHandle* pDevices, int pCount, bool* pIsListening, bool* pResults);
+
+	// "Continue running when on battery power" setting of the Listen tab (not cached: each call reads or writes it).
+	WAIC_API bool GetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool* pContinueOnBattery);
+	WAIC_API bool SetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool pContinueOnBattery);
+
+	/// <summary>
+	/// Resolves an audio output by name, from an index of the render endpoints built once and kept up to date by the device notifications.
+	/// The handle becomes stale when the output is unplugged or changed.
+	/// </summary>
+	/// <returns>Handle of the output, WAIC_INVALID_DEVICE if not found</returns>
+	WAIC_API WAIC_OutputHandle OpenOutputDevice(const char* pOutputDeviceName);
+
+	WAIC_API bool IsOutputHandleValid(WAIC_OutputHandle pOutput);
+
+	/// <summary>
+	/// Enable/Disable to listen to the given audio input using the given audio output (eg. route a microphone to a headset).
+	/// pOutputDeviceName NULL or empty selects the default audio output.
+	/// </summary>
+	/// <returns>True if operation succeeded, False if pDeviceName or pOutputDeviceName not found</returns>
+	WAIC_API bool SetListenToAudioInputDeviceTarget(const char* pDeviceName, bool pListen, const char* pOutputDeviceName);
+
+	// Same as SetListenToAudioInputDeviceTarget, using handles. pOutput WAIC_INVALID_DEVICE selects the default audio output.
+	WAIC_API bool SetListenToDeviceTarget(WAIC_DeviceHandle pDevice, bool pListen, WAIC_OutputHandle pOutput);
+
+	/// <summary>
+	/// Asynchronous version of IsListening: returns immediately, the state is given to pCallback (optional) or to PollTicket.
+	/// </summary>
+	/// <returns>Ticket of the request, 0 if it could not be queued (too many pending requests, or pDeviceName too long)</returns>
+	WAIC_API uint64_t IsListeningAsync(const char* pDeviceName, WAIC_Callback pCallback, void* pUserData);
+
+	/// <summary>
+	/// Asynchronous version of SetListenToAudioInputDevice: returns immediately, the result is given to pCallback (optional) or to PollTicket.
+	/// </summary>
+	/// <returns>Ticket of the request, 0 if it could not be queued (too many pending requests, or pDeviceName too long)</returns>
+	WAIC_API uint64_t SetListenToAudioInputDeviceAsync(const char* pDeviceName, bool pListen, WAIC_Callback pCallback, void* pUserData);
+
+	/// <summary>
+	/// Gets the result of an asynchronous request without a callback. Once done, the ticket is released: it must be polled until done.
+	/// pValue receives the listen state for IsListeningAsync.
+	/// </summary>
+	/// <returns>WAIC_TicketStatus</returns>
+	WAIC_API int PollTicket(uint64_t pTicket, bool* pSuccess, bool* pValue);
+
+	/// <summary>
+	/// Fills pRecords with the active audio inputs and their listen state, in one call. pRequiredCount (optional) receives the number of
+	/// audio inputs: when it is greater than pCapacity, only the first pCapacity ones are copied.
+	/// Served from the cached device index and listen states: once every state is known, no backend call nor allocation is done.
+	/// </summary>
+	/// <returns>Number of records copied</returns>
+	WAIC_API int Snapshot(WAIC_DeviceSnapshot* pRecords, int pCapacity, int* pRequiredCount);
+
+	/// <summary>
+	/// Saves the listen configuration of the active audio inputs (listen flag and output device, keyed by endpoint id) as a small versioned
+	/// binary profile. pBuffer can be NULL to get the size.
+	/// </summary>
+	/// <returns>Size of the profile in bytes: the profile is only written when it fits in pSize bytes</returns>
+	WAIC_API int SaveListenProfile(void* pBuffer, int pSize);
+
+	/// <summary>
+	/// Applies a profile saved by SaveListenProfile: only the devices differing from it are written, in one batch.
+	/// The endpoints of the profile not present on this machine are skipped.
+	/// </summary>
+	/// <returns>Number of devices written, -1 if the profile is invalid</returns>
+	WAIC_API int RestoreListenProfile(const void* pBuffer, int pSize);
+
+	/// <summary>
+	/// Re-enumerates the audio inputs. The cached device index is already kept up to date by the device notifications (plugged, unplugged,
+	/// enabled, disabled or renamed devices): this is only needed to recover from missed notifications.
+	/// </summary>
+	WAIC_API bool RefreshAudioInputs();
+
+	// Number of "Listen" property reads done because the cached listen state was unknown or changed outside of the library.
+	WAIC_API unsigned long long GetListenStateReadCount();
+
+	/// <summary>
+	/// Enables write coalescing: SetListenToAudioInputDevice / SetListenToDevice return once the request is queued, and only the last state
+	/// requested for a device within pMilliseconds is written. IsListening returns the requested state meanwhile. 0 (default) disables it.
+	/// </summary>
+	WAIC_API void SetWriteCoalescingWindow(int pMilliseconds);
+
+	// Number of writes not sent to the audio service: device already in the requested state, or request superseded by a later one.
+	WAIC_API unsigned long long GetSavedWriteCount();
+
+	/// <summary>
+	/// Bounds IsListening, SetListenToAudioInputDevice, IsDeviceListening and SetListenToDevice to pMilliseconds: past it they fail with
+	/// WAIC_ERROR_TIMEOUT, without waiting for the backend (a write already sent may still be applied). 0 (default) waits without limit.
+	/// Cached listen states are still returned right away.
+	/// </summary>
+	WAIC_API void SetCallTimeout(int pMilliseconds);
+
+	// Same as IsListening / SetListenToAudioInputDevice, bounded to pTimeoutMs milliseconds (0 waits without limit).
+	WAIC_API bool IsListeningWithTimeout(const char* pDeviceName, int pTimeoutMs);
+	WAIC_API bool SetListenToAudioInputDeviceWithTimeout(const char* pDeviceName, bool pListen, int pTimeoutMs);
+
+	/// <summary>
+	/// Property reads and writes failing with a transient error (audio service restarting, RPC busy or disconnected) are made again, up to
+	/// pMaxAttempts times in all (1 disables the retries), waiting pInitialBackoffMs then twice longer each time, up to pMaxBackoffMs.
+	/// The retries stop at the timeout of the call. Default: 3 attempts, 10 ms, 200 ms.
+	/// The backoff blocks the library worker thread: the calls queued meanwhile wait for it.
+	/// </summary>
+	WAIC_API void SetRetryPolicy(int pMaxAttempts, int pInitialBackoffMs, int pMaxBackoffMs);
+
+	/// <summary>
+	/// After pFailureThreshold consecutive failed property accesses, the calls on a device fail right away with WAIC_ERROR_CIRCUIT_OPEN for
+	/// pCooldownMs, then a single trial call decides whether it closes again or stays open. 0 (default) disables the circuit breakers.
+	/// </summary>
+	WAIC_API void SetCircuitBreaker(int pFailureThreshold, int pCooldownMs);
+
+	/// <summary>
+	/// Copies the latency histograms of the backend stages and the cache counters, accumulated since Init() or ResetStats().
+	/// </summary>
+	WAIC_API bool GetStats(WAIC_Stats* pStats);
+
+	/// <summary>
+	/// Same as GetStats, as a JSON object (with p50/p99 estimated from the histograms).
+	/// </summary>
+	/// <returns>Valid until the next call to GetStatsJson on the same thread</returns>
+	WAIC_API const char* GetStatsJson();
+
+	WAIC_API void ResetStats();
+
+	/// <summary>
+	/// Copies the pending events (listen state changed from outside, audio input added or removed), oldest first, and removes them.
+	/// Meant to be called once per frame instead of polling each device: it makes no backend call, and is only two atomic loads when nothing changed.
+	/// </summary>
+	/// <returns>Number of events copied</returns>
+	WAIC_API int DrainEvents(WAIC_Event* pEvents, int pCapacity);
+
+	/// <summary>
+	/// Delivers the events to pCallback instead of queuing them for DrainEvents. NULL restores the queue.
+	/// </summary>
+	WAIC_API void SetEventCallback(WAIC_EventCallback pCallback, void* pUserData);
+
+	// Number of events dropped because the queue was full (not drained).
+	WAIC_API unsigned long long GetDroppedEventCount();
+
+	/// <summary>
+	/// Starts (or restarts at a new rate) the level sampler thread, which polls the peak level of the watched devices pRateHz times per second (1 to 1000).
+	/// On Windows, a capture device only reports levels while a stream is running on it (eg. "Listen to this device", or a recording application).
+	/// </summary>
+	WAIC_API bool StartLevelMetering(int pRateHz);
+	WAIC_API void StopLevelMetering();
+
+	// Adds (pWatch true) or removes a device from the sampled ones (up to 64). A removed device is unwatched.
+	WAIC_API bool WatchDeviceLevels(WAIC_DeviceHandle pDevice, bool pWatch);
+
+	/// <summary>
+	/// Copies the latest levels of the watched devices. Never blocks nor calls the backend: it can be called every frame.
+	/// </summary>
+	/// <returns>Number of levels copied</returns>
+	WAIC_API int ReadLevels(WAIC_Level* pLevels, int pCapacity);
+
+	/// <summary>
+	/// Software "Listen to this device": plays the device on pOutput (WAIC_INVALID_DEVICE for the default output device), through event-driven
+	/// shared-mode streams with pBufferMs endpoint buffers (eg. 10). The output stream runs at the input sample rate, converted by the audio engine.
+	/// Restarts the monitor if the device is already monitored. The monitor is stopped when the device or the output is removed.
+	/// </summary>
+	WAIC_API bool StartMonitor(WAIC_DeviceHandle pDevice, WAIC_OutputHandle pOutput, int pBufferMs);
+	WAIC_API bool StopMonitor(WAIC_DeviceHandle pDevice);
+	// Linear gain applied to the monitored samples (1.0 by default).
+	WAIC_API bool SetMonitorGain(WAIC_DeviceHandle pDevice, float pGain);
+	/// <summary>
+	/// pMap[c] is the input channel played on the output channel c (negative for silence), for the first pCount output channels (up to
+	/// WAIC_MONITOR_MAX_CHANNELS), the other ones are silent. Reset by StartMonitor: input channel c on output channel c, a mono input on every channel.
+	/// </summary>
+	WAIC_API bool SetMonitorChannelMap(WAIC_DeviceHandle pDevice, const int* pMap, int pCount);
+	WAIC_API bool GetMonitorStats(WAIC_DeviceHandle pDevice, WAIC_MonitorStats* pStats);
+
 	WAIC_API bool HasError();
 
+	/// <summary>
+	/// Formats the pending errors and removes them.
+	/// </summary>
+	/// <returns>Text of the errors, valid until the next call to GetErrors</returns>
 	WAIC_API const char* GetErrors();
 
-	// Must be called at the end of the program.
+	/// <summary>
+	/// Copies the pending errors (oldest first) to pRecords and removes them. Only the latest errors are kept when they are not drained.
+	/// </summary>
+	/// <returns>Number of records copied</returns>
+	WAIC_API int DrainErrors(WAIC_ErrorRecord* pRecords, int pCapacity);
+
+	WAIC_API void ClearErrors();
+
+	// Must be called at the end of the program, once the other calls have returned. Pending asynchronous requests are completed first.
+	// The library can then be initialized again.
 	WAIC_API void Terminate();
 }
\ No newline at end of file
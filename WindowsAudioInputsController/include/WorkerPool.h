@@ -0,0 +1,69 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Small pool running the iterations of a loop in parallel (eg. one backend call per device of a batch).
+/// It only grows, when Reserve() asks for more threads.
+/// </summary>
+class WorkerPool
+{
+public:
+	// pThreadInit/pThreadExit are called on each worker thread when it starts/stops (eg. COM initialization).
+	WorkerPool(int pThreadCount, const std::function<void()>& pThreadInit, const std::function<void()>& pThreadExit);
+	~WorkerPool();
+
+	// Runs pTask(i) for each i in [0, pCount), on the workers and on the calling thread. Returns when all iterations are done.
+	void ParallelFor(int pCount, const std::function<void(int)>& pTask);
+	// Starts worker threads until there are pThreadCount of them. Waits for the running ParallelFor, if any.
+	void Reserve(int pThreadCount);
+
+	inline int GetThreadCount()const { return (int)_threads.size(); }
+
+private:
+	struct Batch
+	{
+		const std::function<void(int)>* task;
+		int count;
+		std::atomic<int> next;
+		int workers;
+	};
+
+	void _Run();
+	static void _Work(Batch* pBatch);
+
+private:
+	std::function<void()> _threadInit;
+	std::function<void()> _threadExit;
+	std::vector<std::thread> _threads;
+	std::mutex _parallelForMutex;
+	std::mutex _mutex;
+	std::condition_variable _wakeUp;
+	std::condition_variable _workerDone;
+	Batch* _batch;
+	uint64_t _batchId;
+	bool _stop;
+};
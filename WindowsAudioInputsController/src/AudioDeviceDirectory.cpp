@@ -0,0 +1,304 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <algorithm>
+
+#include "AudioDeviceDirectory.h"
+
+AudioDeviceDirectory::AudioDeviceDirectory(IAudioEndpointProvider* pProvider, EndpointFlow pFlow, ControllerStats* pStats)
+	: _provider(pProvider), _flow(pFlow), _stats(pStats), _valid(false), _refreshCount(0), _missCount(0), _endpoints(), _indicesByName(), _indicesById(),
+	_sortedNames(), _sortedNamesValid(false), _normalizedPattern(), _matches()
+{
+
+}
+
+AudioDeviceDirectory::~AudioDeviceDirectory()
+{
+
+}
+
+bool AudioDeviceDirectory::Refresh()
+{
+	_valid = false;
+	_indicesByName.clear();
+	_indicesById.clear();
+
+	EndpointResult hr;
+	{
+		StatsTimer timer(_stats, WAIC_STAGE_ENUMERATE);
+		hr = _provider->EnumerateEndpoints(_flow, ENDPOINT_STATE_ACTIVE, _endpoints);
+	}
+	++_refreshCount;
+	if (!EndpointSucceeded(hr))
+	{
+		_endpoints.clear();
+		return false;
+	}
+
+	_indicesByName.reserve(_endpoints.size());
+	_indicesById.reserve(_endpoints.size());
+	for (size_t i = 0; i < _endpoints.size(); ++i)
+	{
+		_indicesById.emplace(_endpoints[i].id, i);
+		_IndexName(i);
+	}
+	_SortNames();
+	_valid = true;
+	return true;
+}
+
+bool AudioDeviceDirectory::FindIdByName(const std::string& pFriendlyName, std::string& pEndpointId)
+{
+	if (!_valid && !Refresh())
+	{
+		return false;
+	}
+
+	auto it = _indicesByName.find(pFriendlyName);
+	if (it != _indicesByName.end())
+	{
+		pEndpointId = _endpoints[it->second].id;
+		return true;
+	}
+
+	// Negative answer: unknown names are not re-enumerated until the next refresh.
+	++_missCount;
+	return false;
+}
+
+const EndpointInfo* AudioDeviceDirectory::FindByName(const std::string& pFriendlyName)
+{
+	if (!_valid && !Refresh())
+	{
+		return NULL;
+	}
+
+	auto it = _indicesByName.find(pFriendlyName);
+	if (it != _indicesByName.end())
+	{
+		return &_endpoints[it->second];
+	}
+	++_missCount;
+	return NULL;
+}
+
+const EndpointInfo* AudioDeviceDirectory::FindById(const std::string& pEndpointId)
+{
+	if (!_valid && !Refresh())
+	{
+		return NULL;
+	}
+
+	auto it = _indicesById.find(pEndpointId);
+	return (it != _indicesById.end()) ? &_endpoints[it->second] : NULL;
+}
+
+const EndpointInfo* AudioDeviceDirectory::Match(const std::string& pPattern, WAIC_MatchMode pMode)
+{
+	if (pMode == WAIC_MATCH_ENDPOINT_ID)
+	{
+		return FindById(pPattern);
+	}
+	if (!_valid && !Refresh())
+	{
+		return NULL;
+	}
+	if (pMode == WAIC_MATCH_NAME)
+	{
+		auto it = _indicesByName.find(pPattern);
+		return (it != _indicesByName.end()) ? &_endpoints[it->second] : NULL;
+	}
+
+	if (!_sortedNamesValid)
+	{
+		_SortNames();
+	}
+	_Normalize(pPattern, _normalizedPattern);
+
+	if (pMode == WAIC_MATCH_PREFIX)
+	{
+		auto it = std::lower_bound(_sortedNames.begin(), _sortedNames.end(), _normalizedPattern,
+			[](const std::pair<std::string, size_t>& pEntry, const std::string& pPrefix) { return pEntry.first < pPrefix; });
+		if (it != _sortedNames.end() && it->first.compare(0, _normalizedPattern.size(), _normalizedPattern) == 0)
+		{
+			return &_endpoints[it->second];
+		}
+		return NULL;
+	}
+
+	_normalizedPattern.insert(_normalizedPattern.begin(), (char)('0' + pMode));
+	auto matchIt = _matches.find(_normalizedPattern);
+	if (matchIt != _matches.end())
+	{
+		return (matchIt->second != NO_MATCH) ? &_endpoints[matchIt->second] : NULL;
+	}
+
+	const char* pattern = _normalizedPattern.c_str() + 1;
+	size_t index = NO_MATCH;
+	for (const std::pair<std::string, size_t>& entry : _sortedNames)
+	{
+		bool matches = (pMode == WAIC_MATCH_SUBSTRING) ? (entry.first.find(pattern) != std::string::npos)
+			: (pMode == WAIC_MATCH_WILDCARD && _MatchWildcard(entry.first.c_str(), pattern));
+		if (matches)
+		{
+			index = entry.second;
+			break;
+		}
+	}
+
+	if (_matches.size() >= MATCHES_CAPACITY)
+	{
+		_matches.clear();
+	}
+	_matches.emplace(_normalizedPattern, index);
+	return (index != NO_MATCH) ? &_endpoints[index] : NULL;
+}
+
+void AudioDeviceDirectory::AddEndpoint(const EndpointInfo& pEndpoint)
+{
+	if (!_valid || pEndpoint.flow != _flow) return;
+
+	if ((pEndpoint.state & ENDPOINT_STATE_ACTIVE) == 0)
+	{
+		RemoveEndpoint(pEndpoint.id);
+		return;
+	}
+
+	auto it = _indicesById.find(pEndpoint.id);
+	if (it != _indicesById.end())
+	{
+		// Already known: the friendly name may have changed.
+		RemoveEndpoint(pEndpoint.id);
+	}
+
+	_endpoints.push_back(pEndpoint);
+	_indicesById.emplace(pEndpoint.id, _endpoints.size() - 1);
+	_IndexName(_endpoints.size() - 1);
+	_sortedNamesValid = false;
+}
+
+void AudioDeviceDirectory::RemoveEndpoint(const std::string& pEndpointId)
+{
+	if (!_valid) return;
+
+	auto it = _indicesById.find(pEndpointId);
+	if (it == _indicesById.end()) return;
+
+	size_t index = it->second;
+	size_t last = _endpoints.size() - 1;
+	_sortedNamesValid = false;
+	std::string friendlyName = _endpoints[index].friendlyName;
+	_indicesById.erase(it);
+
+	auto nameIt = _indicesByName.find(friendlyName);
+	bool indexedByName = (nameIt != _indicesByName.end() && nameIt->second == index);
+	if (indexedByName)
+	{
+		_indicesByName.erase(nameIt);
+	}
+
+	// Swap with the last endpoint, so that removal does not shift the whole array.
+	if (index != last)
+	{
+		_endpoints[index] = std::move(_endpoints[last]);
+		_indicesById[_endpoints[index].id] = index;
+		auto movedIt = _indicesByName.find(_endpoints[index].friendlyName);
+		if (movedIt != _indicesByName.end() && movedIt->second == last)
+		{
+			movedIt->second = index;
+		}
+	}
+	_endpoints.pop_back();
+
+	// Another endpoint may share the removed name.
+	if (indexedByName)
+	{
+		for (size_t i = 0; i < _endpoints.size(); ++i)
+		{
+			if (_endpoints[i].friendlyName == friendlyName)
+			{
+				_indicesByName.emplace(friendlyName, i);
+				break;
+			}
+		}
+	}
+}
+
+void AudioDeviceDirectory::_IndexName(size_t pIndex)
+{
+	// On duplicated names, the first indexed endpoint wins (as the previous linear scan did).
+	_indicesByName.emplace(_endpoints[pIndex].friendlyName, pIndex);
+}
+
+void AudioDeviceDirectory::_SortNames()
+{
+	_sortedNames.resize(_endpoints.size());
+	for (size_t i = 0; i < _endpoints.size(); ++i)
+	{
+		_Normalize(_endpoints[i].friendlyName, _sortedNames[i].first);
+		_sortedNames[i].second = i;
+	}
+	std::sort(_sortedNames.begin(), _sortedNames.end());
+	_sortedNamesValid = true;
+	_matches.clear();
+}
+
+void AudioDeviceDirectory::_Normalize(const std::string& pName, std::string& pNormalizedName)
+{
+	// ASCII only: the other UTF-8 bytes are compared as is.
+	pNormalizedName.resize(pName.size());
+	for (size_t i = 0; i < pName.size(); ++i)
+	{
+		char c = pName[i];
+		pNormalizedName[i] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+	}
+}
+
+bool AudioDeviceDirectory::_MatchWildcard(const char* pName, const char* pPattern)
+{
+	// Greedy matching, backtracking to the last '*' on mismatch.
+	const char* star = NULL;
+	const char* starName = NULL;
+	while (*pName != '\0')
+	{
+		if (*pPattern == '*')
+		{
+			star = pPattern++;
+			starName = pName;
+		}
+		else if (*pPattern == '?' || *pPattern == *pName)
+		{
+			++pPattern;
+			++pName;
+		}
+		else if (star != NULL)
+		{
+			pPattern = star + 1;
+			pName = ++starName;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	while (*pPattern == '*')
+	{
+		++pPattern;
+	}
+	return *pPattern == '\0';
+}
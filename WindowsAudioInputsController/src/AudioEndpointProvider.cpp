@@ -0,0 +1,61 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <cstring>
+
+#include "AudioEndpointProvider.h"
+#ifdef _WIN32
+#include "WasapiEndpointProvider.h"
+#else
+#include "MockEndpointProvider.h"
+#endif
+
+bool operator==(const EndpointGuid& pLeft, const EndpointGuid& pRight)
+{
+	return memcmp(&pLeft, &pRight, sizeof(EndpointGuid)) == 0;
+}
+
+bool operator==(const EndpointPropertyKey& pLeft, const EndpointPropertyKey& pRight)
+{
+	return pLeft.pid == pRight.pid && pLeft.fmtid == pRight.fmtid;
+}
+
+EndpointPropertyValue EndpointPropertyValue::FromBool(bool pValue)
+{
+	EndpointPropertyValue value;
+	value.type = Bool;
+	value.boolValue = pValue;
+	return value;
+}
+
+EndpointPropertyValue EndpointPropertyValue::FromString(const std::string& pValue)
+{
+	EndpointPropertyValue value;
+	value.type = String;
+	value.stringValue = pValue;
+	return value;
+}
+
+IAudioEndpointProvider* CreateDefaultEndpointProvider()
+{
+#ifdef _WIN32
+	return new WasapiEndpointProvider();
+#else
+	return new MockEndpointProvider();
+#endif
+}
@@ -0,0 +1,326 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <algorithm>
+#include <cstring>
+
+#include "AudioMonitor.h"
+
+// Period of the stop checks when a stream does not signal.
+static const uint32_t WAIT_TIMEOUT_MS = 100;
+
+static void RaiseThreadPriority()
+{
+#ifdef _WIN32
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#endif
+}
+
+AudioMonitor::AudioMonitor() : _capture(), _render(), _ring(), _targetFrames(0), _captureSamples(), _renderInput(), _renderOutput(), _stop(false), _running(false), _gain(1.0f),
+	_capturedFrames(0), _renderedFrames(0), _underruns(0), _overruns(0), _droppedFrames(0), _latencyUs(0), _result(0), _captureThread(), _renderThread()
+{
+	for (std::atomic<int8_t>& channel : _channelMap)
+	{
+		channel = -1;
+	}
+}
+
+AudioMonitor::~AudioMonitor()
+{
+	Stop();
+}
+
+EndpointResult AudioMonitor::Start(IAudioEndpointProvider* pProvider, std::unique_ptr<IEndpointStream>& pCapture, std::unique_ptr<IEndpointStream>& pRender)
+{
+	Stop();
+	const EndpointStreamFormat& captureFormat = pCapture->GetFormat();
+	const EndpointStreamFormat& renderFormat = pRender->GetFormat();
+	if (captureFormat.channels == 0 || renderFormat.channels == 0 || renderFormat.channels > SAMPLES_MAX_CHANNELS) return ENDPOINT_E_INVALIDARG;
+	if (captureFormat.sampleRate != renderFormat.sampleRate) return ENDPOINT_E_INVALIDARG;
+
+	_capture = std::move(pCapture);
+	_render = std::move(pRender);
+	_targetFrames = _capture->GetPeriodFrames() + _render->GetPeriodFrames();
+	// Room for the target fill, the drift margin and a late render period.
+	_ring.Reset((size_t)(_targetFrames + 2 * _capture->GetPeriodFrames() + _render->GetBufferFrames()) * captureFormat.channels);
+	_captureSamples.resize((size_t)_capture->GetBufferFrames() * captureFormat.channels);
+	_renderInput.resize((size_t)_render->GetBufferFrames() * captureFormat.channels);
+	_renderOutput.resize((size_t)_render->GetBufferFrames() * renderFormat.channels);
+	for (int c = 0; c < SAMPLES_MAX_CHANNELS; ++c)
+	{
+		_channelMap[c].store((captureFormat.channels == 1) ? 0 : (int8_t)c, std::memory_order_relaxed);
+	}
+
+	_capturedFrames = 0;
+	_renderedFrames = 0;
+	_underruns = 0;
+	_overruns = 0;
+	_droppedFrames = 0;
+	_latencyUs = 0;
+	_result = 0;
+
+	// The render buffer starts full of silence: each period then only writes the frames played meanwhile, the ring absorbing the jitter.
+	EndpointResult hr = _WriteFrames(0, _render->GetBufferFrames());
+	if (EndpointSucceeded(hr))
+	{
+		hr = _capture->Start();
+	}
+	if (EndpointSucceeded(hr))
+	{
+		hr = _render->Start();
+	}
+	if (!EndpointSucceeded(hr))
+	{
+		_capture.reset();
+		_render.reset();
+		return hr;
+	}
+
+	_stop = false;
+	_running = true;
+	_captureThread = std::thread(&AudioMonitor::_Capture, this, pProvider);
+	_renderThread = std::thread(&AudioMonitor::_Render, this, pProvider);
+	return ENDPOINT_OK;
+}
+
+void AudioMonitor::Stop()
+{
+	_stop = true;
+	if (_captureThread.joinable())
+	{
+		_captureThread.join();
+	}
+	if (_renderThread.joinable())
+	{
+		_renderThread.join();
+	}
+	_running = false;
+	if (_capture != NULL)
+	{
+		_capture->Stop();
+		_capture.reset();
+	}
+	if (_render != NULL)
+	{
+		_render->Stop();
+		_render.reset();
+	}
+}
+
+void AudioMonitor::SetChannelMap(const int8_t* pMap, int pCount)
+{
+	for (int c = 0; c < SAMPLES_MAX_CHANNELS; ++c)
+	{
+		_channelMap[c].store((c < pCount) ? pMap[c] : -1, std::memory_order_relaxed);
+	}
+}
+
+void AudioMonitor::GetStats(WAIC_MonitorStats& pStats)const
+{
+	pStats.capturedFrames = _capturedFrames.load(std::memory_order_relaxed);
+	pStats.renderedFrames = _renderedFrames.load(std::memory_order_relaxed);
+	pStats.underruns = _underruns.load(std::memory_order_relaxed);
+	pStats.overruns = _overruns.load(std::memory_order_relaxed);
+	pStats.droppedFrames = _droppedFrames.load(std::memory_order_relaxed);
+	pStats.latencyMs = _latencyUs.load(std::memory_order_relaxed) / 1000.0f;
+	pStats.hresult = _result.load(std::memory_order_acquire);
+	pStats.running = IsRunning();
+	// The streams are only released by Stop(), on the thread that owns the monitor.
+	pStats.sampleRate = (_capture != NULL) ? _capture->GetFormat().sampleRate : 0;
+	pStats.inputChannels = (_capture != NULL) ? _capture->GetFormat().channels : 0;
+	pStats.outputChannels = (_render != NULL) ? _render->GetFormat().channels : 0;
+}
+
+void AudioMonitor::_Fail(EndpointResult pResult)
+{
+	int32_t expected = 0;
+	_result.compare_exchange_strong(expected, pResult, std::memory_order_acq_rel);
+	_stop = true;
+	_running = false;
+}
+
+void AudioMonitor::_Capture(IAudioEndpointProvider* pProvider)
+{
+	pProvider->InitializeThread();
+	RaiseThreadPriority();
+
+	const EndpointStreamFormat& format = _capture->GetFormat();
+	const uint32_t frameSize = format.GetFrameSize();
+	const uint32_t chunkFrames = (uint32_t)(_captureSamples.size() / format.channels);
+	EndpointResult hr = ENDPOINT_OK;
+	while (!_stop.load(std::memory_order_acquire))
+	{
+		hr = _capture->WaitPeriod(WAIT_TIMEOUT_MS);
+		if (hr == ENDPOINT_S_FALSE) continue;
+
+		// Every packet queued since the last period.
+		while (EndpointSucceeded(hr))
+		{
+			const uint8_t* data = NULL;
+			uint32_t frames = 0;
+			bool silent = false;
+			hr = _capture->ReadPacket(data, frames, silent);
+			if (!EndpointSucceeded(hr) || frames == 0) break;
+
+			bool overrun = false;
+			for (uint32_t offset = 0; offset < frames; offset += chunkFrames)
+			{
+				uint32_t count = (std::min)(chunkFrames, frames - offset);
+				if (silent)
+				{
+					memset(_captureSamples.data(), 0, (size_t)count * format.channels * sizeof(float));
+				}
+				else
+				{
+					ConvertToFloat(format.sampleType, data + (size_t)offset * frameSize, _captureSamples.data(), (size_t)count * format.channels);
+				}
+
+				// Whole frames only, the rest is lost when the render thread falls behind.
+				size_t freeFrames = (_ring.GetCapacity() - _ring.GetAvailable()) / format.channels;
+				uint32_t written = (uint32_t)(std::min)((size_t)count, freeFrames);
+				_ring.Write(_captureSamples.data(), (size_t)written * format.channels);
+				if (written < count)
+				{
+					overrun = true;
+					_droppedFrames.fetch_add(count - written, std::memory_order_relaxed);
+				}
+			}
+			if (overrun)
+			{
+				_overruns.fetch_add(1, std::memory_order_relaxed);
+			}
+			_capturedFrames.fetch_add(frames, std::memory_order_relaxed);
+			hr = _capture->ReleasePacket(frames);
+		}
+		if (!EndpointSucceeded(hr))
+		{
+			_Fail(hr);
+			break;
+		}
+	}
+
+	pProvider->UninitializeThread();
+}
+
+void AudioMonitor::_Render(IAudioEndpointProvider* pProvider)
+{
+	pProvider->InitializeThread();
+	RaiseThreadPriority();
+
+	const uint32_t inputChannels = _capture->GetFormat().channels;
+	const uint32_t sampleRate = _render->GetFormat().sampleRate;
+	const uint32_t capturePeriod = _capture->GetPeriodFrames();
+	const uint32_t renderPeriod = _render->GetPeriodFrames();
+	const uint32_t bufferFrames = _render->GetBufferFrames();
+	const uint64_t streamsLatency = (uint64_t)_capture->GetLatencyFrames() + _render->GetLatencyFrames();
+	bool primed = false;
+	EndpointResult hr = ENDPOINT_OK;
+	while (!_stop.load(std::memory_order_acquire))
+	{
+		hr = _render->WaitPeriod(WAIT_TIMEOUT_MS);
+		if (hr == ENDPOINT_S_FALSE) continue;
+		if (!EndpointSucceeded(hr)) break;
+
+		uint32_t padding = 0;
+		hr = _render->GetPadding(padding);
+		if (!EndpointSucceeded(hr)) break;
+		uint32_t writable = bufferFrames - (std::min)(padding, bufferFrames);
+		if (writable == 0) continue;
+
+		uint32_t available = (uint32_t)(_ring.GetAvailable() / inputChannels);
+		if (!primed)
+		{
+			primed = (available >= _targetFrames);
+		}
+		else if (available > _targetFrames + 2 * capturePeriod)
+		{
+			// The capture clock runs faster than the render one.
+			uint32_t excess = available - _targetFrames;
+			_ring.Skip((size_t)excess * inputChannels);
+			_droppedFrames.fetch_add(excess, std::memory_order_relaxed);
+			available = _targetFrames;
+		}
+
+		// Silence while priming, and after the ring ran dry, until the target fill is reached again.
+		uint32_t frames = (std::min)(writable, renderPeriod);
+		uint32_t inputFrames = 0;
+		if (primed)
+		{
+			inputFrames = (std::min)(writable, available);
+			if (inputFrames < frames)
+			{
+				_underruns.fetch_add(1, std::memory_order_relaxed);
+				primed = false;
+			}
+			else
+			{
+				frames = inputFrames;
+			}
+			_ring.Read(_renderInput.data(), (size_t)inputFrames * inputChannels);
+		}
+		hr = _WriteFrames(inputFrames, frames);
+		if (!EndpointSucceeded(hr)) break;
+
+		_renderedFrames.fetch_add(frames, std::memory_order_relaxed);
+		// Capture stream, ring and render buffer, render stream.
+		uint64_t latencyFrames = streamsLatency + (available - inputFrames) + padding + frames;
+		_latencyUs.store((uint32_t)(latencyFrames * 1000000 / sampleRate), std::memory_order_relaxed);
+	}
+	if (!EndpointSucceeded(hr))
+	{
+		_Fail(hr);
+	}
+
+	pProvider->UninitializeThread();
+}
+
+EndpointResult AudioMonitor::_WriteFrames(uint32_t pInputFrames, uint32_t pFrames)
+{
+	const uint32_t inputChannels = _capture->GetFormat().channels;
+	const EndpointStreamFormat& format = _render->GetFormat();
+	if (pInputFrames < pFrames)
+	{
+		memset(_renderInput.data() + (size_t)pInputFrames * inputChannels, 0, (size_t)(pFrames - pInputFrames) * inputChannels * sizeof(float));
+	}
+
+	int8_t map[SAMPLES_MAX_CHANNELS];
+	for (int c = 0; c < SAMPLES_MAX_CHANNELS; ++c)
+	{
+		map[c] = _channelMap[c].load(std::memory_order_relaxed);
+	}
+	float gain = _gain.load(std::memory_order_relaxed);
+
+	uint8_t* data = NULL;
+	EndpointResult hr = _render->GetWriteBuffer(pFrames, data);
+	if (!EndpointSucceeded(hr)) return hr;
+	if (format.sampleType == EndpointSampleType::Float32)
+	{
+		// Written directly in the render buffer: NaN or a gained sample must not reach the audio engine as is.
+		MapChannels(_renderInput.data(), inputChannels, reinterpret_cast<float*>(data), format.channels, map, gain, pFrames);
+		ClampSamples(reinterpret_cast<float*>(data), (size_t)pFrames * format.channels);
+	}
+	else
+	{
+		MapChannels(_renderInput.data(), inputChannels, _renderOutput.data(), format.channels, map, gain, pFrames);
+		ConvertFromFloat(format.sampleType, _renderOutput.data(), data, (size_t)pFrames * format.channels);
+	}
+	return _render->ReleaseWriteBuffer(pFrames);
+}
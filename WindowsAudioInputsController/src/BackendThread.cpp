@@ -0,0 +1,153 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "BackendThread.h"
+
+BackendThread::BackendThread() : _thread(), _threadId(), _head(&_stub), _tail(&_stub), _stub(), _pendingCount(0),
+	_sleeping(false), _stopping(false), _sleepMutex(), _wakeUp(), _timerSet(false), _timerTime()
+{
+
+}
+
+BackendThread::~BackendThread()
+{
+	Stop();
+}
+
+void BackendThread::Start(const std::function<void()>& pOnStart, const std::function<void()>& pOnStop, const std::function<void()>& pOnTimer)
+{
+	if (_thread.joinable()) return;
+
+	_stopping = false;
+	_timerSet = false;
+	_thread = std::thread(&BackendThread::_Run, this, pOnStart, pOnStop, pOnTimer);
+	_threadId = _thread.get_id();
+}
+
+void BackendThread::Stop()
+{
+	if (!_thread.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_stopping = true;
+	}
+	_wakeUp.notify_one();
+	_thread.join();
+	_threadId = std::thread::id();
+}
+
+void BackendThread::Submit(Request* pRequest)
+{
+	_Push(pRequest);
+	_pendingCount.fetch_add(1);
+	if (_sleeping.load())
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_wakeUp.notify_one();
+	}
+}
+
+void BackendThread::SetTimer(std::chrono::steady_clock::time_point pTime)
+{
+	_timerSet = true;
+	_timerTime = pTime;
+}
+
+void BackendThread::_Run(std::function<void()> pOnStart, std::function<void()> pOnStop, std::function<void()> pOnTimer)
+{
+	_threadId = std::this_thread::get_id();
+	if (pOnStart) pOnStart();
+
+	while (true)
+	{
+		if (_timerSet && std::chrono::steady_clock::now() >= _timerTime)
+		{
+			_timerSet = false;
+			if (pOnTimer) pOnTimer();
+		}
+
+		Request* request = _Pop();
+		if (request != NULL)
+		{
+			_pendingCount.fetch_sub(1);
+			request->Execute();
+			continue;
+		}
+
+		if (_pendingCount.load() > 0)
+		{
+			// A producer is between its exchange and its link: the request is about to be visible.
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		if (_stopping) break;
+		_sleeping = true;
+		if (_timerSet)
+		{
+			_wakeUp.wait_until(lock, _timerTime, [this] { return _pendingCount.load() > 0 || _stopping; });
+		}
+		else
+		{
+			_wakeUp.wait(lock, [this] { return _pendingCount.load() > 0 || _stopping; });
+		}
+		_sleeping = false;
+	}
+
+	if (pOnStop) pOnStop();
+}
+
+void BackendThread::_Push(Request* pRequest)
+{
+	pRequest->next.store(NULL, std::memory_order_relaxed);
+	Request* previous = _head.exchange(pRequest, std::memory_order_acq_rel);
+	previous->next.store(pRequest, std::memory_order_release);
+}
+
+BackendThread::Request* BackendThread::_Pop()
+{
+	Request* tail = _tail;
+	Request* next = tail->next.load(std::memory_order_acquire);
+	if (tail == &_stub)
+	{
+		if (next == NULL) return NULL;
+		_tail = next;
+		tail = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+
+	if (next != NULL)
+	{
+		_tail = next;
+		return tail;
+	}
+
+	if (tail != _head.load(std::memory_order_acquire)) return NULL;
+
+	// tail is the last request: put the stub back behind it, so that tail can be returned.
+	_Push(&_stub);
+	next = tail->next.load(std::memory_order_acquire);
+	if (next != NULL)
+	{
+		_tail = next;
+		return tail;
+	}
+	return NULL;
+}
@@ -0,0 +1,119 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <algorithm>
+#include <thread>
+
+#include "CallPolicy.h"
+
+static thread_local CallPolicy::Clock::time_point sDeadline = CallPolicy::Clock::time_point::max();
+
+CircuitBreaker::CircuitBreaker() : _state(Closed), _failures(0), _openUntil()
+{
+}
+
+void CircuitBreaker::Reset()
+{
+	_state = Closed;
+	_failures = 0;
+}
+
+bool CircuitBreaker::Allow(Clock::time_point pNow)
+{
+	switch (_state)
+	{
+	case Open:
+		if (pNow < _openUntil) return false;
+		_state = HalfOpen;
+		return true;
+	case HalfOpen:
+		// The trial call is still running: the other ones wait for its outcome.
+		return false;
+	default:
+		return true;
+	}
+}
+
+bool CircuitBreaker::Record(bool pSuccess, int pFailureThreshold, int pCooldownMs, Clock::time_point pNow)
+{
+	if (pSuccess)
+	{
+		Reset();
+		return false;
+	}
+
+	++_failures;
+	if (_state == HalfOpen || _failures >= pFailureThreshold)
+	{
+		_state = Open;
+		_openUntil = pNow + std::chrono::milliseconds(pCooldownMs);
+		return true;
+	}
+	return false;
+}
+
+CallPolicy::DeadlineScope::DeadlineScope(Clock::time_point pDeadline) : _previous(sDeadline)
+{
+	sDeadline = pDeadline;
+}
+
+CallPolicy::DeadlineScope::~DeadlineScope()
+{
+	sDeadline = _previous;
+}
+
+CallPolicy::CallPolicy(ControllerStats* pStats) : _stats(pStats), _maxAttempts(DEFAULT_MAX_ATTEMPTS),
+	_initialBackoffMs(DEFAULT_INITIAL_BACKOFF_MS), _maxBackoffMs(DEFAULT_MAX_BACKOFF_MS), _failureThreshold(0), _cooldownMs(DEFAULT_COOLDOWN_MS)
+{
+}
+
+void CallPolicy::SetRetry(int pMaxAttempts, int pInitialBackoffMs, int pMaxBackoffMs)
+{
+	_maxAttempts.store((std::max)(pMaxAttempts, 1), std::memory_order_relaxed);
+	_initialBackoffMs.store((std::max)(pInitialBackoffMs, 0), std::memory_order_relaxed);
+	_maxBackoffMs.store((std::max)(pMaxBackoffMs, 0), std::memory_order_relaxed);
+}
+
+void CallPolicy::SetCircuitBreaker(int pFailureThreshold, int pCooldownMs)
+{
+	_failureThreshold.store((std::max)(pFailureThreshold, 0), std::memory_order_relaxed);
+	_cooldownMs.store((std::max)(pCooldownMs, 0), std::memory_order_relaxed);
+}
+
+CallPolicy::Clock::time_point CallPolicy::GetDeadline()
+{
+	return sDeadline;
+}
+
+bool CallPolicy::_Backoff(int pAttempt)
+{
+	// initial * 2^(attempt-1), the shift being bounded so that it cannot overflow.
+	int64_t backoffMs = (int64_t)_initialBackoffMs.load(std::memory_order_relaxed) << (std::min)(pAttempt - 1, 20);
+	backoffMs = (std::min)(backoffMs, (int64_t)_maxBackoffMs.load(std::memory_order_relaxed));
+
+	Clock::time_point deadline = sDeadline;
+	if (deadline != Clock::time_point::max() && Clock::now() + std::chrono::milliseconds(backoffMs) >= deadline)
+	{
+		return false;
+	}
+	if (backoffMs > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(backoffMs));
+	}
+	return true;
+}
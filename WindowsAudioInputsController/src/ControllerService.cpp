@@ -0,0 +1,290 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <algorithm>
+
+#include "ControllerService.h"
+#include "ErrorRing.h"
+#include "ServiceProtocol.h"
+#include "WindowsAudioInputsController.h"
+
+ControllerService::ControllerService(WindowsAudioInputsController* pController) :
+	_controller(pController), _listener(), _acceptThread(), _clientsMutex(), _clients(), _clientCount(0),
+	_executeMutex(), _errors(ErrorRing::CAPACITY), _snapshot()
+{
+
+}
+
+ControllerService::~ControllerService()
+{
+	Stop();
+}
+
+bool ControllerService::Start(const std::string& pName)
+{
+	if (_acceptThread.joinable() || !_listener.Listen(pName))
+	{
+		return false;
+	}
+	_acceptThread = std::thread(&ControllerService::_Accept, this);
+	return true;
+}
+
+void ControllerService::Stop()
+{
+	_listener.Close();
+	if (_acceptThread.joinable())
+	{
+		_acceptThread.join();
+	}
+
+	std::lock_guard<std::mutex> lock(_clientsMutex);
+	for (Client& client : _clients)
+	{
+		client.channel.Close();
+	}
+	for (Client& client : _clients)
+	{
+		if (client.thread.joinable())
+		{
+			client.thread.join();
+		}
+	}
+	_clients.clear();
+}
+
+void ControllerService::_Accept()
+{
+	while (true)
+	{
+		Client* client = NULL;
+		{
+			std::lock_guard<std::mutex> lock(_clientsMutex);
+			_JoinDoneClients();
+			_clients.emplace_back();
+			client = &_clients.back();
+		}
+
+		if (!_listener.Accept(client->channel))
+		{
+			std::lock_guard<std::mutex> lock(_clientsMutex);
+			_clients.pop_back();
+			break;
+		}
+		++_clientCount;
+		client->thread = std::thread(&ControllerService::_Serve, this, client);
+	}
+}
+
+void ControllerService::_JoinDoneClients()
+{
+	for (auto it = _clients.begin(); it != _clients.end();)
+	{
+		if (it->done)
+		{
+			it->thread.join();
+			it = _clients.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void ControllerService::_Serve(Client* pClient)
+{
+	std::vector<uint8_t> request;
+	std::vector<uint8_t> response;
+	while (pClient->channel.ReadMessage(request))
+	{
+		if (!_Execute(request, response) || !pClient->channel.WriteMessage(response))
+		{
+			break;
+		}
+	}
+	pClient->channel.Close();
+	--_clientCount;
+	pClient->done = true;
+}
+
+bool ControllerService::_Execute(const std::vector<uint8_t>& pRequest, std::vector<uint8_t>& pResponse)
+{
+	std::lock_guard<std::mutex> lock(_executeMutex);
+	WindowsAudioInputsController& controller = *_controller;
+	MessageReader reader(pRequest);
+	MessageWriter writer(pResponse);
+	std::string name;
+	std::string outputName;
+
+	uint32_t count = reader.ReadCount(1);
+	for (uint32_t op = 0; op < count && !reader.HasFailed(); ++op)
+	{
+		uint8_t serviceOp = reader.Read<uint8_t>();
+		switch (serviceOp)
+		{
+		case SERVICE_OP_IS_LISTENING:
+			reader.ReadString(name);
+			writer.WriteBool(controller.IsListening(name.c_str()));
+			break;
+		case SERVICE_OP_SET_LISTEN:
+		{
+			reader.ReadString(name);
+			bool listen = reader.ReadBool();
+			writer.WriteBool(controller.SetListenToAudioInputDevice(name.c_str(), listen));
+			break;
+		}
+		case SERVICE_OP_SET_LISTEN_BATCH:
+		case SERVICE_OP_GET_LISTEN_STATES:
+		{
+			bool isSet = (serviceOp == SERVICE_OP_SET_LISTEN_BATCH);
+			uint32_t n = reader.ReadCount(isSet ? 5 : 4);
+			// Names are kept in std::string, and passed to the controller as const char*.
+			std::vector<std::string> names(n);
+			std::vector<const char*> namesPointers(n);
+			std::unique_ptr<bool[]> listen(new bool[n + 1]);
+			std::unique_ptr<bool[]> results(new bool[n + 1]);
+			for (uint32_t i = 0; i < n; ++i)
+			{
+				reader.ReadString(names[i]);
+				namesPointers[i] = names[i].c_str();
+				listen[i] = isSet ? reader.ReadBool() : false;
+			}
+			if (reader.HasFailed()) break;
+
+			if (isSet)
+			{
+				writer.Write<int32_t>(controller.SetListenToAudioInputDevices(namesPointers.data(), listen.get(), (int)n, results.get()));
+				for (uint32_t i = 0; i < n; ++i)
+				{
+					writer.WriteBool(results[i]);
+				}
+			}
+			else
+			{
+				writer.Write<int32_t>(controller.GetListenStates(namesPointers.data(), (int)n, listen.get(), results.get()));
+				for (uint32_t i = 0; i < n; ++i)
+				{
+					writer.WriteBool(listen[i]);
+					writer.WriteBool(results[i]);
+				}
+			}
+			break;
+		}
+		case SERVICE_OP_SET_LISTEN_TARGET:
+		{
+			reader.ReadString(name);
+			bool listen = reader.ReadBool();
+			bool hasOutput = reader.ReadBool();
+			if (hasOutput)
+			{
+				reader.ReadString(outputName);
+			}
+			writer.WriteBool(controller.SetListenToAudioInputDeviceTarget(name.c_str(), listen, hasOutput ? outputName.c_str() : NULL));
+			break;
+		}
+		case SERVICE_OP_OPEN_DEVICE:
+			reader.ReadString(name);
+			writer.Write<uint64_t>(controller.OpenDevice(name.c_str()));
+			break;
+		case SERVICE_OP_IS_DEVICE_LISTENING:
+			writer.WriteBool(controller.IsDeviceListening(reader.Read<uint64_t>()));
+			break;
+		case SERVICE_OP_SET_LISTEN_TO_DEVICE:
+		{
+			WAIC_DeviceHandle device = reader.Read<uint64_t>();
+			bool listen = reader.ReadBool();
+			writer.WriteBool(controller.SetListenToDevice(device, listen));
+			break;
+		}
+		case SERVICE_OP_IS_DEVICE_HANDLE_VALID:
+			writer.WriteBool(controller.IsDeviceHandleValid(reader.Read<uint64_t>()));
+			break;
+		case SERVICE_OP_SET_LISTEN_TO_DEVICES:
+		case SERVICE_OP_GET_DEVICE_LISTEN_STATES:
+		{
+			bool isSet = (serviceOp == SERVICE_OP_SET_LISTEN_TO_DEVICES);
+			uint32_t n = reader.ReadCount(isSet ? 9 : 8);
+			std::vector<WAIC_DeviceHandle> devices(n);
+			std::unique_ptr<bool[]> listen(new bool[n + 1]);
+			std::unique_ptr<bool[]> results(new bool[n + 1]);
+			for (uint32_t i = 0; i < n; ++i)
+			{
+				devices[i] = reader.Read<uint64_t>();
+				listen[i] = isSet ? reader.ReadBool() : false;
+			}
+			if (reader.HasFailed()) break;
+
+			if (isSet)
+			{
+				writer.Write<int32_t>(controller.SetListenToDevices(devices.data(), listen.get(), (int)n, results.get()));
+				for (uint32_t i = 0; i < n; ++i)
+				{
+					writer.WriteBool(results[i]);
+				}
+			}
+			else
+			{
+				writer.Write<int32_t>(controller.GetDeviceListenStates(devices.data(), (int)n, listen.get(), results.get()));
+				for (uint32_t i = 0; i < n; ++i)
+				{
+					writer.WriteBool(listen[i]);
+					writer.WriteBool(results[i]);
+				}
+			}
+			break;
+		}
+		case SERVICE_OP_REFRESH:
+			writer.WriteBool(controller.RefreshAudioInputs());
+			break;
+		case SERVICE_OP_SNAPSHOT:
+		{
+			uint32_t capacity = reader.Read<uint32_t>();
+			int required = 0;
+			int n = controller.Snapshot(_snapshot.data(), (int)std::min<size_t>(_snapshot.size(), capacity), &required);
+			if (n < (int)std::min<uint32_t>((uint32_t)required, capacity))
+			{
+				// More endpoints than the last time.
+				_snapshot.resize(required);
+				n = controller.Snapshot(_snapshot.data(), (int)std::min<uint32_t>((uint32_t)required, capacity), &required);
+			}
+			writer.Write<int32_t>(required);
+			writer.Write<uint32_t>((uint32_t)n);
+			for (int i = 0; i < n; ++i)
+			{
+				writer.Write(_snapshot[i]);
+			}
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+	if (reader.HasFailed() || !reader.IsAtEnd())
+	{
+		return false;
+	}
+
+	int errorCount = controller.DrainErrors(_errors.data(), (int)_errors.size());
+	writer.Write<uint32_t>((uint32_t)errorCount);
+	for (int i = 0; i < errorCount; ++i)
+	{
+		writer.Write(_errors[i]);
+	}
+	return true;
+}
@@ -0,0 +1,209 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+
+#include "ControllerStats.h"
+
+static const char* GetStageName(int pStage)
+{
+	switch (pStage)
+	{
+	case WAIC_STAGE_ENUMERATE: return "enumerate";
+	case WAIC_STAGE_OPEN_PROPERTY_STORE: return "openPropertyStore";
+	case WAIC_STAGE_GET_VALUE: return "getValue";
+	case WAIC_STAGE_SET_VALUE: return "setValue";
+	case WAIC_STAGE_LOOKUP: return "lookup";
+	default: return "unknown";
+	}
+}
+
+static const char* GetCacheName(int pCache)
+{
+	switch (pCache)
+	{
+	case WAIC_CACHE_DEVICE: return "device";
+	case WAIC_CACHE_LISTEN_STATE: return "listenState";
+	case WAIC_CACHE_PROPERTY_STORE: return "propertyStore";
+	default: return "unknown";
+	}
+}
+
+static const char* GetFaultName(int pFault)
+{
+	switch (pFault)
+	{
+	case WAIC_FAULT_RETRY: return "retry";
+	case WAIC_FAULT_TIMEOUT: return "timeout";
+	case WAIC_FAULT_CIRCUIT_REJECTED: return "circuitRejected";
+	case WAIC_FAULT_CIRCUIT_OPENED: return "circuitOpened";
+	default: return "unknown";
+	}
+}
+
+// Upper bound of the bucket holding the pPercentile-th sample: the histograms only give latencies within a factor of 2.
+static uint64_t GetPercentileNs(const WAIC_StageStats& pStage, uint64_t pPercentile)
+{
+	if (pStage.count == 0) return 0;
+
+	uint64_t rank = (pStage.count * pPercentile + 99) / 100;
+	uint64_t cumulated = 0;
+	for (int i = 0; i < WAIC_STATS_BUCKETS - 1; ++i)
+	{
+		cumulated += pStage.buckets[i];
+		if (cumulated >= rank)
+		{
+			uint64_t upperBound = (2ull << i) - 1;
+			return (upperBound < pStage.maxNs) ? upperBound : pStage.maxNs;
+		}
+	}
+	return pStage.maxNs;
+}
+
+ControllerStats::ControllerStats()
+{
+	Reset();
+}
+
+#if WAIC_ENABLE_STATS
+void ControllerStats::RecordLatency(WAIC_Stage pStage, uint64_t pNanoseconds)
+{
+	// Bucket i holds the latencies in [2^i, 2^(i+1)) ns, the last one everything above.
+	int bucket = 0;
+	while (bucket < WAIC_STATS_BUCKETS - 1 && (pNanoseconds >> (bucket + 1)) != 0)
+	{
+		++bucket;
+	}
+
+	Stage& stage = _stages[pStage];
+	stage.count.fetch_add(1, std::memory_order_relaxed);
+	stage.totalNs.fetch_add(pNanoseconds, std::memory_order_relaxed);
+	stage.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+	uint64_t maxNs = stage.maxNs.load(std::memory_order_relaxed);
+	while (pNanoseconds > maxNs && !stage.maxNs.compare_exchange_weak(maxNs, pNanoseconds, std::memory_order_relaxed))
+	{
+	}
+}
+#endif
+
+void ControllerStats::Read(WAIC_Stats& pStats) const
+{
+	memset(&pStats, 0, sizeof(pStats));
+#if WAIC_ENABLE_STATS
+	pStats.enabled = true;
+	for (int i = 0; i < WAIC_STAGE_COUNT; ++i)
+	{
+		const Stage& stage = _stages[i];
+		WAIC_StageStats& stageStats = pStats.stages[i];
+		stageStats.count = stage.count.load(std::memory_order_relaxed);
+		stageStats.totalNs = stage.totalNs.load(std::memory_order_relaxed);
+		stageStats.maxNs = stage.maxNs.load(std::memory_order_relaxed);
+		for (int j = 0; j < WAIC_STATS_BUCKETS; ++j)
+		{
+			stageStats.buckets[j] = stage.buckets[j].load(std::memory_order_relaxed);
+		}
+	}
+	for (int i = 0; i < WAIC_CACHE_COUNT; ++i)
+	{
+		pStats.cacheHits[i] = _cacheHits[i].load(std::memory_order_relaxed);
+		pStats.cacheMisses[i] = _cacheMisses[i].load(std::memory_order_relaxed);
+	}
+	for (int i = 0; i < WAIC_FAULT_COUNT; ++i)
+	{
+		pStats.faults[i] = _faults[i].load(std::memory_order_relaxed);
+	}
+#else
+	pStats.enabled = false;
+#endif
+}
+
+void ControllerStats::Reset()
+{
+#if WAIC_ENABLE_STATS
+	for (Stage& stage : _stages)
+	{
+		stage.count.store(0, std::memory_order_relaxed);
+		stage.totalNs.store(0, std::memory_order_relaxed);
+		stage.maxNs.store(0, std::memory_order_relaxed);
+		for (std::atomic<uint64_t>& bucket : stage.buckets)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+	for (int i = 0; i < WAIC_CACHE_COUNT; ++i)
+	{
+		_cacheHits[i].store(0, std::memory_order_relaxed);
+		_cacheMisses[i].store(0, std::memory_order_relaxed);
+	}
+	for (std::atomic<uint64_t>& fault : _faults)
+	{
+		fault.store(0, std::memory_order_relaxed);
+	}
+#endif
+}
+
+void ControllerStats::FormatJson(const WAIC_Stats& pStats, std::string& pText)
+{
+	char number[32];
+	auto appendNumber = [&](const char* pName, uint64_t pValue)
+	{
+		snprintf(number, sizeof(number), "%llu", (unsigned long long)pValue);
+		pText.append("\"").append(pName).append("\":").append(number);
+	};
+
+	pText.append("{\"enabled\":").append(pStats.enabled ? "true" : "false").append(",\"stages\":{");
+	for (int i = 0; i < WAIC_STAGE_COUNT; ++i)
+	{
+		const WAIC_StageStats& stage = pStats.stages[i];
+		pText.append((i > 0) ? ",\"" : "\"").append(GetStageName(i)).append("\":{");
+		appendNumber("count", stage.count);
+		pText.append(",");
+		appendNumber("totalNs", stage.totalNs);
+		pText.append(",");
+		appendNumber("maxNs", stage.maxNs);
+		pText.append(",");
+		appendNumber("p50Ns", GetPercentileNs(stage, 50));
+		pText.append(",");
+		appendNumber("p99Ns", GetPercentileNs(stage, 99));
+		pText.append(",\"buckets\":[");
+		for (int j = 0; j < WAIC_STATS_BUCKETS; ++j)
+		{
+			snprintf(number, sizeof(number), (j > 0) ? ",%llu" : "%llu", (unsigned long long)stage.buckets[j]);
+			pText.append(number);
+		}
+		pText.append("]}");
+	}
+	pText.append("},\"caches\":{");
+	for (int i = 0; i < WAIC_CACHE_COUNT; ++i)
+	{
+		pText.append((i > 0) ? ",\"" : "\"").append(GetCacheName(i)).append("\":{");
+		appendNumber("hits", pStats.cacheHits[i]);
+		pText.append(",");
+		appendNumber("misses", pStats.cacheMisses[i]);
+		pText.append("}");
+	}
+	pText.append("},\"faults\":{");
+	for (int i = 0; i < WAIC_FAULT_COUNT; ++i)
+	{
+		if (i > 0) pText.append(",");
+		appendNumber(GetFaultName(i), pStats.faults[i]);
+	}
+	pText.append("}}");
+}
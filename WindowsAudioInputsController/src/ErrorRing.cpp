@@ -0,0 +1,171 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "ErrorRing.h"
+
+static const char* GetOperationName(int32_t pOperation)
+{
+	switch (pOperation)
+	{
+	case WAIC_OP_INIT: return "Init";
+	case WAIC_OP_IS_LISTENING: return "IsListening";
+	case WAIC_OP_SET_LISTEN: return "SetListenToAudioInputDevice";
+	case WAIC_OP_GET_LISTEN_STATES: return "GetListenStates";
+	case WAIC_OP_SET_LISTEN_BATCH: return "SetListenToAudioInputDevices";
+	case WAIC_OP_REFRESH: return "RefreshAudioInputs";
+	case WAIC_OP_OPEN_DEVICE: return "OpenDevice";
+	case WAIC_OP_OPEN_OUTPUT: return "OpenOutputDevice";
+	case WAIC_OP_SET_LISTEN_TARGET: return "SetListenToAudioInputDeviceTarget";
+	case WAIC_OP_SNAPSHOT: return "Snapshot";
+	case WAIC_OP_SAVE_PROFILE: return "SaveListenProfile";
+	case WAIC_OP_RESTORE_PROFILE: return "RestoreListenProfile";
+	case WAIC_OP_CONTINUE_ON_BATTERY: return "DeviceContinueOnBattery";
+	case WAIC_OP_LEVEL_METERING: return "LevelMetering";
+	case WAIC_OP_MONITOR: return "Monitor";
+	default: return "Unknown";
+	}
+}
+
+ErrorRing::ErrorRing() : _mutex(), _records(), _first(0), _count(0), _sequence(0), _dropped(0)
+{
+
+}
+
+void ErrorRing::Record(WAIC_ErrorCode pCode, WAIC_Operation pOperation, EndpointResult pResult, const char* pDevice, int pListen)
+{
+	int64_t timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	int count = _count.load(std::memory_order_relaxed);
+	int index = (_first + count) % CAPACITY;
+	if (count == CAPACITY)
+	{
+		// Full: overwrite the oldest record.
+		_first = (_first + 1) % CAPACITY;
+		++_dropped;
+	}
+	else
+	{
+		++count;
+	}
+
+	WAIC_ErrorRecord& record = _records[index];
+	record.sequence = ++_sequence;
+	record.timestampUs = timestampUs;
+	record.code = pCode;
+	record.operation = pOperation;
+	record.hresult = pResult;
+	record.listen = pListen;
+	record.device[0] = '\0';
+	if (pDevice != NULL)
+	{
+		strncpy(record.device, pDevice, WAIC_DEVICE_NAME_SIZE - 1);
+		record.device[WAIC_DEVICE_NAME_SIZE - 1] = '\0';
+	}
+	_count.store(count, std::memory_order_release);
+}
+
+int ErrorRing::Drain(WAIC_ErrorRecord* pRecords, int pCapacity)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	int count = _count.load(std::memory_order_relaxed);
+	int drained = (count < pCapacity) ? count : pCapacity;
+	for (int i = 0; i < drained; ++i)
+	{
+		pRecords[i] = _records[(_first + i) % CAPACITY];
+	}
+	_first = (_first + drained) % CAPACITY;
+	_count.store(count - drained, std::memory_order_release);
+	return drained;
+}
+
+void ErrorRing::Clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_first = 0;
+	_count.store(0, std::memory_order_release);
+}
+
+void ErrorRing::Format(const WAIC_ErrorRecord& pRecord, std::string& pText)
+{
+	pText.append("[WindowsAudioInputsController] ");
+	switch (pRecord.code)
+	{
+	case WAIC_ERROR_INIT_FAILED:
+		pText.append("Initialization failed !");
+		break;
+	case WAIC_ERROR_NOT_INITIALIZED:
+		pText.append("Audio endpoint provider is not initialized !");
+		break;
+	case WAIC_ERROR_DEVICE_NOT_FOUND:
+		pText.append("Audio device ").append(pRecord.device).append(" not found !");
+		break;
+	case WAIC_ERROR_ENUMERATION_FAILED:
+		pText.append("Audio inputs enumeration failed !");
+		break;
+	case WAIC_ERROR_INVALID_HANDLE:
+		pText.append(GetOperationName(pRecord.operation)).append(": invalid or stale device handle !");
+		break;
+	case WAIC_ERROR_OUTPUT_NOT_FOUND:
+		pText.append("Audio output device ").append(pRecord.device).append(" not found !");
+		break;
+	case WAIC_ERROR_INVALID_PROFILE:
+		pText.append("Invalid or unsupported listen profile !");
+		break;
+	case WAIC_ERROR_NOT_READY:
+		pText.append("Initialization in progress !");
+		break;
+	case WAIC_ERROR_SERVICE_UNAVAILABLE:
+		pText.append(GetOperationName(pRecord.operation)).append(": controller service unavailable !");
+		break;
+	case WAIC_ERROR_TOO_MANY_DEVICES:
+		pText.append("Too many opened audio devices, ").append(pRecord.device).append(" not opened !");
+		break;
+	default:
+		pText.append(GetOperationName(pRecord.operation)).append("(").append(pRecord.device);
+		if (pRecord.listen >= 0)
+		{
+			pText.append(", ").append(pRecord.listen != 0 ? "true" : "false");
+		}
+		if (pRecord.code == WAIC_ERROR_TIMEOUT)
+		{
+			pText.append(") timed out !");
+		}
+		else if (pRecord.code == WAIC_ERROR_CIRCUIT_OPEN)
+		{
+			pText.append(") rejected, the device is failing !");
+		}
+		else
+		{
+			pText.append(") failed !");
+		}
+		break;
+	}
+
+	if (pRecord.hresult != 0)
+	{
+		char hresult[24];
+		snprintf(hresult, sizeof(hresult), " (0x%08X)", (uint32_t)pRecord.hresult);
+		pText.append(hresult);
+	}
+	pText.append("\n");
+}
@@ -0,0 +1,60 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "EventQueue.h"
+
+EventQueue::EventQueue() : _events(), _head(0), _tail(0), _sequence(0), _dropped(0), _drainMutex()
+{
+
+}
+
+bool EventQueue::Push(WAIC_Event& pEvent)
+{
+	// Dropped events also take a sequence number, so that the consumer sees the gap.
+	pEvent.sequence = NextSequence();
+
+	uint32_t tail = _tail.load(std::memory_order_relaxed);
+	if (tail - _head.load(std::memory_order_acquire) == CAPACITY)
+	{
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	_events[tail & (CAPACITY - 1)] = pEvent;
+	_tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+int EventQueue::Drain(WAIC_Event* pEvents, int pCapacity)
+{
+	if (IsEmpty() || pCapacity <= 0) return 0;
+
+	std::lock_guard<std::mutex> lock(_drainMutex);
+	uint32_t head = _head.load(std::memory_order_relaxed);
+	uint32_t count = _tail.load(std::memory_order_acquire) - head;
+	if (count > (uint32_t)pCapacity)
+	{
+		count = (uint32_t)pCapacity;
+	}
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		pEvents[i] = _events[(head + i) & (CAPACITY - 1)];
+	}
+	_head.store(head + count, std::memory_order_release);
+	return (int)count;
+}
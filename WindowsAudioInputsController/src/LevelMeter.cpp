@@ -0,0 +1,251 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <chrono>
+#include <cmath>
+
+#include "LevelMeter.h"
+
+static int64_t GetTimestampUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+LevelMeter::LevelMeter() : _mutex(), _stopRequested(), _stop(false), _rateHz(0), _thread(), _watched(), _slots(), _slotCount(0)
+{
+	for (int i = 0; i < CAPACITY; ++i)
+	{
+		_watched[i].device = WAIC_INVALID_DEVICE;
+		_watched[i].peakCount = 0;
+		_watched[i].peakIndex = 0;
+		_slots[i].sequence = 0;
+		_slots[i].device = WAIC_INVALID_DEVICE;
+		_slots[i].timestampUs = 0;
+		_slots[i].peak = 0.0f;
+		_slots[i].rms = 0.0f;
+		_slots[i].hresult = 0;
+	}
+}
+
+LevelMeter::~LevelMeter()
+{
+	Stop();
+}
+
+bool LevelMeter::Start(IAudioEndpointProvider* pProvider, int pRateHz)
+{
+	if (pRateHz < MIN_RATE_HZ || pRateHz > MAX_RATE_HZ) return false;
+
+	Stop();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = false;
+		_rateHz = pRateHz;
+		// The RMS window depends on the rate.
+		for (Watched& watched : _watched)
+		{
+			watched.peakCount = 0;
+			watched.peakIndex = 0;
+		}
+	}
+	_thread = std::thread(&LevelMeter::_Run, this, pProvider);
+	return true;
+}
+
+void LevelMeter::Stop()
+{
+	if (!_thread.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_stopRequested.notify_one();
+	_thread.join();
+}
+
+bool LevelMeter::Watch(WAIC_DeviceHandle pDevice, std::unique_ptr<IEndpointMeter>& pMeter)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	int freeIndex = -1;
+	for (int i = 0; i < CAPACITY; ++i)
+	{
+		if (_watched[i].device == pDevice) return true;
+		if (freeIndex < 0 && _watched[i].device == WAIC_INVALID_DEVICE)
+		{
+			freeIndex = i;
+		}
+	}
+	if (freeIndex < 0) return false;
+
+	Watched& watched = _watched[freeIndex];
+	watched.device = pDevice;
+	watched.meter = std::move(pMeter);
+	watched.peakCount = 0;
+	watched.peakIndex = 0;
+	// Listed with a zero level until its first sample.
+	_Publish(freeIndex, pDevice, 0, 0.0f, 0.0f, 0);
+	if (freeIndex >= _slotCount.load(std::memory_order_relaxed))
+	{
+		_slotCount.store(freeIndex + 1, std::memory_order_release);
+	}
+	return true;
+}
+
+void LevelMeter::Unwatch(WAIC_DeviceHandle pDevice)
+{
+	std::unique_ptr<IEndpointMeter> meter;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (int i = 0; i < CAPACITY; ++i)
+		{
+			if (_watched[i].device == pDevice)
+			{
+				_watched[i].device = WAIC_INVALID_DEVICE;
+				meter = std::move(_watched[i].meter);
+				_Publish(i, WAIC_INVALID_DEVICE, 0, 0.0f, 0.0f, 0);
+				break;
+			}
+		}
+	}
+	// Released out of the lock: it can be a backend call.
+}
+
+void LevelMeter::UnwatchAll()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (int i = 0; i < CAPACITY; ++i)
+	{
+		if (_watched[i].device != WAIC_INVALID_DEVICE)
+		{
+			_watched[i].device = WAIC_INVALID_DEVICE;
+			_watched[i].meter.reset();
+			_Publish(i, WAIC_INVALID_DEVICE, 0, 0.0f, 0.0f, 0);
+		}
+	}
+	_slotCount.store(0, std::memory_order_release);
+}
+
+int LevelMeter::Read(WAIC_Level* pLevels, int pCapacity) const
+{
+	int count = 0;
+	int slotCount = _slotCount.load(std::memory_order_acquire);
+	for (int i = 0; i < slotCount && count < pCapacity; ++i)
+	{
+		const Slot& slot = _slots[i];
+		WAIC_Level level;
+		uint32_t sequence;
+		do
+		{
+			// Retries while the sampler thread writes the slot (a few stores).
+			do
+			{
+				sequence = slot.sequence.load(std::memory_order_acquire);
+			} while ((sequence & 1) != 0);
+
+			level.device = slot.device.load(std::memory_order_relaxed);
+			level.timestampUs = slot.timestampUs.load(std::memory_order_relaxed);
+			level.peak = slot.peak.load(std::memory_order_relaxed);
+			level.rms = slot.rms.load(std::memory_order_relaxed);
+			level.hresult = slot.hresult.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while (slot.sequence.load(std::memory_order_relaxed) != sequence);
+
+		if (level.device != WAIC_INVALID_DEVICE)
+		{
+			pLevels[count++] = level;
+		}
+	}
+	return count;
+}
+
+void LevelMeter::_Run(IAudioEndpointProvider* pProvider)
+{
+	pProvider->InitializeThread();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	std::chrono::nanoseconds period(1000000000 / _rateHz);
+	int windowSize = _rateHz * RMS_WINDOW_MS / 1000;
+	windowSize = (windowSize > 0) ? windowSize : 1;
+	std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+	while (!_stop)
+	{
+		int64_t timestampUs = GetTimestampUs();
+		int slotCount = _slotCount.load(std::memory_order_relaxed);
+		for (int i = 0; i < slotCount; ++i)
+		{
+			if (_watched[i].device != WAIC_INVALID_DEVICE)
+			{
+				_Sample(i, windowSize, timestampUs);
+			}
+		}
+
+		// Fixed rate: a late tick does not delay the next ones, missed ticks are skipped.
+		next += period;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (next < now)
+		{
+			next = now;
+		}
+		_stopRequested.wait_until(lock, next, [this] { return _stop; });
+	}
+	lock.unlock();
+
+	pProvider->UninitializeThread();
+}
+
+void LevelMeter::_Sample(int pIndex, int pWindowSize, int64_t pTimestampUs)
+{
+	Watched& watched = _watched[pIndex];
+	float peak = 0.0f;
+	EndpointResult hr = watched.meter->GetPeakValue(peak);
+	if (!EndpointSucceeded(hr))
+	{
+		// Keeps the device listed with a zero level: the caller sees the failure (eg. the device has been unplugged).
+		watched.peakCount = 0;
+		watched.peakIndex = 0;
+		_Publish(pIndex, watched.device, pTimestampUs, 0.0f, 0.0f, hr);
+		return;
+	}
+
+	watched.peaks[watched.peakIndex] = peak;
+	watched.peakIndex = (watched.peakIndex + 1) % pWindowSize;
+	watched.peakCount += (watched.peakCount < pWindowSize) ? 1 : 0;
+
+	float sumSquares = 0.0f;
+	for (int i = 0; i < watched.peakCount; ++i)
+	{
+		sumSquares += watched.peaks[i] * watched.peaks[i];
+	}
+	_Publish(pIndex, watched.device, pTimestampUs, peak, sqrtf(sumSquares / (float)watched.peakCount), 0);
+}
+
+void LevelMeter::_Publish(int pIndex, WAIC_DeviceHandle pDevice, int64_t pTimestampUs, float pPeak, float pRms, int32_t pResult)
+{
+	// Called under _mutex: a single writer at a time.
+	Slot& slot = _slots[pIndex];
+	uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+	slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.device.store(pDevice, std::memory_order_relaxed);
+	slot.timestampUs.store(pTimestampUs, std::memory_order_relaxed);
+	slot.peak.store(pPeak, std::memory_order_relaxed);
+	slot.rms.store(pRms, std::memory_order_relaxed);
+	slot.hresult.store(pResult, std::memory_order_relaxed);
+	slot.sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,100 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <cstring>
+
+#include "ListenProfile.h"
+
+static const char PROFILE_MAGIC[4] = { 'W', 'A', 'I', 'P' };
+static const size_t HEADER_SIZE = 8;
+static const size_t ENTRY_HEADER_SIZE = 6;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////// HELPERS /////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void WriteUInt16(uint8_t* pBuffer, uint16_t pValue)
+{
+	pBuffer[0] = (uint8_t)(pValue & 0xFF);
+	pBuffer[1] = (uint8_t)(pValue >> 8);
+}
+
+static uint16_t ReadUInt16(const uint8_t* pBuffer)
+{
+	return (uint16_t)(pBuffer[0] | (pBuffer[1] << 8));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////// ListenProfile //////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+size_t ListenProfile::Write(const std::vector<ListenProfileEntry>& pEntries, uint8_t* pBuffer, size_t pSize)
+{
+	if (pEntries.size() > MAX_ENTRIES) return 0;
+
+	size_t size = HEADER_SIZE;
+	for (const ListenProfileEntry& entry : pEntries)
+	{
+		if (entry.endpointId.size() > MAX_STRING_SIZE || entry.listenTarget.size() > MAX_STRING_SIZE) return 0;
+		size += ENTRY_HEADER_SIZE + entry.endpointId.size() + entry.listenTarget.size();
+	}
+	if (pBuffer == NULL || size > pSize) return size;
+
+	memcpy(pBuffer, PROFILE_MAGIC, sizeof(PROFILE_MAGIC));
+	WriteUInt16(pBuffer + 4, VERSION);
+	WriteUInt16(pBuffer + 6, (uint16_t)pEntries.size());
+	uint8_t* data = pBuffer + HEADER_SIZE;
+	for (const ListenProfileEntry& entry : pEntries)
+	{
+		data[0] = entry.listen ? 1 : 0;
+		data[1] = 0;
+		WriteUInt16(data + 2, (uint16_t)entry.endpointId.size());
+		WriteUInt16(data + 4, (uint16_t)entry.listenTarget.size());
+		data += ENTRY_HEADER_SIZE;
+		memcpy(data, entry.endpointId.data(), entry.endpointId.size());
+		data += entry.endpointId.size();
+		memcpy(data, entry.listenTarget.data(), entry.listenTarget.size());
+		data += entry.listenTarget.size();
+	}
+	return size;
+}
+
+bool ListenProfile::Read(const uint8_t* pBuffer, size_t pSize, std::vector<ListenProfileEntry>& pEntries)
+{
+	pEntries.clear();
+	if (pBuffer == NULL || pSize < HEADER_SIZE || memcmp(pBuffer, PROFILE_MAGIC, sizeof(PROFILE_MAGIC)) != 0) return false;
+	if (ReadUInt16(pBuffer + 4) != VERSION) return false;
+
+	size_t count = ReadUInt16(pBuffer + 6);
+	pEntries.resize(count);
+	const uint8_t* data = pBuffer + HEADER_SIZE;
+	const uint8_t* end = pBuffer + pSize;
+	for (ListenProfileEntry& entry : pEntries)
+	{
+		if ((size_t)(end - data) < ENTRY_HEADER_SIZE) return false;
+		size_t idLength = ReadUInt16(data + 2);
+		size_t targetLength = ReadUInt16(data + 4);
+		entry.listen = (data[0] != 0);
+		data += ENTRY_HEADER_SIZE;
+		if ((size_t)(end - data) < idLength + targetLength) return false;
+
+		entry.endpointId.assign((const char*)data, idLength);
+		data += idLength;
+		entry.listenTarget.assign((const char*)data, targetLength);
+		data += targetLength;
+	}
+	return data == end;
+}
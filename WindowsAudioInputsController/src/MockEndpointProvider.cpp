@@ -0,0 +1,691 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "MockEndpointProvider.h"
+#include "SampleConversion.h"
+
+struct MockEndpointProvider::Endpoint
+{
+	EndpointInfo info;
+	bool removed;
+	// Creation order, gives each endpoint its own synthetic level.
+	int index;
+	// Peak level returned by the meters, negative for the synthetic one.
+	float level;
+	// Mix format of the streams.
+	EndpointStreamFormat format;
+	// Written to the render streams.
+	uint64_t renderedFrames;
+	float renderedPeak;
+	std::vector<std::pair<EndpointPropertyKey, EndpointPropertyValue>> properties;
+
+	EndpointPropertyValue* FindProperty(const EndpointPropertyKey& pKey)
+	{
+		for (auto& it : properties)
+		{
+			if (it.first == pKey)
+			{
+				return &it.second;
+			}
+		}
+		return NULL;
+	}
+
+	void SetProperty(const EndpointPropertyKey& pKey, const EndpointPropertyValue& pValue)
+	{
+		EndpointPropertyValue* value = FindProperty(pKey);
+		if (value != NULL)
+		{
+			*value = pValue;
+		}
+		else
+		{
+			properties.emplace_back(pKey, pValue);
+		}
+		// As on Windows, the name of the endpoint is its friendly name property.
+		if (pKey == ENDPOINT_PKEY_FRIENDLY_NAME && pValue.type == EndpointPropertyValue::String)
+		{
+			info.friendlyName = pValue.stringValue;
+		}
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// Mock endpoint & store /////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+class MockPropertyStore : public IEndpointPropertyStore
+{
+public:
+	MockPropertyStore(const MockEndpointProvider* pProvider, const std::shared_ptr<MockEndpointProvider::Endpoint>& pEndpoint, bool pReadWrite)
+		: _provider(pProvider), _endpoint(pEndpoint), _readWrite(pReadWrite) {}
+
+	EndpointResult GetValue(const EndpointPropertyKey& pKey, EndpointPropertyValue& pValue) override
+	{
+		EndpointResult hr = _provider->SimulateCall(MOCK_CALL_GET_VALUE, &_endpoint->info.id);
+		if (!EndpointSucceeded(hr)) return hr;
+		std::lock_guard<std::mutex> lock(_provider->GetMutex());
+		if (_endpoint->removed) return ENDPOINT_E_DEVICE_INVALIDATED;
+
+		EndpointPropertyValue* value = _endpoint->FindProperty(pKey);
+		pValue = (value != NULL) ? *value : EndpointPropertyValue();
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult SetValue(const EndpointPropertyKey& pKey, const EndpointPropertyValue& pValue) override
+	{
+		if (!_readWrite) return ENDPOINT_E_INVALIDARG;
+
+		EndpointResult hr = _provider->SimulateCall(MOCK_CALL_SET_VALUE, &_endpoint->info.id);
+		if (!EndpointSucceeded(hr)) return hr;
+		{
+			std::lock_guard<std::mutex> lock(_provider->GetMutex());
+			if (_endpoint->removed) return ENDPOINT_E_DEVICE_INVALIDATED;
+
+			_endpoint->SetProperty(pKey, pValue);
+		}
+		_provider->NotifyPropertyChanged(_endpoint->info.id, pKey);
+		return ENDPOINT_OK;
+	}
+
+private:
+	const MockEndpointProvider* _provider;
+	std::shared_ptr<MockEndpointProvider::Endpoint> _endpoint;
+	bool _readWrite;
+};
+
+class MockEndpointMeter : public IEndpointMeter
+{
+public:
+	MockEndpointMeter(const MockEndpointProvider* pProvider, const std::shared_ptr<MockEndpointProvider::Endpoint>& pEndpoint)
+		: _provider(pProvider), _endpoint(pEndpoint) {}
+
+	EndpointResult GetPeakValue(float& pPeak) override
+	{
+		pPeak = 0.0f;
+		EndpointResult hr = _provider->SimulateCall(MOCK_CALL_GET_VALUE, &_endpoint->info.id);
+		if (!EndpointSucceeded(hr)) return hr;
+		int index = 0;
+		{
+			std::lock_guard<std::mutex> lock(_provider->GetMutex());
+			if (_endpoint->removed) return ENDPOINT_E_DEVICE_INVALIDATED;
+
+			if (_endpoint->level >= 0.0f)
+			{
+				pPeak = _endpoint->level;
+				return ENDPOINT_OK;
+			}
+			index = _endpoint->index;
+		}
+
+		// Synthetic level: a sine between 0.05 and 0.95, from 0.5 Hz to 4 Hz depending on the endpoint.
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		double frequency = 0.5 * (1 + index % 8);
+		pPeak = (float)(0.5 + 0.45 * sin(2.0 * 3.14159265358979 * frequency * seconds));
+		return ENDPOINT_OK;
+	}
+
+private:
+	const MockEndpointProvider* _provider;
+	std::shared_ptr<MockEndpointProvider::Endpoint> _endpoint;
+};
+
+// Real-time stream driven by the steady clock. Capture streams produce a 440 Hz sine (-6 dB) on every channel,
+// render streams play the written frames at the stream rate (silence when none is queued).
+class MockEndpointStream : public IEndpointStream
+{
+public:
+	MockEndpointStream(const MockEndpointProvider* pProvider, const std::shared_ptr<MockEndpointProvider::Endpoint>& pEndpoint, const EndpointStreamFormat& pFormat,
+		uint32_t pBufferFrames, uint32_t pPeriodFrames, bool pCapture)
+		: _provider(pProvider), _endpoint(pEndpoint), _format(pFormat), _bufferFrames(pBufferFrames), _periodFrames(pPeriodFrames), _capture(pCapture),
+		_started(false), _start(), _periods(0), _frames(0), _clockFrames(0), _playedFrames(0), _buffer(), _samples() {}
+
+	bool IsCapture()const override { return _capture; }
+	const EndpointStreamFormat& GetFormat()const override { return _format; }
+	uint32_t GetBufferFrames()const override { return _bufferFrames; }
+	uint32_t GetPeriodFrames()const override { return _periodFrames; }
+	uint32_t GetLatencyFrames()const override { return _periodFrames; }
+
+	EndpointResult Start() override
+	{
+		_start = std::chrono::steady_clock::now();
+		_started = true;
+		_periods = 0;
+		_clockFrames = 0;
+		_playedFrames = _capture ? 0 : _playedFrames;
+		_frames = _capture ? 0 : _frames;
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult Stop() override
+	{
+		_started = false;
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult WaitPeriod(uint32_t pTimeoutMs) override
+	{
+		if (_IsRemoved()) return ENDPOINT_E_DEVICE_INVALIDATED;
+
+		std::chrono::steady_clock::time_point timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(pTimeoutMs);
+		if (!_started)
+		{
+			std::this_thread::sleep_until(timeout);
+			return ENDPOINT_S_FALSE;
+		}
+
+		std::chrono::steady_clock::time_point next = _start + std::chrono::nanoseconds((_periods + 1) * _periodFrames * 1000000000ull / _format.sampleRate);
+		if (next > timeout)
+		{
+			std::this_thread::sleep_until(timeout);
+			return ENDPOINT_S_FALSE;
+		}
+		std::this_thread::sleep_until(next);
+		++_periods;
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult ReadPacket(const uint8_t*& pData, uint32_t& pFrames, bool& pSilent) override
+	{
+		pData = NULL;
+		pFrames = 0;
+		pSilent = false;
+		if (!_capture) return ENDPOINT_E_INVALIDARG;
+		if (_IsRemoved()) return ENDPOINT_E_DEVICE_INVALIDATED;
+
+		// _frames: captured frames already read. The oldest ones are lost when the buffer is full, as with a real device.
+		uint64_t elapsed = _GetElapsedFrames();
+		if (elapsed - _frames > _bufferFrames)
+		{
+			_frames = elapsed - _bufferFrames;
+		}
+		if (elapsed - _frames < _periodFrames) return ENDPOINT_OK;
+
+		pFrames = _periodFrames;
+		_samples.resize(pFrames * _format.channels);
+		for (uint32_t frame = 0; frame < pFrames; ++frame)
+		{
+			float sample = 0.5f * (float)sin(2.0 * 3.14159265358979 * 440.0 * (double)(_frames + frame) / (double)_format.sampleRate);
+			for (uint16_t c = 0; c < _format.channels; ++c)
+			{
+				_samples[frame * _format.channels + c] = sample;
+			}
+		}
+		_buffer.resize(pFrames * _format.GetFrameSize());
+		ConvertFromFloat(_format.sampleType, _samples.data(), _buffer.data(), _samples.size());
+		pData = _buffer.data();
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult ReleasePacket(uint32_t pFrames) override
+	{
+		_frames += pFrames;
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult GetPadding(uint32_t& pFrames) override
+	{
+		pFrames = 0;
+		if (_capture) return ENDPOINT_E_INVALIDARG;
+		if (_IsRemoved()) return ENDPOINT_E_DEVICE_INVALIDATED;
+
+		// _frames: written frames. The device plays one frame per sample period, when there is one to play.
+		uint64_t elapsed = _started ? _GetElapsedFrames() : _clockFrames;
+		_playedFrames = std::min<uint64_t>(_frames, _playedFrames + (elapsed - _clockFrames));
+		_clockFrames = elapsed;
+		pFrames = (uint32_t)(_frames - _playedFrames);
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult GetWriteBuffer(uint32_t pFrames, uint8_t*& pData) override
+	{
+		pData = NULL;
+		uint32_t padding = 0;
+		EndpointResult hr = GetPadding(padding);
+		if (!EndpointSucceeded(hr)) return hr;
+		if (padding + pFrames > _bufferFrames) return ENDPOINT_E_INVALIDARG;
+
+		_buffer.resize(pFrames * _format.GetFrameSize());
+		pData = _buffer.data();
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult ReleaseWriteBuffer(uint32_t pFrames) override
+	{
+		_samples.resize(pFrames * _format.channels);
+		ConvertToFloat(_format.sampleType, _buffer.data(), _samples.data(), _samples.size());
+		float peak = 0.0f;
+		for (float sample : _samples)
+		{
+			peak = std::max(peak, fabsf(sample));
+		}
+		_frames += pFrames;
+
+		std::lock_guard<std::mutex> lock(_provider->GetMutex());
+		_endpoint->renderedFrames += pFrames;
+		_endpoint->renderedPeak = peak;
+		return ENDPOINT_OK;
+	}
+
+private:
+	bool _IsRemoved()const
+	{
+		std::lock_guard<std::mutex> lock(_provider->GetMutex());
+		return _endpoint->removed;
+	}
+
+	uint64_t _GetElapsedFrames()const
+	{
+		uint64_t elapsedNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+		return elapsedNs * _format.sampleRate / 1000000000ull;
+	}
+
+private:
+	const MockEndpointProvider* _provider;
+	std::shared_ptr<MockEndpointProvider::Endpoint> _endpoint;
+	EndpointStreamFormat _format;
+	uint32_t _bufferFrames;
+	uint32_t _periodFrames;
+	bool _capture;
+	bool _started;
+	std::chrono::steady_clock::time_point _start;
+	uint64_t _periods;
+	uint64_t _frames;
+	uint64_t _clockFrames;
+	uint64_t _playedFrames;
+	std::vector<uint8_t> _buffer;
+	std::vector<float> _samples;
+};
+
+class MockAudioEndpoint : public IAudioEndpoint
+{
+public:
+	MockAudioEndpoint(const MockEndpointProvider* pProvider, const std::shared_ptr<MockEndpointProvider::Endpoint>& pEndpoint)
+		: _provider(pProvider), _endpoint(pEndpoint), _id(pEndpoint->info.id) {}
+
+	const std::string& GetId()const override { return _id; }
+
+	EndpointResult OpenPropertyStore(bool pReadWrite, std::unique_ptr<IEndpointPropertyStore>& pStore) override
+	{
+		EndpointResult hr = _provider->SimulateCall(MOCK_CALL_OPEN, &_id);
+		if (!EndpointSucceeded(hr)) return hr;
+		{
+			std::lock_guard<std::mutex> lock(_provider->GetMutex());
+			if (_endpoint->removed) return ENDPOINT_E_DEVICE_INVALIDATED;
+		}
+		pStore.reset(new MockPropertyStore(_provider, _endpoint, pReadWrite));
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult OpenMeter(std::unique_ptr<IEndpointMeter>& pMeter) override
+	{
+		EndpointResult hr = _provider->SimulateCall(MOCK_CALL_OPEN, &_id);
+		if (!EndpointSucceeded(hr)) return hr;
+		{
+			std::lock_guard<std::mutex> lock(_provider->GetMutex());
+			if (_endpoint->removed) return ENDPOINT_E_DEVICE_INVALIDATED;
+		}
+		pMeter.reset(new MockEndpointMeter(_provider, _endpoint));
+		return ENDPOINT_OK;
+	}
+
+	EndpointResult OpenStream(uint32_t pBufferUs, uint32_t pSampleRate, std::unique_ptr<IEndpointStream>& pStream) override
+	{
+		EndpointResult hr = _provider->SimulateCall(MOCK_CALL_OPEN, &_id);
+		if (!EndpointSucceeded(hr)) return hr;
+		EndpointStreamFormat format;
+		bool capture = false;
+		{
+			std::lock_guard<std::mutex> lock(_provider->GetMutex());
+			if (_endpoint->removed) return ENDPOINT_E_DEVICE_INVALIDATED;
+			format = _endpoint->format;
+			capture = (_endpoint->info.flow == EndpointFlow::Capture);
+		}
+		if (pSampleRate != 0)
+		{
+			format.sampleRate = pSampleRate;
+		}
+
+		// As in shared mode: the buffer holds at least two periods of at least 1 ms.
+		uint32_t periodFrames = std::max<uint32_t>(format.sampleRate / 1000, (uint32_t)((uint64_t)pBufferUs * format.sampleRate / 2000000));
+		pStream.reset(new MockEndpointStream(_provider, _endpoint, format, 2 * periodFrames, periodFrames, capture));
+		return ENDPOINT_OK;
+	}
+
+private:
+	const MockEndpointProvider* _provider;
+	std::shared_ptr<MockEndpointProvider::Endpoint> _endpoint;
+	std::string _id;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// MockEndpointProvider //////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+MockEndpointProvider::MockEndpointProvider() : _mutex(), _endpoints(), _endpointsById(), _notificationClients(), _latencyUs(0), _callCount(0), _writeCount(0),
+	_hasFaults(false), _faultsMutex(), _faults(), _faultRandom(), _injectedFaults(0)
+{
+
+}
+
+MockEndpointProvider::~MockEndpointProvider()
+{
+
+}
+
+EndpointResult MockEndpointProvider::Initialize()
+{
+	return ENDPOINT_OK;
+}
+
+EndpointResult MockEndpointProvider::InitializeThread()
+{
+	return ENDPOINT_OK;
+}
+
+void MockEndpointProvider::UninitializeThread()
+{
+
+}
+
+EndpointResult MockEndpointProvider::EnumerateEndpoints(EndpointFlow pFlow, uint32_t pStateMask, std::vector<EndpointInfo>& pEndpoints)
+{
+	pEndpoints.clear();
+	EndpointResult hr = SimulateCall(MOCK_CALL_ENUMERATE);
+	if (!EndpointSucceeded(hr)) return hr;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (const auto& endpoint : _endpoints)
+	{
+		if (endpoint->info.flow == pFlow && (endpoint->info.state & pStateMask) != 0)
+		{
+			pEndpoints.push_back(endpoint->info);
+		}
+	}
+	return ENDPOINT_OK;
+}
+
+EndpointResult MockEndpointProvider::GetDefaultEndpointId(EndpointFlow pFlow, std::string& pEndpointId)
+{
+	pEndpointId.clear();
+	EndpointResult hr = SimulateCall(MOCK_CALL_ENUMERATE);
+	if (!EndpointSucceeded(hr)) return hr;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	// The first active endpoint of the flow.
+	for (const auto& endpoint : _endpoints)
+	{
+		if (endpoint->info.flow == pFlow && endpoint->info.state == ENDPOINT_STATE_ACTIVE)
+		{
+			pEndpointId = endpoint->info.id;
+			return ENDPOINT_OK;
+		}
+	}
+	return ENDPOINT_E_NOTFOUND;
+}
+
+EndpointResult MockEndpointProvider::GetEndpointInfo(const std::string& pEndpointId, EndpointInfo& pInfo)
+{
+	EndpointResult hr = SimulateCall(MOCK_CALL_ENUMERATE, &pEndpointId);
+	if (!EndpointSucceeded(hr)) return hr;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _endpointsById.find(pEndpointId);
+	if (it == _endpointsById.end()) return ENDPOINT_E_NOTFOUND;
+
+	pInfo = it->second->info;
+	return ENDPOINT_OK;
+}
+
+EndpointResult MockEndpointProvider::OpenEndpoint(const std::string& pEndpointId, std::unique_ptr<IAudioEndpoint>& pEndpoint)
+{
+	EndpointResult hr = SimulateCall(MOCK_CALL_OPEN, &pEndpointId);
+	if (!EndpointSucceeded(hr)) return hr;
+
+	std::shared_ptr<Endpoint> endpoint = _Find(pEndpointId);
+	if (endpoint == NULL) return ENDPOINT_E_NOTFOUND;
+
+	pEndpoint.reset(new MockAudioEndpoint(this, endpoint));
+	return ENDPOINT_OK;
+}
+
+EndpointResult MockEndpointProvider::RegisterNotificationClient(IEndpointNotificationClient* pClient)
+{
+	if (pClient == NULL) return ENDPOINT_E_INVALIDARG;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_notificationClients.push_back(pClient);
+	return ENDPOINT_OK;
+}
+
+EndpointResult MockEndpointProvider::UnregisterNotificationClient(IEndpointNotificationClient* pClient)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = std::find(_notificationClients.begin(), _notificationClients.end(), pClient);
+	if (it == _notificationClients.end()) return ENDPOINT_E_NOTFOUND;
+
+	_notificationClients.erase(it);
+	return ENDPOINT_OK;
+}
+
+bool MockEndpointProvider::AddEndpoint(EndpointFlow pFlow, const std::string& pEndpointId, const std::string& pFriendlyName, uint32_t pState)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_endpointsById.find(pEndpointId) != _endpointsById.end()) return false;
+
+		std::shared_ptr<Endpoint> endpoint = std::make_shared<Endpoint>();
+		endpoint->info.id = pEndpointId;
+		endpoint->info.friendlyName = pFriendlyName;
+		endpoint->info.flow = pFlow;
+		endpoint->info.state = pState;
+		endpoint->removed = false;
+		endpoint->index = (int)_endpoints.size();
+		endpoint->level = -1.0f;
+		// Usual shared mode formats: 16 bits microphones, float mix on the outputs.
+		endpoint->format.sampleRate = 48000;
+		endpoint->format.channels = 2;
+		endpoint->format.sampleType = (pFlow == EndpointFlow::Capture) ? EndpointSampleType::Int16 : EndpointSampleType::Float32;
+		endpoint->renderedFrames = 0;
+		endpoint->renderedPeak = 0.0f;
+		endpoint->SetProperty(ENDPOINT_PKEY_FRIENDLY_NAME, EndpointPropertyValue::FromString(pFriendlyName));
+
+		_endpoints.push_back(endpoint);
+		_endpointsById[pEndpointId] = endpoint;
+	}
+
+	for (IEndpointNotificationClient* client : _GetNotificationClients())
+	{
+		client->OnEndpointAdded(pEndpointId);
+	}
+	return true;
+}
+
+void MockEndpointProvider::AddCaptureEndpoints(int pCount, const std::string& pNamePrefix)
+{
+	for (int i = 0; i < pCount; ++i)
+	{
+		std::string index = std::to_string(i);
+		AddEndpoint(EndpointFlow::Capture, "{mock.capture." + index + "}", pNamePrefix + " " + index);
+	}
+}
+
+bool MockEndpointProvider::RemoveEndpoint(const std::string& pEndpointId)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _endpointsById.find(pEndpointId);
+		if (it == _endpointsById.end()) return false;
+
+		// Endpoints/stores still opened on it will now fail, as a real unplugged device.
+		it->second->removed = true;
+		_endpoints.erase(std::find(_endpoints.begin(), _endpoints.end(), it->second));
+		_endpointsById.erase(it);
+	}
+
+	for (IEndpointNotificationClient* client : _GetNotificationClients())
+	{
+		client->OnEndpointRemoved(pEndpointId);
+	}
+	return true;
+}
+
+bool MockEndpointProvider::SetEndpointState(const std::string& pEndpointId, uint32_t pState)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _endpointsById.find(pEndpointId);
+		if (it == _endpointsById.end()) return false;
+
+		it->second->info.state = pState;
+	}
+
+	for (IEndpointNotificationClient* client : _GetNotificationClients())
+	{
+		client->OnEndpointStateChanged(pEndpointId, pState);
+	}
+	return true;
+}
+
+bool MockEndpointProvider::SetEndpointFormat(const std::string& pEndpointId, const EndpointStreamFormat& pFormat)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _endpointsById.find(pEndpointId);
+	if (it == _endpointsById.end()) return false;
+
+	it->second->format = pFormat;
+	return true;
+}
+
+bool MockEndpointProvider::GetRenderedFrames(const std::string& pEndpointId, uint64_t& pFrames, float& pLastPeak)const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _endpointsById.find(pEndpointId);
+	if (it == _endpointsById.end()) return false;
+
+	pFrames = it->second->renderedFrames;
+	pLastPeak = it->second->renderedPeak;
+	return true;
+}
+
+bool MockEndpointProvider::SetEndpointLevel(const std::string& pEndpointId, float pPeak)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _endpointsById.find(pEndpointId);
+	if (it == _endpointsById.end()) return false;
+
+	it->second->level = pPeak;
+	return true;
+}
+
+bool MockEndpointProvider::SetEndpointProperty(const std::string& pEndpointId, const EndpointPropertyKey& pKey, const EndpointPropertyValue& pValue)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _endpointsById.find(pEndpointId);
+		if (it == _endpointsById.end()) return false;
+
+		it->second->SetProperty(pKey, pValue);
+	}
+	NotifyPropertyChanged(pEndpointId, pKey);
+	return true;
+}
+
+bool MockEndpointProvider::GetEndpointProperty(const std::string& pEndpointId, const EndpointPropertyKey& pKey, EndpointPropertyValue& pValue) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _endpointsById.find(pEndpointId);
+	if (it == _endpointsById.end()) return false;
+
+	EndpointPropertyValue* value = it->second->FindProperty(pKey);
+	pValue = (value != NULL) ? *value : EndpointPropertyValue();
+	return true;
+}
+
+void MockEndpointProvider::AddFault(const MockFault& pFault)
+{
+	std::lock_guard<std::mutex> lock(_faultsMutex);
+	_faults.push_back(pFault);
+	_hasFaults = true;
+}
+
+void MockEndpointProvider::ClearFaults()
+{
+	std::lock_guard<std::mutex> lock(_faultsMutex);
+	_faults.clear();
+	_hasFaults = false;
+}
+
+void MockEndpointProvider::SetFaultSeed(uint64_t pSeed)
+{
+	std::lock_guard<std::mutex> lock(_faultsMutex);
+	_faultRandom.seed(pSeed);
+}
+
+EndpointResult MockEndpointProvider::SimulateCall(MockCall pCall, const std::string* pEndpointId) const
+{
+	++_callCount;
+	if (pCall == MOCK_CALL_SET_VALUE) ++_writeCount;
+	int64_t latencyUs = _latencyUs;
+	EndpointResult hr = ENDPOINT_OK;
+	if (_hasFaults.load(std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> lock(_faultsMutex);
+		for (MockFault& fault : _faults)
+		{
+			if ((fault.calls & pCall) == 0 || fault.count == 0) continue;
+			if (!fault.endpointId.empty() && (pEndpointId == NULL || *pEndpointId != fault.endpointId)) continue;
+			// Drawn with the 53 high bits, so that a seed gives the same draws on every platform.
+			if (fault.probability < 1.0 && (double)(_faultRandom() >> 11) * (1.0 / 9007199254740992.0) >= fault.probability) continue;
+
+			if (fault.count > 0) --fault.count;
+			++_injectedFaults;
+			latencyUs += fault.stall.count();
+			hr = fault.result;
+			break;
+		}
+	}
+	if (latencyUs > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(latencyUs));
+	}
+	return hr;
+}
+
+void MockEndpointProvider::NotifyPropertyChanged(const std::string& pEndpointId, const EndpointPropertyKey& pKey) const
+{
+	for (IEndpointNotificationClient* client : _GetNotificationClients())
+	{
+		client->OnEndpointPropertyChanged(pEndpointId, pKey);
+	}
+}
+
+std::shared_ptr<MockEndpointProvider::Endpoint> MockEndpointProvider::_Find(const std::string& pEndpointId) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _endpointsById.find(pEndpointId);
+	return (it != _endpointsById.end()) ? it->second : NULL;
+}
+
+std::vector<IEndpointNotificationClient*> MockEndpointProvider::_GetNotificationClients() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _notificationClients;
+}
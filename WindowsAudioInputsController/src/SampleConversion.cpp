@@ -0,0 +1,265 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <cmath>
+#include <cstring>
+
+#include "SampleConversion.h"
+
+#if WAIC_SAMPLES_SSE2
+#include <emmintrin.h>
+#endif
+
+static const float INT16_SCALE = 1.0f / 32768.0f;
+static const float INT24_SCALE = 1.0f / 8388608.0f;
+static const float INT32_SCALE = 1.0f / 2147483648.0f;
+// Largest float below 1.0: 1.0 * 2^31 does not fit in an int32.
+static const float MAX_SAMPLE = 0.99999994f;
+
+// NaN gives 0.
+static inline float Clamp(float pSample)
+{
+	if (pSample != pSample) return 0.0f;
+	return (pSample < -1.0f) ? -1.0f : ((pSample > MAX_SAMPLE) ? MAX_SAMPLE : pSample);
+}
+
+#if WAIC_SAMPLES_SSE2
+// Same as Clamp: NaN lanes are zeroed first, as min/max would return their bound for them.
+static inline __m128 Clamp(__m128 pSamples, __m128 pMinimum, __m128 pMaximum)
+{
+	pSamples = _mm_and_ps(pSamples, _mm_cmpord_ps(pSamples, pSamples));
+	return _mm_min_ps(_mm_max_ps(pSamples, pMinimum), pMaximum);
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////// TO FLOAT ////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void Int16ToFloat(const int16_t* pInput, float* pOutput, size_t pCount)
+{
+	size_t i = 0;
+#if WAIC_SAMPLES_SSE2
+	const __m128 scale = _mm_set1_ps(INT16_SCALE);
+	for (; i + 8 <= pCount; i += 8)
+	{
+		__m128i samples = _mm_loadu_si128((const __m128i*)(pInput + i));
+		// Sign-extends by placing each sample in the high half of a 32 bits lane, then shifting it back.
+		__m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+		__m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+		_mm_storeu_ps(pOutput + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+		_mm_storeu_ps(pOutput + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+	}
+#endif
+	for (; i < pCount; ++i)
+	{
+		pOutput[i] = (float)pInput[i] * INT16_SCALE;
+	}
+}
+
+static void Int24ToFloat(const uint8_t* pInput, float* pOutput, size_t pCount)
+{
+	for (size_t i = 0; i < pCount; ++i, pInput += 3)
+	{
+		int32_t sample = (int32_t)(((uint32_t)pInput[0] << 8) | ((uint32_t)pInput[1] << 16) | ((uint32_t)pInput[2] << 24)) >> 8;
+		pOutput[i] = (float)sample * INT24_SCALE;
+	}
+}
+
+static void Int32ToFloat(const int32_t* pInput, float* pOutput, size_t pCount)
+{
+	size_t i = 0;
+#if WAIC_SAMPLES_SSE2
+	const __m128 scale = _mm_set1_ps(INT32_SCALE);
+	for (; i + 4 <= pCount; i += 4)
+	{
+		__m128i samples = _mm_loadu_si128((const __m128i*)(pInput + i));
+		_mm_storeu_ps(pOutput + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+	}
+#endif
+	for (; i < pCount; ++i)
+	{
+		pOutput[i] = (float)pInput[i] * INT32_SCALE;
+	}
+}
+
+void ConvertToFloat(EndpointSampleType pType, const void* pInput, float* pOutput, size_t pSampleCount)
+{
+	switch (pType)
+	{
+	case EndpointSampleType::Int16:
+		Int16ToFloat((const int16_t*)pInput, pOutput, pSampleCount);
+		break;
+	case EndpointSampleType::Int24:
+		Int24ToFloat((const uint8_t*)pInput, pOutput, pSampleCount);
+		break;
+	case EndpointSampleType::Int32:
+		Int32ToFloat((const int32_t*)pInput, pOutput, pSampleCount);
+		break;
+	case EndpointSampleType::Float32:
+		memcpy(pOutput, pInput, pSampleCount * sizeof(float));
+		break;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////// FROM FLOAT ///////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void FloatToInt16(const float* pInput, int16_t* pOutput, size_t pCount)
+{
+	size_t i = 0;
+#if WAIC_SAMPLES_SSE2
+	const __m128 scale = _mm_set1_ps(32768.0f);
+	const __m128 minimum = _mm_set1_ps(-1.0f);
+	const __m128 maximum = _mm_set1_ps(1.0f);
+	for (; i + 8 <= pCount; i += 8)
+	{
+		// cvtps rounds to nearest, packs saturates 32768 to 32767.
+		__m128i low = _mm_cvtps_epi32(_mm_mul_ps(Clamp(_mm_loadu_ps(pInput + i), minimum, maximum), scale));
+		__m128i high = _mm_cvtps_epi32(_mm_mul_ps(Clamp(_mm_loadu_ps(pInput + i + 4), minimum, maximum), scale));
+		_mm_storeu_si128((__m128i*)(pOutput + i), _mm_packs_epi32(low, high));
+	}
+#endif
+	for (; i < pCount; ++i)
+	{
+		long sample = lrintf(Clamp(pInput[i]) * 32768.0f);
+		pOutput[i] = (int16_t)((sample > 32767) ? 32767 : sample);
+	}
+}
+
+static void FloatToInt24(const float* pInput, uint8_t* pOutput, size_t pCount)
+{
+	for (size_t i = 0; i < pCount; ++i, pOutput += 3)
+	{
+		long sample = lrintf(Clamp(pInput[i]) * 8388608.0f);
+		sample = (sample > 8388607) ? 8388607 : sample;
+		pOutput[0] = (uint8_t)(sample & 0xFF);
+		pOutput[1] = (uint8_t)((sample >> 8) & 0xFF);
+		pOutput[2] = (uint8_t)((sample >> 16) & 0xFF);
+	}
+}
+
+static void FloatToInt32(const float* pInput, int32_t* pOutput, size_t pCount)
+{
+	size_t i = 0;
+#if WAIC_SAMPLES_SSE2
+	const __m128 scale = _mm_set1_ps(2147483648.0f);
+	const __m128 minimum = _mm_set1_ps(-1.0f);
+	const __m128 maximum = _mm_set1_ps(MAX_SAMPLE);
+	for (; i + 4 <= pCount; i += 4)
+	{
+		__m128 samples = Clamp(_mm_loadu_ps(pInput + i), minimum, maximum);
+		_mm_storeu_si128((__m128i*)(pOutput + i), _mm_cvtps_epi32(_mm_mul_ps(samples, scale)));
+	}
+#endif
+	for (; i < pCount; ++i)
+	{
+		pOutput[i] = (int32_t)lrintf(Clamp(pInput[i]) * 2147483648.0f);
+	}
+}
+
+// Float endpoints take 1.0: only NaN and the samples out of [-1, 1] (eg. after a gain) are fixed. pInput may be pOutput.
+static void FloatToFloat(const float* pInput, float* pOutput, size_t pCount)
+{
+	size_t i = 0;
+#if WAIC_SAMPLES_SSE2
+	const __m128 minimum = _mm_set1_ps(-1.0f);
+	const __m128 maximum = _mm_set1_ps(1.0f);
+	for (; i + 4 <= pCount; i += 4)
+	{
+		_mm_storeu_ps(pOutput + i, Clamp(_mm_loadu_ps(pInput + i), minimum, maximum));
+	}
+#endif
+	for (; i < pCount; ++i)
+	{
+		float sample = pInput[i];
+		pOutput[i] = (sample != sample) ? 0.0f : ((sample < -1.0f) ? -1.0f : ((sample > 1.0f) ? 1.0f : sample));
+	}
+}
+
+void ConvertFromFloat(EndpointSampleType pType, const float* pInput, void* pOutput, size_t pSampleCount)
+{
+	switch (pType)
+	{
+	case EndpointSampleType::Int16:
+		FloatToInt16(pInput, (int16_t*)pOutput, pSampleCount);
+		break;
+	case EndpointSampleType::Int24:
+		FloatToInt24(pInput, (uint8_t*)pOutput, pSampleCount);
+		break;
+	case EndpointSampleType::Int32:
+		FloatToInt32(pInput, (int32_t*)pOutput, pSampleCount);
+		break;
+	case EndpointSampleType::Float32:
+		FloatToFloat(pInput, (float*)pOutput, pSampleCount);
+		break;
+	}
+}
+
+void ClampSamples(float* pSamples, size_t pSampleCount)
+{
+	FloatToFloat(pSamples, pSamples, pSampleCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////// CHANNELS & GAIN ////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+void ApplyGain(float* pSamples, size_t pSampleCount, float pGain)
+{
+	if (pGain == 1.0f) return;
+
+	size_t i = 0;
+#if WAIC_SAMPLES_SSE2
+	const __m128 gain = _mm_set1_ps(pGain);
+	for (; i + 4 <= pSampleCount; i += 4)
+	{
+		_mm_storeu_ps(pSamples + i, _mm_mul_ps(_mm_loadu_ps(pSamples + i), gain));
+	}
+#endif
+	for (; i < pSampleCount; ++i)
+	{
+		pSamples[i] *= pGain;
+	}
+}
+
+void MapChannels(const float* pInput, int pInputChannels, float* pOutput, int pOutputChannels, const int8_t* pMap, float pGain, size_t pFrameCount)
+{
+	bool identity = (pInputChannels == pOutputChannels);
+	for (int c = 0; c < pOutputChannels && identity; ++c)
+	{
+		identity = (pMap[c] == c);
+	}
+	if (identity)
+	{
+		memcpy(pOutput, pInput, pFrameCount * pInputChannels * sizeof(float));
+		ApplyGain(pOutput, pFrameCount * pInputChannels, pGain);
+		return;
+	}
+
+	int8_t map[SAMPLES_MAX_CHANNELS];
+	for (int c = 0; c < pOutputChannels; ++c)
+	{
+		map[c] = (pMap[c] < pInputChannels) ? pMap[c] : -1;
+	}
+	for (size_t frame = 0; frame < pFrameCount; ++frame, pInput += pInputChannels, pOutput += pOutputChannels)
+	{
+		for (int c = 0; c < pOutputChannels; ++c)
+		{
+			pOutput[c] = (map[c] >= 0) ? pInput[map[c]] * pGain : 0.0f;
+		}
+	}
+}
@@ -0,0 +1,78 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "SampleRing.h"
+
+SampleRing::SampleRing() : _buffer(), _mask(0), _writeIndex(0), _readIndex(0)
+{
+
+}
+
+void SampleRing::Reset(size_t pCapacity)
+{
+	size_t capacity = 1;
+	while (capacity < pCapacity)
+	{
+		capacity <<= 1;
+	}
+	_buffer.assign(capacity, 0.0f);
+	_mask = capacity - 1;
+	_writeIndex.store(0, std::memory_order_relaxed);
+	_readIndex.store(0, std::memory_order_relaxed);
+}
+
+size_t SampleRing::Write(const float* pSamples, size_t pCount)
+{
+	size_t writeIndex = _writeIndex.load(std::memory_order_relaxed);
+	size_t free = _buffer.size() - (writeIndex - _readIndex.load(std::memory_order_acquire));
+	size_t count = std::min(pCount, free);
+
+	// Up to two copies: until the end of the buffer, then from its start.
+	size_t start = writeIndex & _mask;
+	size_t first = std::min(count, _buffer.size() - start);
+	memcpy(&_buffer[start], pSamples, first * sizeof(float));
+	memcpy(&_buffer[0], pSamples + first, (count - first) * sizeof(float));
+
+	_writeIndex.store(writeIndex + count, std::memory_order_release);
+	return count;
+}
+
+size_t SampleRing::Read(float* pSamples, size_t pCount)
+{
+	size_t readIndex = _readIndex.load(std::memory_order_relaxed);
+	size_t count = std::min(pCount, _writeIndex.load(std::memory_order_acquire) - readIndex);
+
+	size_t start = readIndex & _mask;
+	size_t first = std::min(count, _buffer.size() - start);
+	memcpy(pSamples, &_buffer[start], first * sizeof(float));
+	memcpy(pSamples + first, &_buffer[0], (count - first) * sizeof(float));
+
+	_readIndex.store(readIndex + count, std::memory_order_release);
+	return count;
+}
+
+size_t SampleRing::Skip(size_t pCount)
+{
+	size_t readIndex = _readIndex.load(std::memory_order_relaxed);
+	size_t count = std::min(pCount, _writeIndex.load(std::memory_order_acquire) - readIndex);
+	_readIndex.store(readIndex + count, std::memory_order_release);
+	return count;
+}
@@ -0,0 +1,333 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "ServiceChannel.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////// ServiceChannel /////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+ServiceChannel::ServiceChannel() : _handle(INVALID_HANDLE)
+{
+
+}
+
+ServiceChannel::~ServiceChannel()
+{
+	Close();
+}
+
+std::string ServiceChannel::GetPath(const std::string& pName)
+{
+#if defined(_WIN32)
+	return "\\\\.\\pipe\\" + pName;
+#else
+	return (pName.find('/') != std::string::npos) ? pName : "/tmp/" + pName + ".sock";
+#endif
+}
+
+bool ServiceChannel::WriteMessage(const std::vector<uint8_t>& pMessage)
+{
+	uint32_t size = (uint32_t)pMessage.size();
+	return size <= MAX_MESSAGE_SIZE && _Write(&size, sizeof(size)) && (size == 0 || _Write(pMessage.data(), size));
+}
+
+bool ServiceChannel::ReadMessage(std::vector<uint8_t>& pMessage)
+{
+	uint32_t size = 0;
+	if (!_Read(&size, sizeof(size)) || size > MAX_MESSAGE_SIZE)
+	{
+		return false;
+	}
+	pMessage.resize(size);
+	return size == 0 || _Read(pMessage.data(), size);
+}
+
+#if defined(_WIN32)
+bool ServiceChannel::Connect(const std::string& pName)
+{
+	Close();
+	std::string path = GetPath(pName);
+	for (int attempt = 0; attempt < 2; ++attempt)
+	{
+		HANDLE pipe = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+		if (pipe != INVALID_HANDLE_VALUE)
+		{
+			_handle = (intptr_t)pipe;
+			return true;
+		}
+		// All the pipe instances are busy: the service creates a new one for each accepted client.
+		if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeA(path.c_str(), 1000))
+		{
+			break;
+		}
+	}
+	return false;
+}
+
+void ServiceChannel::Close()
+{
+	intptr_t handle = _handle.exchange(INVALID_HANDLE);
+	if (handle != INVALID_HANDLE)
+	{
+		HANDLE pipe = (HANDLE)handle;
+		CancelIoEx(pipe, NULL);
+		FlushFileBuffers(pipe);
+		DisconnectNamedPipe(pipe);
+		CloseHandle(pipe);
+	}
+}
+
+bool ServiceChannel::_Write(const void* pData, size_t pSize)
+{
+	const char* data = (const char*)pData;
+	while (pSize > 0)
+	{
+		DWORD written = 0;
+		if (!WriteFile((HANDLE)_handle.load(), data, (DWORD)pSize, &written, NULL) || written == 0)
+		{
+			return false;
+		}
+		data += written;
+		pSize -= written;
+	}
+	return true;
+}
+
+bool ServiceChannel::_Read(void* pData, size_t pSize)
+{
+	char* data = (char*)pData;
+	while (pSize > 0)
+	{
+		DWORD read = 0;
+		if (!ReadFile((HANDLE)_handle.load(), data, (DWORD)pSize, &read, NULL) || read == 0)
+		{
+			return false;
+		}
+		data += read;
+		pSize -= read;
+	}
+	return true;
+}
+#else
+static bool GetSocketAddress(const std::string& pPath, sockaddr_un& pAddress)
+{
+	memset(&pAddress, 0, sizeof(pAddress));
+	pAddress.sun_family = AF_UNIX;
+	if (pPath.size() >= sizeof(pAddress.sun_path))
+	{
+		return false;
+	}
+	memcpy(pAddress.sun_path, pPath.c_str(), pPath.size());
+	return true;
+}
+
+bool ServiceChannel::Connect(const std::string& pName)
+{
+	Close();
+	sockaddr_un address;
+	if (!GetSocketAddress(GetPath(pName), address))
+	{
+		return false;
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		return false;
+	}
+	if (connect(fd, (const sockaddr*)&address, sizeof(address)) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	_handle = fd;
+	return true;
+}
+
+void ServiceChannel::Close()
+{
+	intptr_t handle = _handle.exchange(INVALID_HANDLE);
+	if (handle != INVALID_HANDLE)
+	{
+		shutdown((int)handle, SHUT_RDWR);
+		close((int)handle);
+	}
+}
+
+bool ServiceChannel::_Write(const void* pData, size_t pSize)
+{
+	const char* data = (const char*)pData;
+	while (pSize > 0)
+	{
+		ssize_t written = send((int)_handle.load(), data, pSize, MSG_NOSIGNAL);
+		if (written < 0 && errno == EINTR) continue;
+		if (written <= 0)
+		{
+			return false;
+		}
+		data += written;
+		pSize -= (size_t)written;
+	}
+	return true;
+}
+
+bool ServiceChannel::_Read(void* pData, size_t pSize)
+{
+	char* data = (char*)pData;
+	while (pSize > 0)
+	{
+		ssize_t read = recv((int)_handle.load(), data, pSize, 0);
+		if (read < 0 && errno == EINTR) continue;
+		if (read <= 0)
+		{
+			return false;
+		}
+		data += read;
+		pSize -= (size_t)read;
+	}
+	return true;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////// ServiceListener /////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+ServiceListener::ServiceListener() : _path(), _closed(true), _handle(ServiceChannel::INVALID_HANDLE)
+{
+
+}
+
+ServiceListener::~ServiceListener()
+{
+	Close();
+}
+
+#if defined(_WIN32)
+bool ServiceListener::Listen(const std::string& pName)
+{
+	_path = ServiceChannel::GetPath(pName);
+	_closed = false;
+	return true;
+}
+
+bool ServiceListener::Accept(ServiceChannel& pChannel)
+{
+	while (!_closed)
+	{
+		HANDLE pipe = CreateNamedPipeA(_path.c_str(), PIPE_ACCESS_DUPLEX, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+			PIPE_UNLIMITED_INSTANCES, 64 * 1024, 64 * 1024, 0, NULL);
+		if (pipe == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		bool connected = ConnectNamedPipe(pipe, NULL) ? true : (GetLastError() == ERROR_PIPE_CONNECTED);
+		if (connected && !_closed)
+		{
+			pChannel.Close();
+			pChannel._handle = (intptr_t)pipe;
+			return true;
+		}
+		CloseHandle(pipe);
+	}
+	return false;
+}
+
+void ServiceListener::Close()
+{
+	if (_closed.exchange(true)) return;
+
+	// Unblocks ConnectNamedPipe() by connecting to it.
+	HANDLE pipe = CreateFileA(_path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+	if (pipe != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(pipe);
+	}
+}
+#else
+bool ServiceListener::Listen(const std::string& pName)
+{
+	Close();
+	_path = ServiceChannel::GetPath(pName);
+	sockaddr_un address;
+	if (!GetSocketAddress(_path, address))
+	{
+		return false;
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		return false;
+	}
+	// A previous service may have left its socket file.
+	unlink(_path.c_str());
+	if (bind(fd, (const sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	_handle = fd;
+	_closed = false;
+	return true;
+}
+
+bool ServiceListener::Accept(ServiceChannel& pChannel)
+{
+	while (!_closed)
+	{
+		int fd = accept((int)_handle.load(), NULL, NULL);
+		if (fd >= 0)
+		{
+			pChannel.Close();
+			pChannel._handle = fd;
+			return true;
+		}
+		if (errno != EINTR && errno != ECONNABORTED)
+		{
+			break;
+		}
+	}
+	return false;
+}
+
+void ServiceListener::Close()
+{
+	if (_closed.exchange(true)) return;
+
+	intptr_t handle = _handle.exchange(ServiceChannel::INVALID_HANDLE);
+	if (handle != ServiceChannel::INVALID_HANDLE)
+	{
+		// Unblocks accept().
+		shutdown((int)handle, SHUT_RDWR);
+		close((int)handle);
+		unlink(_path.c_str());
+	}
+}
+#endif
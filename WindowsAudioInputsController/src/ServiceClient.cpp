@@ -0,0 +1,374 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "ServiceClient.h"
+
+ServiceClient::ServiceClient(const std::string& pServiceName) : _serviceName(pServiceName), _mutex(), _channel(), _request(), _response(), _errors()
+{
+
+}
+
+bool ServiceClient::Connect()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _channel.IsOpen() || _channel.Connect(_serviceName);
+}
+
+bool ServiceClient::_Send(WAIC_Operation pOperation, const char* pDevice)
+{
+	// A connection reused from a previous call may have been closed by a restarted service: then retry once on a new one.
+	bool reused = _channel.IsOpen();
+	if (reused || _channel.Connect(_serviceName))
+	{
+		if (_channel.WriteMessage(_request) && _channel.ReadMessage(_response))
+		{
+			return true;
+		}
+		_channel.Close();
+		if (reused && _channel.Connect(_serviceName) && _channel.WriteMessage(_request) && _channel.ReadMessage(_response))
+		{
+			return true;
+		}
+		_channel.Close();
+	}
+	_errors.Record(WAIC_ERROR_SERVICE_UNAVAILABLE, pOperation, ENDPOINT_OK, pDevice);
+	return false;
+}
+
+bool ServiceClient::_ReadErrors(MessageReader& pReader, WAIC_Operation pOperation)
+{
+	uint32_t count = pReader.ReadCount(sizeof(WAIC_ErrorRecord));
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		WAIC_ErrorRecord record = pReader.Read<WAIC_ErrorRecord>();
+		record.device[WAIC_DEVICE_NAME_SIZE - 1] = '\0';
+		_errors.Record((WAIC_ErrorCode)record.code, (WAIC_Operation)record.operation, record.hresult, record.device, record.listen);
+	}
+	if (pReader.HasFailed() || !pReader.IsAtEnd())
+	{
+		// Not the expected response: the connection cannot be trusted anymore.
+		_channel.Close();
+		_errors.Record(WAIC_ERROR_SERVICE_UNAVAILABLE, pOperation, ENDPOINT_E_FAIL, NULL);
+		return false;
+	}
+	return true;
+}
+
+bool ServiceClient::IsListening(const char* pDeviceName)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_IS_LISTENING);
+	writer.WriteString(pDeviceName);
+	if (!_Send(WAIC_OP_IS_LISTENING, pDeviceName)) return false;
+
+	MessageReader reader(_response);
+	bool isListening = reader.ReadBool();
+	return _ReadErrors(reader, WAIC_OP_IS_LISTENING) && isListening;
+}
+
+bool ServiceClient::SetListenToAudioInputDevice(const char* pDeviceName, bool pListen)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_SET_LISTEN);
+	writer.WriteString(pDeviceName);
+	writer.WriteBool(pListen);
+	if (!_Send(WAIC_OP_SET_LISTEN, pDeviceName)) return false;
+
+	MessageReader reader(_response);
+	bool result = reader.ReadBool();
+	return _ReadErrors(reader, WAIC_OP_SET_LISTEN) && result;
+}
+
+int ServiceClient::SetListenToAudioInputDevices(const char* const* pDeviceNames, const bool* pListen, int pCount, bool* pResults)
+{
+	if (pCount <= 0 || pDeviceNames == NULL || pListen == NULL) return 0;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_SET_LISTEN_BATCH);
+	writer.Write<uint32_t>((uint32_t)pCount);
+	for (int i = 0; i < pCount; ++i)
+	{
+		writer.WriteString(pDeviceNames[i]);
+		writer.WriteBool(pListen[i]);
+	}
+	if (pResults != NULL)
+	{
+		std::fill(pResults, pResults + pCount, false);
+	}
+	if (!_Send(WAIC_OP_SET_LISTEN_BATCH, NULL)) return 0;
+
+	MessageReader reader(_response);
+	int succeeded = reader.Read<int32_t>();
+	for (int i = 0; i < pCount; ++i)
+	{
+		bool result = reader.ReadBool();
+		if (pResults != NULL)
+		{
+			pResults[i] = result;
+		}
+	}
+	return _ReadErrors(reader, WAIC_OP_SET_LISTEN_BATCH) ? succeeded : 0;
+}
+
+int ServiceClient::GetListenStates(const char* const* pDeviceNames, int pCount, bool* pIsListening, bool* pResults)
+{
+	if (pCount <= 0 || pDeviceNames == NULL || pIsListening == NULL) return 0;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_GET_LISTEN_STATES);
+	writer.Write<uint32_t>((uint32_t)pCount);
+	for (int i = 0; i < pCount; ++i)
+	{
+		writer.WriteString(pDeviceNames[i]);
+	}
+	std::fill(pIsListening, pIsListening + pCount, false);
+	if (pResults != NULL)
+	{
+		std::fill(pResults, pResults + pCount, false);
+	}
+	if (!_Send(WAIC_OP_GET_LISTEN_STATES, NULL)) return 0;
+
+	MessageReader reader(_response);
+	int succeeded = reader.Read<int32_t>();
+	for (int i = 0; i < pCount; ++i)
+	{
+		pIsListening[i] = reader.ReadBool();
+		bool result = reader.ReadBool();
+		if (pResults != NULL)
+		{
+			pResults[i] = result;
+		}
+	}
+	return _ReadErrors(reader, WAIC_OP_GET_LISTEN_STATES) ? succeeded : 0;
+}
+
+bool ServiceClient::SetListenToAudioInputDeviceTarget(const char* pDeviceName, bool pListen, const char* pOutputDeviceName)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_SET_LISTEN_TARGET);
+	writer.WriteString(pDeviceName);
+	writer.WriteBool(pListen);
+	writer.WriteBool(pOutputDeviceName != NULL);
+	if (pOutputDeviceName != NULL)
+	{
+		writer.WriteString(pOutputDeviceName);
+	}
+	if (!_Send(WAIC_OP_SET_LISTEN_TARGET, pDeviceName)) return false;
+
+	MessageReader reader(_response);
+	bool result = reader.ReadBool();
+	return _ReadErrors(reader, WAIC_OP_SET_LISTEN_TARGET) && result;
+}
+
+WAIC_DeviceHandle ServiceClient::OpenDevice(const char* pDeviceName)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_OPEN_DEVICE);
+	writer.WriteString(pDeviceName);
+	if (!_Send(WAIC_OP_OPEN_DEVICE, pDeviceName)) return WAIC_INVALID_DEVICE;
+
+	MessageReader reader(_response);
+	WAIC_DeviceHandle device = reader.Read<uint64_t>();
+	return _ReadErrors(reader, WAIC_OP_OPEN_DEVICE) ? device : WAIC_INVALID_DEVICE;
+}
+
+bool ServiceClient::IsDeviceListening(WAIC_DeviceHandle pDevice)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_IS_DEVICE_LISTENING);
+	writer.Write<uint64_t>(pDevice);
+	if (!_Send(WAIC_OP_IS_LISTENING, NULL)) return false;
+
+	MessageReader reader(_response);
+	bool isListening = reader.ReadBool();
+	return _ReadErrors(reader, WAIC_OP_IS_LISTENING) && isListening;
+}
+
+bool ServiceClient::SetListenToDevice(WAIC_DeviceHandle pDevice, bool pListen)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_SET_LISTEN_TO_DEVICE);
+	writer.Write<uint64_t>(pDevice);
+	writer.WriteBool(pListen);
+	if (!_Send(WAIC_OP_SET_LISTEN, NULL)) return false;
+
+	MessageReader reader(_response);
+	bool result = reader.ReadBool();
+	return _ReadErrors(reader, WAIC_OP_SET_LISTEN) && result;
+}
+
+bool ServiceClient::IsDeviceHandleValid(WAIC_DeviceHandle pDevice)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_IS_DEVICE_HANDLE_VALID);
+	writer.Write<uint64_t>(pDevice);
+	if (!_Send(WAIC_OP_OPEN_DEVICE, NULL)) return false;
+
+	MessageReader reader(_response);
+	bool isValid = reader.ReadBool();
+	return _ReadErrors(reader, WAIC_OP_OPEN_DEVICE) && isValid;
+}
+
+int ServiceClient::SetListenToDevices(const WAIC_DeviceHandle* pDevices, const bool* pListen, int pCount, bool* pResults)
+{
+	if (pCount <= 0 || pDevices == NULL || pListen == NULL) return 0;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_SET_LISTEN_TO_DEVICES);
+	writer.Write<uint32_t>((uint32_t)pCount);
+	for (int i = 0; i < pCount; ++i)
+	{
+		writer.Write<uint64_t>(pDevices[i]);
+		writer.WriteBool(pListen[i]);
+	}
+	if (pResults != NULL)
+	{
+		std::fill(pResults, pResults + pCount, false);
+	}
+	if (!_Send(WAIC_OP_SET_LISTEN_BATCH, NULL)) return 0;
+
+	MessageReader reader(_response);
+	int succeeded = reader.Read<int32_t>();
+	for (int i = 0; i < pCount; ++i)
+	{
+		bool result = reader.ReadBool();
+		if (pResults != NULL)
+		{
+			pResults[i] = result;
+		}
+	}
+	return _ReadErrors(reader, WAIC_OP_SET_LISTEN_BATCH) ? succeeded : 0;
+}
+
+int ServiceClient::GetDeviceListenStates(const WAIC_DeviceHandle* pDevices, int pCount, bool* pIsListening, bool* pResults)
+{
+	if (pCount <= 0 || pDevices == NULL || pIsListening == NULL) return 0;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_GET_DEVICE_LISTEN_STATES);
+	writer.Write<uint32_t>((uint32_t)pCount);
+	for (int i = 0; i < pCount; ++i)
+	{
+		writer.Write<uint64_t>(pDevices[i]);
+	}
+	std::fill(pIsListening, pIsListening + pCount, false);
+	if (pResults != NULL)
+	{
+		std::fill(pResults, pResults + pCount, false);
+	}
+	if (!_Send(WAIC_OP_GET_LISTEN_STATES, NULL)) return 0;
+
+	MessageReader reader(_response);
+	int succeeded = reader.Read<int32_t>();
+	for (int i = 0; i < pCount; ++i)
+	{
+		pIsListening[i] = reader.ReadBool();
+		bool result = reader.ReadBool();
+		if (pResults != NULL)
+		{
+			pResults[i] = result;
+		}
+	}
+	return _ReadErrors(reader, WAIC_OP_GET_LISTEN_STATES) ? succeeded : 0;
+}
+
+bool ServiceClient::RefreshAudioInputs()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_REFRESH);
+	if (!_Send(WAIC_OP_REFRESH, NULL)) return false;
+
+	MessageReader reader(_response);
+	bool result = reader.ReadBool();
+	return _ReadErrors(reader, WAIC_OP_REFRESH) && result;
+}
+
+int ServiceClient::Snapshot(WAIC_DeviceSnapshot* pRecords, int pCapacity, int* pRequiredCount)
+{
+	if (pRequiredCount != NULL)
+	{
+		*pRequiredCount = 0;
+	}
+	if (pRecords == NULL || pCapacity < 0)
+	{
+		pCapacity = 0;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	MessageWriter writer(_request);
+	writer.Write<uint32_t>(1);
+	writer.Write<uint8_t>(SERVICE_OP_SNAPSHOT);
+	writer.Write<uint32_t>((uint32_t)pCapacity);
+	if (!_Send(WAIC_OP_SNAPSHOT, NULL)) return 0;
+
+	MessageReader reader(_response);
+	int required = reader.Read<int32_t>();
+	int count = (int)reader.ReadCount(sizeof(WAIC_DeviceSnapshot));
+	count = (count < pCapacity) ? count : pCapacity;
+	for (int i = 0; i < count; ++i)
+	{
+		pRecords[i] = reader.Read<WAIC_DeviceSnapshot>();
+	}
+	if (!_ReadErrors(reader, WAIC_OP_SNAPSHOT)) return 0;
+
+	if (pRequiredCount != NULL)
+	{
+		*pRequiredCount = required;
+	}
+	return count;
+}
+
+const char* ServiceClient::GetErrors()
+{
+	static thread_local std::string errorsText;
+	WAIC_ErrorRecord records[ErrorRing::CAPACITY];
+	int count = _errors.Drain(records, ErrorRing::CAPACITY);
+	errorsText.clear();
+	for (int i = 0; i < count; ++i)
+	{
+		ErrorRing::Format(records[i], errorsText);
+	}
+	return errorsText.c_str();
+}
@@ -0,0 +1,677 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <endpointvolume.h>
+#include <mmreg.h>
+#include <ksmedia.h>
+#include <atlbase.h>
+#include <functiondiscoverykeys_devpkey.h>
+#include <algorithm>
+#include <cstring>
+
+#include "WasapiEndpointProvider.h"
+
+static_assert(sizeof(EndpointGuid) == sizeof(GUID), "EndpointGuid must match GUID layout");
+static_assert(sizeof(EndpointPropertyKey) == sizeof(PROPERTYKEY), "EndpointPropertyKey must match PROPERTYKEY layout");
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////// HELPERS /////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void ToWString(const std::string& pInStr, std::wstring& pOutStr)
+{
+	int len = MultiByteToWideChar(CP_UTF8, 0, pInStr.c_str(), -1, NULL, 0);
+	if (len > 0)
+	{
+		pOutStr.resize(len - 1); // resize without the null terminator
+		MultiByteToWideChar(CP_UTF8, 0, pInStr.c_str(), -1, &pOutStr[0], len);
+	}
+	else
+	{
+		// Clear output if conversion fails
+		pOutStr.clear();
+	}
+}
+
+static void ToUtf8String(LPCWSTR pInStr, std::string& pOutStr)
+{
+	int len = WideCharToMultiByte(CP_UTF8, 0, pInStr, -1, NULL, 0, NULL, NULL);
+	if (len > 0)
+	{
+		pOutStr.resize(len - 1); // resize without the null terminator
+		WideCharToMultiByte(CP_UTF8, 0, pInStr, -1, &pOutStr[0], len, NULL, NULL);
+	}
+	else
+	{
+		// Clear output if conversion fails
+		pOutStr.clear();
+	}
+}
+
+static PROPERTYKEY ToPropertyKey(const EndpointPropertyKey& pKey)
+{
+	PROPERTYKEY key;
+	memcpy(&key, &pKey, sizeof(PROPERTYKEY));
+	return key;
+}
+
+static EDataFlow ToDataFlow(EndpointFlow pFlow)
+{
+	return (pFlow == EndpointFlow::Capture) ? eCapture : eRender;
+}
+
+static HRESULT ReadEndpointInfo(IMMDevice* pDevice, EndpointInfo& pInfo)
+{
+	LPWSTR pwszID = NULL;
+	HRESULT hr = pDevice->GetId(&pwszID);
+	if (FAILED(hr)) return hr;
+	ToUtf8String(pwszID, pInfo.id);
+	CoTaskMemFree(pwszID);
+
+	DWORD state = 0;
+	pDevice->GetState(&state);
+	pInfo.state = state;
+
+	CComPtr<IMMEndpoint> endpoint;
+	hr = pDevice->QueryInterface(__uuidof(IMMEndpoint), (void**)&endpoint);
+	if (SUCCEEDED(hr))
+	{
+		EDataFlow dataFlow = eCapture;
+		endpoint->GetDataFlow(&dataFlow);
+		pInfo.flow = (dataFlow == eRender) ? EndpointFlow::Render : EndpointFlow::Capture;
+	}
+
+	pInfo.friendlyName.clear();
+	CComPtr<IPropertyStore> propertyStore;
+	hr = pDevice->OpenPropertyStore(STGM_READ, &propertyStore);
+	if (SUCCEEDED(hr))
+	{
+		PROPVARIANT varName;
+		PropVariantInit(&varName);
+		hr = propertyStore->GetValue(PKEY_Device_FriendlyName, &varName);
+		if (SUCCEEDED(hr) && varName.vt == VT_LPWSTR)
+		{
+			ToUtf8String(varName.pwszVal, pInfo.friendlyName);
+		}
+		PropVariantClear(&varName);
+	}
+	return S_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// WASAPI endpoint & store ///////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+class WasapiPropertyStore : public IEndpointPropertyStore
+{
+public:
+	WasapiPropertyStore(IPropertyStore* pPropertyStore) : _propertyStore(pPropertyStore) {}
+
+	EndpointResult GetValue(const EndpointPropertyKey& pKey, EndpointPropertyValue& pValue) override
+	{
+		pValue = EndpointPropertyValue();
+
+		PROPVARIANT value;
+		PropVariantInit(&value);
+		HRESULT hr = _propertyStore->GetValue(ToPropertyKey(pKey), &value);
+		if (SUCCEEDED(hr))
+		{
+			if (value.vt == VT_BOOL)
+			{
+				pValue = EndpointPropertyValue::FromBool(value.boolVal == VARIANT_TRUE);
+			}
+			else if (value.vt == VT_LPWSTR && value.pwszVal != NULL)
+			{
+				pValue.type = EndpointPropertyValue::String;
+				ToUtf8String(value.pwszVal, pValue.stringValue);
+			}
+			hr = PropVariantClear(&value);
+		}
+		return hr;
+	}
+
+	EndpointResult SetValue(const EndpointPropertyKey& pKey, const EndpointPropertyValue& pValue) override
+	{
+		// The PROPVARIANT only borrows the string buffer, so it must not be cleared with PropVariantClear.
+		std::wstring stringValue;
+		PROPVARIANT value;
+		PropVariantInit(&value);
+		switch (pValue.type)
+		{
+		case EndpointPropertyValue::Bool:
+			value.vt = VT_BOOL;
+			value.boolVal = pValue.boolValue ? VARIANT_TRUE : VARIANT_FALSE;
+			break;
+		case EndpointPropertyValue::String:
+			ToWString(pValue.stringValue, stringValue);
+			value.vt = VT_LPWSTR;
+			value.pwszVal = const_cast<LPWSTR>(stringValue.c_str());
+			break;
+		default:
+			value.vt = VT_EMPTY;
+			break;
+		}
+		return _propertyStore->SetValue(ToPropertyKey(pKey), value);
+	}
+
+private:
+	CComPtr<IPropertyStore> _propertyStore;
+};
+
+class WasapiEndpointMeter : public IEndpointMeter
+{
+public:
+	WasapiEndpointMeter(IAudioMeterInformation* pMeter) : _meter(pMeter) {}
+
+	EndpointResult GetPeakValue(float& pPeak) override
+	{
+		pPeak = 0.0f;
+		return _meter->GetPeakValue(&pPeak);
+	}
+
+private:
+	CComPtr<IAudioMeterInformation> _meter;
+};
+
+// Event-driven shared-mode stream.
+class WasapiEndpointStream : public IEndpointStream
+{
+public:
+	WasapiEndpointStream() : _audioClient(), _captureClient(), _renderClient(), _event(NULL), _format(), _capture(false), _bufferFrames(0), _periodFrames(0), _latencyFrames(0) {}
+
+	~WasapiEndpointStream()
+	{
+		if (_audioClient != NULL)
+		{
+			_audioClient->Stop();
+		}
+		if (_event != NULL)
+		{
+			CloseHandle(_event);
+		}
+	}
+
+	HRESULT Open(IMMDevice* pDevice, uint32_t pBufferUs, uint32_t pSampleRate)
+	{
+		CComQIPtr<IMMEndpoint> endpoint(pDevice);
+		if (endpoint == NULL) return E_NOINTERFACE;
+		EDataFlow flow = eCapture;
+		HRESULT hr = endpoint->GetDataFlow(&flow);
+		if (FAILED(hr)) return hr;
+		_capture = (flow == eCapture);
+
+		hr = pDevice->Activate(__uuidof(IAudioClient), CLSCTX_ALL, NULL, (void**)&_audioClient);
+		if (FAILED(hr)) return hr;
+
+		WAVEFORMATEX* mixFormat = NULL;
+		hr = _audioClient->GetMixFormat(&mixFormat);
+		if (FAILED(hr)) return hr;
+
+		hr = _ReadFormat(mixFormat);
+		if (SUCCEEDED(hr))
+		{
+			DWORD streamFlags = AUDCLNT_STREAMFLAGS_EVENTCALLBACK;
+			if (pSampleRate != 0 && pSampleRate != mixFormat->nSamplesPerSec)
+			{
+				// The audio engine converts between the mix rate and the stream rate.
+				mixFormat->nSamplesPerSec = pSampleRate;
+				mixFormat->nAvgBytesPerSec = pSampleRate * mixFormat->nBlockAlign;
+				streamFlags |= AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM | AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY;
+				_format.sampleRate = pSampleRate;
+			}
+			// REFERENCE_TIME: 100 ns units.
+			hr = _audioClient->Initialize(AUDCLNT_SHAREMODE_SHARED, streamFlags, (REFERENCE_TIME)pBufferUs * 10, 0, mixFormat, NULL);
+		}
+		CoTaskMemFree(mixFormat);
+		if (FAILED(hr)) return hr;
+
+		_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if (_event == NULL) return HRESULT_FROM_WIN32(GetLastError());
+		hr = _audioClient->SetEventHandle(_event);
+		if (FAILED(hr)) return hr;
+
+		UINT32 bufferFrames = 0;
+		hr = _audioClient->GetBufferSize(&bufferFrames);
+		if (FAILED(hr)) return hr;
+		REFERENCE_TIME latency = 0, period = 0;
+		hr = _audioClient->GetStreamLatency(&latency);
+		if (FAILED(hr)) return hr;
+		hr = _audioClient->GetDevicePeriod(&period, NULL);
+		if (FAILED(hr)) return hr;
+		_bufferFrames = bufferFrames;
+		_latencyFrames = (uint32_t)(latency * _format.sampleRate / 10000000);
+		_periodFrames = (std::min)(_bufferFrames, (uint32_t)(period * _format.sampleRate / 10000000));
+
+		if (_capture)
+		{
+			hr = _audioClient->GetService(__uuidof(IAudioCaptureClient), (void**)&_captureClient);
+		}
+		else
+		{
+			hr = _audioClient->GetService(__uuidof(IAudioRenderClient), (void**)&_renderClient);
+		}
+		return hr;
+	}
+
+	bool IsCapture()const override { return _capture; }
+	const EndpointStreamFormat& GetFormat()const override { return _format; }
+	uint32_t GetBufferFrames()const override { return _bufferFrames; }
+	uint32_t GetPeriodFrames()const override { return _periodFrames; }
+	uint32_t GetLatencyFrames()const override { return _latencyFrames; }
+
+	EndpointResult Start() override { return _audioClient->Start(); }
+	EndpointResult Stop() override { return _audioClient->Stop(); }
+
+	EndpointResult WaitPeriod(uint32_t pTimeoutMs) override
+	{
+		DWORD result = WaitForSingleObject(_event, pTimeoutMs);
+		if (result == WAIT_OBJECT_0) return S_OK;
+		if (result == WAIT_TIMEOUT) return S_FALSE;
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	EndpointResult ReadPacket(const uint8_t*& pData, uint32_t& pFrames, bool& pSilent) override
+	{
+		pData = NULL;
+		pFrames = 0;
+		pSilent = false;
+		if (_captureClient == NULL) return E_INVALIDARG;
+
+		BYTE* data = NULL;
+		UINT32 frames = 0;
+		DWORD flags = 0;
+		HRESULT hr = _captureClient->GetBuffer(&data, &frames, &flags, NULL, NULL);
+		if (hr == AUDCLNT_S_BUFFER_EMPTY) return S_OK;
+		if (SUCCEEDED(hr))
+		{
+			pData = data;
+			pFrames = frames;
+			pSilent = (flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0;
+		}
+		return hr;
+	}
+
+	EndpointResult ReleasePacket(uint32_t pFrames) override
+	{
+		return _captureClient->ReleaseBuffer(pFrames);
+	}
+
+	EndpointResult GetPadding(uint32_t& pFrames) override
+	{
+		UINT32 padding = 0;
+		HRESULT hr = _audioClient->GetCurrentPadding(&padding);
+		pFrames = padding;
+		return hr;
+	}
+
+	EndpointResult GetWriteBuffer(uint32_t pFrames, uint8_t*& pData) override
+	{
+		pData = NULL;
+		if (_renderClient == NULL) return E_INVALIDARG;
+
+		BYTE* data = NULL;
+		HRESULT hr = _renderClient->GetBuffer(pFrames, &data);
+		pData = data;
+		return hr;
+	}
+
+	EndpointResult ReleaseWriteBuffer(uint32_t pFrames) override
+	{
+		return _renderClient->ReleaseBuffer(pFrames, 0);
+	}
+
+private:
+	HRESULT _ReadFormat(const WAVEFORMATEX* pFormat)
+	{
+		bool isFloat = (pFormat->wFormatTag == WAVE_FORMAT_IEEE_FLOAT);
+		bool isPcm = (pFormat->wFormatTag == WAVE_FORMAT_PCM);
+		if (pFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE)
+		{
+			const WAVEFORMATEXTENSIBLE* extensible = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(pFormat);
+			isFloat = IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) != FALSE;
+			isPcm = IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_PCM) != FALSE;
+		}
+
+		_format.sampleRate = pFormat->nSamplesPerSec;
+		_format.channels = pFormat->nChannels;
+		// Container size: 24 bits samples in 32 bits containers are read as left-aligned 32 bits samples.
+		WORD sampleSize = (pFormat->nChannels != 0) ? (WORD)(pFormat->nBlockAlign / pFormat->nChannels) : 0;
+		if (isFloat && sampleSize == 4) _format.sampleType = EndpointSampleType::Float32;
+		else if (isPcm && sampleSize == 2) _format.sampleType = EndpointSampleType::Int16;
+		else if (isPcm && sampleSize == 3) _format.sampleType = EndpointSampleType::Int24;
+		else if (isPcm && sampleSize == 4) _format.sampleType = EndpointSampleType::Int32;
+		else return AUDCLNT_E_UNSUPPORTED_FORMAT;
+		return S_OK;
+	}
+
+private:
+	CComPtr<IAudioClient> _audioClient;
+	CComPtr<IAudioCaptureClient> _captureClient;
+	CComPtr<IAudioRenderClient> _renderClient;
+	HANDLE _event;
+	EndpointStreamFormat _format;
+	bool _capture;
+	uint32_t _bufferFrames;
+	uint32_t _periodFrames;
+	uint32_t _latencyFrames;
+};
+
+class WasapiAudioEndpoint : public IAudioEndpoint
+{
+public:
+	WasapiAudioEndpoint(IMMDevice* pDevice, const std::string& pId) : _device(pDevice), _id(pId) {}
+
+	const std::string& GetId()const override { return _id; }
+
+	EndpointResult OpenPropertyStore(bool pReadWrite, std::unique_ptr<IEndpointPropertyStore>& pStore) override
+	{
+		CComPtr<IPropertyStore> propertyStore;
+		HRESULT hr = _device->OpenPropertyStore(pReadWrite ? STGM_READWRITE : STGM_READ, &propertyStore);
+		if (SUCCEEDED(hr))
+		{
+			pStore.reset(new WasapiPropertyStore(propertyStore));
+		}
+		return hr;
+	}
+
+	EndpointResult OpenMeter(std::unique_ptr<IEndpointMeter>& pMeter) override
+	{
+		// Capture endpoints only report levels while a stream is running on them (eg. "Listen to this device", or any recording application).
+		CComPtr<IAudioMeterInformation> meter;
+		HRESULT hr = _device->Activate(__uuidof(IAudioMeterInformation), CLSCTX_ALL, NULL, (void**)&meter);
+		if (SUCCEEDED(hr))
+		{
+			pMeter.reset(new WasapiEndpointMeter(meter));
+		}
+		return hr;
+	}
+
+	EndpointResult OpenStream(uint32_t pBufferUs, uint32_t pSampleRate, std::unique_ptr<IEndpointStream>& pStream) override
+	{
+		std::unique_ptr<WasapiEndpointStream> stream(new WasapiEndpointStream());
+		HRESULT hr = stream->Open(_device, pBufferUs, pSampleRate);
+		if (SUCCEEDED(hr))
+		{
+			pStream = std::move(stream);
+		}
+		return hr;
+	}
+
+private:
+	CComPtr<IMMDevice> _device;
+	std::string _id;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////// WasapiNotificationClient /////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Forwards the IMMNotificationClient events to an IEndpointNotificationClient.
+class WasapiNotificationClient : public IMMNotificationClient
+{
+public:
+	WasapiNotificationClient(IEndpointNotificationClient* pClient) : _refCount(1), _client(pClient) {}
+
+	inline IEndpointNotificationClient* GetClient()const { return _client; }
+
+	// IUnknown
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return InterlockedIncrement(&_refCount);
+	}
+
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		ULONG refCount = InterlockedDecrement(&_refCount);
+		if (refCount == 0)
+		{
+			delete this;
+		}
+		return refCount;
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, VOID** ppvInterface) override
+	{
+		if (riid == IID_IUnknown || riid == __uuidof(IMMNotificationClient))
+		{
+			AddRef();
+			*ppvInterface = (IMMNotificationClient*)this;
+			return S_OK;
+		}
+		*ppvInterface = NULL;
+		return E_NOINTERFACE;
+	}
+
+	// IMMNotificationClient
+	HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR pwstrDeviceId) override
+	{
+		return S_OK;
+	}
+
+	HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR pwstrDeviceId) override
+	{
+		std::string endpointId;
+		ToUtf8String(pwstrDeviceId, endpointId);
+		_client->OnEndpointAdded(endpointId);
+		return S_OK;
+	}
+
+	HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR pwstrDeviceId) override
+	{
+		std::string endpointId;
+		ToUtf8String(pwstrDeviceId, endpointId);
+		_client->OnEndpointRemoved(endpointId);
+		return S_OK;
+	}
+
+	HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR pwstrDeviceId, DWORD dwNewState) override
+	{
+		std::string endpointId;
+		ToUtf8String(pwstrDeviceId, endpointId);
+		_client->OnEndpointStateChanged(endpointId, dwNewState);
+		return S_OK;
+	}
+
+	HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR pwstrDeviceId, const PROPERTYKEY key) override
+	{
+		std::string endpointId;
+		ToUtf8String(pwstrDeviceId, endpointId);
+		EndpointPropertyKey endpointKey;
+		memcpy(&endpointKey, &key, sizeof(EndpointPropertyKey));
+		_client->OnEndpointPropertyChanged(endpointId, endpointKey);
+		return S_OK;
+	}
+
+private:
+	LONG _refCount;
+	IEndpointNotificationClient* _client;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////// WasapiEndpointProvider /////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+WasapiEndpointProvider::WasapiEndpointProvider() : _comInitialized(false), _deviceEnumerator(NULL), _notificationClients()
+{
+
+}
+
+WasapiEndpointProvider::~WasapiEndpointProvider()
+{
+	for (WasapiNotificationClient* notificationClient : _notificationClients)
+	{
+		if (_deviceEnumerator != NULL)
+		{
+			_deviceEnumerator->UnregisterEndpointNotificationCallback(notificationClient);
+		}
+		notificationClient->Release();
+	}
+	_notificationClients.clear();
+
+	if (_deviceEnumerator != NULL)
+	{
+		_deviceEnumerator->Release();
+	}
+
+	if (_comInitialized)
+	{
+		CoUninitialize();
+	}
+}
+
+EndpointResult WasapiEndpointProvider::Initialize()
+{
+	HRESULT hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+	if (SUCCEEDED(hr))
+	{
+		_comInitialized = true;
+		hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), NULL, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator), (void**)&_deviceEnumerator);
+	}
+	return hr;
+}
+
+// Whether InitializeThread() initialized COM on the current thread.
+static thread_local bool sThreadComInitialized = false;
+
+EndpointResult WasapiEndpointProvider::InitializeThread()
+{
+	HRESULT hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+	sThreadComInitialized = SUCCEEDED(hr);
+	return hr;
+}
+
+void WasapiEndpointProvider::UninitializeThread()
+{
+	if (sThreadComInitialized)
+	{
+		CoUninitialize();
+		sThreadComInitialized = false;
+	}
+}
+
+EndpointResult WasapiEndpointProvider::EnumerateEndpoints(EndpointFlow pFlow, uint32_t pStateMask, std::vector<EndpointInfo>& pEndpoints)
+{
+	pEndpoints.clear();
+	if (_deviceEnumerator == NULL) return E_POINTER;
+
+	CComPtr<IMMDeviceCollection> deviceCollection;
+	HRESULT hr = _deviceEnumerator->EnumAudioEndpoints(ToDataFlow(pFlow), pStateMask, &deviceCollection);
+	if (FAILED(hr)) return hr;
+
+	UINT deviceCount = 0;
+	deviceCollection->GetCount(&deviceCount);
+	pEndpoints.reserve(deviceCount);
+
+	for (UINT i = 0; i < deviceCount; i++)
+	{
+		CComPtr<IMMDevice> device;
+		hr = deviceCollection->Item(i, &device);
+		if (FAILED(hr)) continue;
+
+		EndpointInfo info;
+		info.flow = pFlow;
+		info.state = 0;
+		hr = ReadEndpointInfo(device, info);
+		if (FAILED(hr)) continue;
+
+		pEndpoints.push_back(info);
+	}
+	return S_OK;
+}
+
+EndpointResult WasapiEndpointProvider::GetEndpointInfo(const std::string& pEndpointId, EndpointInfo& pInfo)
+{
+	if (_deviceEnumerator == NULL) return E_POINTER;
+
+	std::wstring endpointId;
+	ToWString(pEndpointId, endpointId);
+	CComPtr<IMMDevice> device;
+	HRESULT hr = _deviceEnumerator->GetDevice(endpointId.c_str(), &device);
+	if (SUCCEEDED(hr))
+	{
+		pInfo.flow = EndpointFlow::Capture;
+		pInfo.state = 0;
+		hr = ReadEndpointInfo(device, pInfo);
+	}
+	return hr;
+}
+
+EndpointResult WasapiEndpointProvider::OpenEndpoint(const std::string& pEndpointId, std::unique_ptr<IAudioEndpoint>& pEndpoint)
+{
+	if (_deviceEnumerator == NULL) return E_POINTER;
+
+	std::wstring endpointId;
+	ToWString(pEndpointId, endpointId);
+	CComPtr<IMMDevice> device;
+	HRESULT hr = _deviceEnumerator->GetDevice(endpointId.c_str(), &device);
+	if (SUCCEEDED(hr))
+	{
+		pEndpoint.reset(new WasapiAudioEndpoint(device, pEndpointId));
+	}
+	return hr;
+}
+
+EndpointResult WasapiEndpointProvider::GetDefaultEndpointId(EndpointFlow pFlow, std::string& pEndpointId)
+{
+	if (_deviceEnumerator == NULL) return E_POINTER;
+
+	CComPtr<IMMDevice> device;
+	HRESULT hr = _deviceEnumerator->GetDefaultAudioEndpoint(ToDataFlow(pFlow), eConsole, &device);
+	if (SUCCEEDED(hr))
+	{
+		LPWSTR pwszID = NULL;
+		hr = device->GetId(&pwszID);
+		if (SUCCEEDED(hr))
+		{
+			ToUtf8String(pwszID, pEndpointId);
+			CoTaskMemFree(pwszID);
+		}
+	}
+	return hr;
+}
+
+EndpointResult WasapiEndpointProvider::RegisterNotificationClient(IEndpointNotificationClient* pClient)
+{
+	if (_deviceEnumerator == NULL) return E_POINTER;
+	if (pClient == NULL) return E_INVALIDARG;
+
+	WasapiNotificationClient* notificationClient = new WasapiNotificationClient(pClient);
+	HRESULT hr = _deviceEnumerator->RegisterEndpointNotificationCallback(notificationClient);
+	if (SUCCEEDED(hr))
+	{
+		_notificationClients.push_back(notificationClient);
+	}
+	else
+	{
+		notificationClient->Release();
+	}
+	return hr;
+}
+
+EndpointResult WasapiEndpointProvider::UnregisterNotificationClient(IEndpointNotificationClient* pClient)
+{
+	for (auto it = _notificationClients.begin(); it != _notificationClients.end(); ++it)
+	{
+		if ((*it)->GetClient() == pClient)
+		{
+			HRESULT hr = _deviceEnumerator->UnregisterEndpointNotificationCallback(*it);
+			(*it)->Release();
+			_notificationClients.erase(it);
+			return hr;
+		}
+	}
+	return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+}
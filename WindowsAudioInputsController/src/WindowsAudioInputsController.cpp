@@ -16,318 +16,1972 @@
 * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
 ******************************************************************************************************************************************************/
 
-#include <mmdeviceapi.h>
-#include <audioclient.h>
-#include <atlbase.h>
-#include <functiondiscoverykeys_devpkey.h>
-#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
 
+#include "AudioDeviceDirectory.h"
+#include "AudioEndpointProvider.h"
+#include "EndpointProperties.h"
+#include "ListenProfile.h"
 #include "WindowsAudioInputsController.h"
+#include "WorkerPool.h"
 
-// Hardcoded values
-const GUID LISTEN_SETTING_GUID = { 0x24DBB0FC, 0x9311, 0x4B3D, { 0x9C, 0xF0, 0x18, 0xFF, 0x15, 0x56, 0x39, 0xD4 } };
-const int CHECKBOX_PID = 1;
-const int LISTENING_DEVICE_PID = 0;
+// Listen to Device settings: a change of any of them is refreshed as a listen state change.
+const EndpointGuid LISTEN_SETTING_GUID = ListenEnabledProperty::GetKey().fmtid;
+// Listen target id of the default output device.
+const std::string DEFAULT_OUTPUT_DEVICE_ID;
+// Most worker threads used by the batched calls (the calling thread also takes part): batches up to 32 devices run in one round,
+// larger ones in ceil(n / 32). The calls mostly wait for the audio service, so more threads than cores still help.
+const int MAX_BATCH_WORKER_THREADS = 31;
+
+// Error of a failed property read or write: the failures decided by the call policy have their own codes.
+static WAIC_ErrorCode GetFailureCode(EndpointResult pResult, WAIC_ErrorCode pDefault)
+{
+	switch (pResult)
+	{
+	case ENDPOINT_E_TIMEOUT: return WAIC_ERROR_TIMEOUT;
+	case ENDPOINT_E_CIRCUIT_OPEN: return WAIC_ERROR_CIRCUIT_OPEN;
+	default: return pDefault;
+	}
+}
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////// HELPERS /////////////////////////////////////////////////
+///////////////////////////////////////////// WindowsAudioInput ///////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-void ToWString(const char* pInStr, std::wstring& pOutStr)
+WindowsAudioInput::WindowsAudioInput(): _audioEndpoint(NULL), _propertyReads(NULL), _stats(NULL), _policy(NULL), _propertiesMutex(), _properties(), _breaker(), _listenState(LISTEN_STATE_UNKNOWN), _pendingListenState(LISTEN_STATE_UNKNOWN),
+	_listenTargetMutex(), _listenTarget(), _pendingListenTarget(), _ownWriteNotifications(0), _ownWriteTimeNs(0)
+{
+	_name[0] = '\0';
+}
+
+WindowsAudioInput::~WindowsAudioInput()
+{
+	Close();
+}
+
+EndpointResult WindowsAudioInput::Open(IAudioEndpointProvider* pProvider, const std::string& pEndpointId, const char* pName, std::atomic<uint64_t>* pPropertyReads,
+	ControllerStats* pStats, CallPolicy* pPolicy)
 {
-	int len = MultiByteToWideChar(CP_UTF8, 0, pInStr, -1, NULL, 0);
-	if (len > 0)
+	Close();
+	std::unique_ptr<IAudioEndpoint> audioEndpoint;
+	EndpointResult hr = pProvider->OpenEndpoint(pEndpointId, audioEndpoint);
+	if (EndpointSucceeded(hr))
 	{
-		pOutStr.resize(len - 1); // resize without the null terminator
-		MultiByteToWideChar(CP_UTF8, 0, pInStr, -1, &pOutStr[0], len);
+		_audioEndpoint = audioEndpoint.release();
+		_propertyReads = pPropertyReads;
+		_stats = pStats;
+		_policy = pPolicy;
+		std::lock_guard<std::mutex> lock(_propertiesMutex);
+		_properties.Reset(_audioEndpoint, _stats);
+		_breaker.Reset();
+		_ownWriteNotifications = 0;
+		strncpy(_name, pName, WAIC_DEVICE_NAME_SIZE - 1);
+		_name[WAIC_DEVICE_NAME_SIZE - 1] = '\0';
 	}
-	else
+	return hr;
+}
+
+void WindowsAudioInput::Close()
+{
 	{
-		// Clear output if conversion fails
-		pOutStr.clear();
+		std::lock_guard<std::mutex> lock(_propertiesMutex);
+		_properties.Reset(NULL, NULL);
 	}
+	delete _audioEndpoint;
+	_audioEndpoint = NULL;
+	_listenState = LISTEN_STATE_UNKNOWN;
+	_pendingListenState = LISTEN_STATE_UNKNOWN;
+	_name[0] = '\0';
 }
 
-void GetDeviceID(IMMDevice* pDevice, std::wstring& pDeviceID)
+EndpointResult WindowsAudioInput::IsListening(bool& pIsListening) const
 {
-	LPWSTR pwszID = NULL;
-	HRESULT hr = pDevice->GetId(&pwszID);
-	if (SUCCEEDED(hr))
+	if (TryGetCachedListenState(pIsListening))
 	{
-		pDeviceID = pwszID;
-		CoTaskMemFree(pwszID);
+		if (_stats != NULL) _stats->AddCacheHit(WAIC_CACHE_LISTEN_STATE);
+		return ENDPOINT_OK;
 	}
+
+	if (_stats != NULL) _stats->AddCacheMiss(WAIC_CACHE_LISTEN_STATE);
+	EndpointResult hr = RefreshListenState();
+	if (!EndpointSucceeded(hr)) return hr;
+	pIsListening = (_listenState.load(std::memory_order_acquire) == LISTEN_STATE_ON);
+	return ENDPOINT_OK;
 }
 
-IMMDevice* GetDeviceByName(IMMDeviceEnumerator* pEnumerator, const std::wstring& pDeviceName)
+EndpointResult WindowsAudioInput::GetListenTarget(std::string& pOutputDeviceID) const
 {
-	IMMDeviceCollection* pDeviceCollection = NULL;
-	IMMDevice* pDevice = NULL;
-	IPropertyStore* pProps = NULL;
-	HRESULT hr = S_OK;
-
-	// Obtenir tous les priphriques de capture audio (microphones)
-	hr = pEnumerator->EnumAudioEndpoints(eCapture, DEVICE_STATE_ACTIVE, &pDeviceCollection);
-	if (FAILED(hr)) return NULL;
+	pOutputDeviceID.clear();
+	if (_listenState.load(std::memory_order_acquire) == LISTEN_STATE_UNKNOWN)
+	{
+		EndpointResult hr = RefreshListenState();
+		if (!EndpointSucceeded(hr)) return hr;
+	}
+	std::lock_guard<std::mutex> lock(_listenTargetMutex);
+	pOutputDeviceID = _listenTarget;
+	return ENDPOINT_OK;
+}
 
-	UINT deviceCount;
-	pDeviceCollection->GetCount(&deviceCount);
+void WindowsAudioInput::CopyListenTarget(char* pBuffer, size_t pSize) const
+{
+	std::lock_guard<std::mutex> lock(_listenTargetMutex);
+	strncpy(pBuffer, _listenTarget.c_str(), pSize - 1);
+	pBuffer[pSize - 1] = '\0';
+}
 
-	for (UINT i = 0; i < deviceCount; i++)
+EndpointResult WindowsAudioInput::RefreshListenState() const
+{
+	if (_propertyReads != NULL)
 	{
-		hr = pDeviceCollection->Item(i, &pDevice);
-		if (FAILED(hr)) continue;
-
-		// Rcuprer le Property Store pour lire les proprits du priphrique
-		hr = pDevice->OpenPropertyStore(STGM_READ, &pProps);
-		if (FAILED(hr)) continue;
+		++(*_propertyReads);
+	}
 
-		// Lire la proprit PKEY_Device_FriendlyName
-		PROPVARIANT varName;
-		PropVariantInit(&varName);
-		hr = pProps->GetValue(PKEY_Device_FriendlyName, &varName);
-		if (SUCCEEDED(hr))
-		{
-			// Comparer le nom du priphrique avec le nom cible
-			if (pDeviceName == varName.pwszVal)
-			{
-				// Si les noms correspondent, nous avons trouv notre priphrique
-				pProps->Release();
-				PropVariantClear(&varName);
-				pDeviceCollection->Release();
-				return pDevice;
-			}
-			PropVariantClear(&varName);
-		}
-		pProps->Release();
-		pDevice->Release();
+	bool isListening = false;
+	std::string outputDeviceID;
+	EndpointResult hr = _AccessProperties([&] { return _properties.Read<ListenEnabledProperty, ListenTargetProperty>(isListening, outputDeviceID); });
+	if (EndpointSucceeded(hr))
+	{
+		_CacheListenState(isListening, outputDeviceID);
+		return hr;
 	}
-	pDeviceCollection->Release();
-	return NULL;
+	_listenState = LISTEN_STATE_UNKNOWN;
+	return hr;
 }
 
-bool SetCheckboxListenToDeviceProperty(IPropertyStore* pPropertyStore, bool pEnableListen)
+bool WindowsAudioInput::ConsumeOwnWriteNotification()
 {
-	HRESULT hr = E_FAIL;
-
-	PROPERTYKEY checkboxPK;
-	checkboxPK.fmtid = LISTEN_SETTING_GUID;
-	checkboxPK.pid = CHECKBOX_PID;
-
-	PROPVARIANT checkboxValue;
-	PropVariantInit(&checkboxValue);
-	checkboxValue.vt = VT_BOOL;
-	checkboxValue.boolVal = pEnableListen ? VARIANT_TRUE : VARIANT_FALSE;
+	int64_t elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() - _ownWriteTimeNs.load(std::memory_order_acquire);
+	if (elapsedNs > (int64_t)OWN_WRITE_ECHO_MS * 1000000)
+	{
+		// Too old: the notifications of the write have been missed, the next ones come from outside of the controller.
+		_ownWriteNotifications = 0;
+		return false;
+	}
+	int count = _ownWriteNotifications.load(std::memory_order_acquire);
+	while (count > 0 && !_ownWriteNotifications.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel))
+	{
+	}
+	return count > 0;
+}
 
-	hr = pPropertyStore->SetValue(checkboxPK, checkboxValue);
-	hr &= PropVariantClear(&checkboxValue);
+void WindowsAudioInput::_ExpectOwnWriteNotifications(int pCount)
+{
+	_ownWriteTimeNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_release);
+	_ownWriteNotifications.fetch_add(pCount, std::memory_order_acq_rel);
+}
 
-	return SUCCEEDED(hr);
+void WindowsAudioInput::ClosePropertySession()
+{
+	std::lock_guard<std::mutex> lock(_propertiesMutex);
+	_properties.Close();
 }
 
-bool GetCheckboxListenToDeviceProperty(IPropertyStore* pPropertyStore, bool& pIsListening)
+EndpointResult WindowsAudioInput::SetListen(bool pListen, const std::string& pOutputDeviceID)
 {
-	HRESULT hr = E_FAIL;
-	pIsListening = false;
+	_pendingListenState = LISTEN_STATE_UNKNOWN;
+	return _WriteListen(pListen, pOutputDeviceID);
+}
 
-	PROPERTYKEY checkboxPK;
-	checkboxPK.fmtid = LISTEN_SETTING_GUID;
-	checkboxPK.pid = CHECKBOX_PID;
+bool WindowsAudioInput::SetPendingListen(bool pListen, const std::string& pOutputDeviceID)
+{
+	{
+		std::lock_guard<std::mutex> lock(_listenTargetMutex);
+		_pendingListenTarget = pOutputDeviceID;
+	}
+	uint8_t previous = _pendingListenState.exchange(pListen ? LISTEN_STATE_ON : LISTEN_STATE_OFF, std::memory_order_acq_rel);
+	return previous != LISTEN_STATE_UNKNOWN;
+}
 
-	PROPVARIANT checkboxValue;
-	PropVariantInit(&checkboxValue);
+EndpointResult WindowsAudioInput::CommitPendingListen()
+{
+	uint8_t pendingListenState = _pendingListenState.load(std::memory_order_acquire);
+	if (pendingListenState == LISTEN_STATE_UNKNOWN) return ENDPOINT_S_FALSE;
 
-	hr = pPropertyStore->GetValue(checkboxPK, &checkboxValue);
-	if (SUCCEEDED(hr))
+	std::string pendingListenTarget;
 	{
-		pIsListening = (checkboxValue.vt == VT_BOOL && checkboxValue.boolVal == VARIANT_TRUE);
-		hr = PropVariantClear(&checkboxValue);
-		return (SUCCEEDED(hr));
+		std::lock_guard<std::mutex> lock(_listenTargetMutex);
+		pendingListenTarget.swap(_pendingListenTarget);
 	}
 
-	return false;
+	// The pending state is kept until written, so that it is still returned by IsListening() meanwhile.
+	EndpointResult hr = _WriteListen(pendingListenState == LISTEN_STATE_ON, pendingListenTarget);
+	_pendingListenState = LISTEN_STATE_UNKNOWN;
+	return hr;
 }
 
-bool SetOutputDeviceListenToDeviceProperty(IPropertyStore* pPropertyStore, const std::wstring& pOutputDeviceID)
+bool WindowsAudioInput::GetCachedListenState(bool& pListen, std::string& pOutputDeviceID) const
 {
-	HRESULT hr = E_FAIL;
+	uint8_t listenState = _listenState.load(std::memory_order_acquire);
+	if (listenState == LISTEN_STATE_UNKNOWN) return false;
 
-	PROPERTYKEY devicePK;
-	devicePK.fmtid = LISTEN_SETTING_GUID;
-	devicePK.pid = LISTENING_DEVICE_PID;
+	pListen = (listenState == LISTEN_STATE_ON);
+	std::lock_guard<std::mutex> lock(_listenTargetMutex);
+	pOutputDeviceID = _listenTarget;
+	return true;
+}
 
-	PROPVARIANT deviceValue;
-	PropVariantInit(&deviceValue);
+bool WindowsAudioInput::MatchesListenState(bool pListen, const std::string& pOutputDeviceID) const
+{
+	if (HasPendingListen() || _listenState.load(std::memory_order_acquire) != (pListen ? LISTEN_STATE_ON : LISTEN_STATE_OFF))
+	{
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(_listenTargetMutex);
+	return _listenTarget == pOutputDeviceID;
+}
 
-	if (!pOutputDeviceID.empty())
+EndpointResult WindowsAudioInput::_WriteListen(bool pListen, const std::string& pOutputDeviceID)
+{
+	// Already in the requested state, with the same output device: nothing to write.
+	if (_listenState.load(std::memory_order_acquire) == (pListen ? LISTEN_STATE_ON : LISTEN_STATE_OFF))
 	{
-		deviceValue.vt = VT_LPWSTR;
-		deviceValue.pwszVal = const_cast<LPWSTR>(pOutputDeviceID.c_str());
+		std::lock_guard<std::mutex> lock(_listenTargetMutex);
+		if (_listenTarget == pOutputDeviceID)
+		{
+			return ENDPOINT_S_FALSE;
+		}
 	}
-	else
+
+	// "Listen to Device" checkbox, then the output device. openResult stays a failure if nothing was written (call rejected by the policy).
+	EndpointResult openResult = ENDPOINT_E_FAIL;
+	EndpointResult hr = _AccessProperties([&]
+	{
+		EndpointResult writeResult = _properties.Write<ListenEnabledProperty, ListenTargetProperty>(pListen, pOutputDeviceID);
+		openResult = _properties.GetResult();
+		return writeResult;
+	});
+	if (EndpointSucceeded(hr))
+	{
+		_CacheListenState(pListen, pOutputDeviceID);
+		_ExpectOwnWriteNotifications(2);
+	}
+	else if (EndpointSucceeded(openResult))
+	{
+		// Partially written: the actual state is unknown.
+		InvalidateListenState();
+	}
+	return hr;
+}
+
+EndpointResult WindowsAudioInput::GetContinueOnBattery(bool& pContinueOnBattery) const
+{
+	pContinueOnBattery = false;
+	return _AccessProperties([&] { return _properties.Read<ListenContinueOnBatteryProperty>(pContinueOnBattery); });
+}
+
+EndpointResult WindowsAudioInput::SetContinueOnBattery(bool pContinueOnBattery)
+{
+	EndpointResult hr = _AccessProperties([&] { return _properties.Write<ListenContinueOnBatteryProperty>(pContinueOnBattery); });
+	if (EndpointSucceeded(hr))
 	{
-		deviceValue.vt = VT_EMPTY;
+		// Another listen setting: its notification does not change the listen state.
+		_ExpectOwnWriteNotifications(1);
 	}
+	return hr;
+}
+
+EndpointResult WindowsAudioInput::OpenMeter(std::unique_ptr<IEndpointMeter>& pMeter) const
+{
+	return _audioEndpoint->OpenMeter(pMeter);
+}
 
-	hr = pPropertyStore->SetValue(devicePK, deviceValue);
-	hr &= PropVariantClear(&deviceValue);
+EndpointResult WindowsAudioInput::OpenStream(uint32_t pBufferUs, std::unique_ptr<IEndpointStream>& pStream) const
+{
+	return _audioEndpoint->OpenStream(pBufferUs, 0, pStream);
+}
 
-	return SUCCEEDED(hr);
+void WindowsAudioInput::_CacheListenState(bool pListen, const std::string& pOutputDeviceID) const
+{
+	{
+		std::lock_guard<std::mutex> lock(_listenTargetMutex);
+		_listenTarget = pOutputDeviceID;
+	}
+	_listenState.store(pListen ? LISTEN_STATE_ON : LISTEN_STATE_OFF, std::memory_order_release);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////// WindowsAudioInput ///////////////////////////////////////////
+///////////////////////////////////////// WindowsAudioInputsController ////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-WindowsAudioInput::WindowsAudioInput(IMMDevice* pAudioDevice): _audioDevice(pAudioDevice)
+WindowsAudioInputsController::WindowsAudioInputsController(const InitOptions& pOptions): _errors(), _stats(), _provider(CreateDefaultEndpointProvider()), _providerReady(false),
+	_initState(InitState::Initializing), _initStateMutex(), _initStateChanged(), _failFast(false), _prewarmDeviceNames(), _prewarmRequest(), _prewarmCancelled(false), _notificationsRegistered(false), _audioInputsDirectory(NULL), _outputsDirectory(NULL),
+	_hasNotifications(false), _notificationsMutex(), _notifications(), _notificationsScheduled(false), _notificationsRequest(), _listenStateReads(0), _writeCoalescingWindowMs(0), _callPolicy(&_stats), _callTimeoutMs(0), _timedCallsMutex(), _timedCallDone(), _pendingWrites(), _savedWrites(0), _events(), _levelMeter(), _monitors(), _eventCallback(NULL), _eventCallbackUserData(NULL), _audioInputsMutex(), _audioInputs(), _audioInputsByEndpointId(), _devices(), _outputs(), _outputDevices(), _workerPool(NULL), _snapshotAudioInputs(), _snapshotUnknownStates(),
+	_asyncCursor(0), _backendThread()
 {
+	_Start(pOptions);
+}
 
+WindowsAudioInputsController::WindowsAudioInputsController(IAudioEndpointProvider* pProvider, const InitOptions& pOptions) : _errors(), _stats(), _provider(pProvider), _providerReady(false),
+	_initState(InitState::Initializing), _initStateMutex(), _initStateChanged(), _failFast(false), _prewarmDeviceNames(), _prewarmRequest(), _prewarmCancelled(false), _notificationsRegistered(false), _audioInputsDirectory(NULL), _outputsDirectory(NULL),
+	_hasNotifications(false), _notificationsMutex(), _notifications(), _notificationsScheduled(false), _notificationsRequest(), _listenStateReads(0), _writeCoalescingWindowMs(0), _callPolicy(&_stats), _callTimeoutMs(0), _timedCallsMutex(), _timedCallDone(), _pendingWrites(), _savedWrites(0), _events(), _levelMeter(), _monitors(), _eventCallback(NULL), _eventCallbackUserData(NULL), _audioInputsMutex(), _audioInputs(), _audioInputsByEndpointId(), _devices(), _outputs(), _outputDevices(), _workerPool(NULL), _snapshotAudioInputs(), _snapshotUnknownStates(),
+	_asyncCursor(0), _backendThread()
+{
+	_Start(pOptions);
 }
 
-WindowsAudioInput::~WindowsAudioInput()
+WindowsAudioInputsController::~WindowsAudioInputsController()
 {
-	if (_audioDevice != NULL)
+	_prewarmCancelled = true;
+	_levelMeter.Stop();
+	// Completes the pending requests, then releases the backend on its own thread.
+	_backendThread.Stop();
+}
+
+void WindowsAudioInputsController::_Start(const InitOptions& pOptions)
+{
+	_failFast = pOptions.failFast;
+	_prewarmDeviceNames = pOptions.prewarmDeviceNames;
+	_prewarmRequest.controller = this;
+	_prewarmRequest.next = 0;
+	_notificationsRequest.controller = this;
+	for (AsyncRequest& request : _asyncRequests)
+	{
+		request.controller = this;
+		request.state = AsyncRequest::Free;
+		request.generation = 0;
+		request.timed = false;
+	}
+
+	_backendThread.Start([this] { _Init(); }, [this] { _Shutdown(); }, [this] { _CommitPendingWrites(); });
+	if (!pOptions.async)
 	{
-		_audioDevice->Release();
+		WaitReady(-1);
 	}
 }
 
-WindowsAudioInput* WindowsAudioInput::Create(IMMDeviceEnumerator* pDeviceEnumerator, const char* pDeviceName)
+void WindowsAudioInputsController::_SetInitState(InitState pState)
 {
-	WindowsAudioInput* wai = NULL;
-	std::wstring targetDeviceName;
-	ToWString(pDeviceName, targetDeviceName);
-	IMMDevice* audioDevice = GetDeviceByName(pDeviceEnumerator, targetDeviceName);
-	if (audioDevice != NULL)
 	{
-		wai = new WindowsAudioInput(audioDevice);
+		std::lock_guard<std::mutex> lock(_initStateMutex);
+		_initState.store(pState, std::memory_order_release);
 	}
-	return wai;
+	_initStateChanged.notify_all();
 }
 
-bool WindowsAudioInput::IsListening(bool& pIsListening) const
+bool WindowsAudioInputsController::WaitReady(int pTimeoutMs)
 {
-	pIsListening = false;
-	CComPtr<IPropertyStore> propertyStore;
-	HRESULT hr = _audioDevice->OpenPropertyStore(STGM_READ, &propertyStore);
-	if (SUCCEEDED(hr)) 
+	std::unique_lock<std::mutex> lock(_initStateMutex);
+	auto initialized = [this] { return _initState.load(std::memory_order_acquire) != InitState::Initializing; };
+	if (pTimeoutMs < 0)
 	{
-		return GetCheckboxListenToDeviceProperty(propertyStore, pIsListening);
+		_initStateChanged.wait(lock, initialized);
+	}
+	else if (!_initStateChanged.wait_for(lock, std::chrono::milliseconds(pTimeoutMs), initialized))
+	{
+		return false;
+	}
+	return _initState.load(std::memory_order_acquire) == InitState::Ready;
+}
+
+void WindowsAudioInputsController::PrewarmRequest::Execute()
+{
+	if (controller->_PrewarmNext())
+	{
+		controller->_backendThread.Submit(this);
 	}
-	return false;
 }
 
-bool WindowsAudioInput::SetListen(bool pListen)
+bool WindowsAudioInputsController::_PrewarmNext()
 {
-	CComPtr<IPropertyStore> propertyStore;
-	HRESULT hr = _audioDevice->OpenPropertyStore(STGM_READWRITE, &propertyStore);
-	if (SUCCEEDED(hr))
+	if (!_prewarmCancelled && _prewarmRequest.next < _prewarmDeviceNames.size())
+	{
+		// Not found devices are reported as errors, as any other call.
+		bool isListening = false;
+		_ApplyNotifications();
+		_ReadListenState(_GetOrCreate(_prewarmDeviceNames[_prewarmRequest.next++].c_str(), WAIC_OP_INIT), isListening);
+	}
+	if (!_prewarmCancelled && _prewarmRequest.next < _prewarmDeviceNames.size())
 	{
-		// Set the "Listen to Device" checkbox
-		bool sucess = SetCheckboxListenToDeviceProperty(propertyStore, pListen);
-		sucess &= SetOutputDeviceListenToDeviceProperty(propertyStore, std::wstring()); // Set to default output device
-		return sucess;
+		return true;
 	}
+	_SetInitState(InitState::Ready);
 	return false;
 }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////// WindowsAudioInputsController ////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
-WindowsAudioInputsController::WindowsAudioInputsController(): _hasError(false), _errorsLog(), _deviceEnumerator(NULL), _audioInputs()
+void WindowsAudioInputsController::_Init()
 {
-	HRESULT hr = CoInitialize(NULL);
-	if (SUCCEEDED(hr))
+	EndpointResult hr = ENDPOINT_E_FAIL;
+	if (_provider != NULL)
 	{
-		hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), NULL, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator), (void**)&_deviceEnumerator);
-		if (SUCCEEDED(hr))
+		hr = _provider->Initialize();
+		if (EndpointSucceeded(hr))
 		{
+			_audioInputsDirectory = new AudioDeviceDirectory(_provider, EndpointFlow::Capture, &_stats);
+			_outputsDirectory = new AudioDeviceDirectory(_provider, EndpointFlow::Render, &_stats);
+			// Without notifications, devices changes are only seen through RefreshAudioInputs().
+			_notificationsRegistered = EndpointSucceeded(_provider->RegisterNotificationClient(this));
+			_providerReady = true;
+
+			// Enumerated right away, so that the first calls find the directory ready.
+			if (!_audioInputsDirectory->Refresh())
+			{
+				_errors.Record(WAIC_ERROR_ENUMERATION_FAILED, WAIC_OP_INIT, ENDPOINT_E_FAIL, NULL);
+			}
+			if (_prewarmDeviceNames.empty())
+			{
+				_SetInitState(InitState::Ready);
+			}
+			else
+			{
+				_backendThread.Submit(&_prewarmRequest);
+			}
 			return;
 		}
 	}
 	// FAIL
-	_hasError = true;
-	_errorsLog.append("[WindowsAudioInputsController] Initialization failed !\n");
+	_errors.Record(WAIC_ERROR_INIT_FAILED, WAIC_OP_INIT, hr, NULL);
+	_SetInitState(InitState::Failed);
 }
 
-WindowsAudioInputsController::~WindowsAudioInputsController()
+void WindowsAudioInputsController::_Shutdown()
 {
-	for (auto& it : _audioInputs)
+	_CommitPendingWrites();
+	_providerReady = false;
+	if (_notificationsRegistered)
+	{
+		_provider->UnregisterNotificationClient(this);
+		_notificationsRegistered = false;
+	}
+
+	delete _workerPool;
+	_workerPool = NULL;
+	_levelMeter.UnwatchAll();
+	_monitors.clear();
+
 	{
-		delete it.second;
-		it.second = NULL;
+		std::unique_lock<std::shared_mutex> lock(_audioInputsMutex);
+		for (auto& it : _audioInputs)
+		{
+			WindowsAudioInput* audioInput = _devices.Get(it.second);
+			_devices.Release(it.second);
+			audioInput->Close();
+		}
+		_audioInputs.clear();
+		_audioInputsByEndpointId.clear();
 	}
-	_audioInputs.clear();
 
-	if (_deviceEnumerator != NULL)
+	_outputs.clear();
+	delete _outputsDirectory;
+	_outputsDirectory = NULL;
+	delete _audioInputsDirectory;
+	_audioInputsDirectory = NULL;
+
+	// The backend objects must be released on the thread that created them.
+	delete _provider;
+	_provider = NULL;
+}
+
+const char* WindowsAudioInputsController::GetErrors()
+{
+	static thread_local std::string errorsText;
+	WAIC_ErrorRecord records[ErrorRing::CAPACITY];
+	int count = _errors.Drain(records, ErrorRing::CAPACITY);
+	errorsText.clear();
+	for (int i = 0; i < count; ++i)
 	{
-		_deviceEnumerator->Release();
+		ErrorRing::Format(records[i], errorsText);
 	}
+	return errorsText.c_str();
+}
 
-	CoUninitialize();
+const char* WindowsAudioInputsController::GetStatsJson() const
+{
+	static thread_local std::string statsText;
+	WAIC_Stats stats;
+	_stats.Read(stats);
+	statsText.clear();
+	ControllerStats::FormatJson(stats, statsText);
+	return statsText.c_str();
 }
 
 bool WindowsAudioInputsController::IsListening(const char* pDeviceName)
+{
+	return IsListeningWithTimeout(pDeviceName, _callTimeoutMs.load(std::memory_order_relaxed));
+}
+
+bool WindowsAudioInputsController::SetListenToAudioInputDevice(const char* pDeviceName, bool pListen)
+{
+	return SetListenToAudioInputDeviceWithTimeout(pDeviceName, pListen, _callTimeoutMs.load(std::memory_order_relaxed));
+}
+
+bool WindowsAudioInputsController::IsListeningWithTimeout(const char* pDeviceName, int pTimeoutMs)
 {
 	bool isListening = false;
-	WindowsAudioInput* audioInput = _GetOrCreate(pDeviceName);
-	if (audioInput != NULL)
+	if (!_TryGetCachedListenState(pDeviceName, isListening))
 	{
-		bool success = audioInput->IsListening(isListening);
-		if (!success)
+		// The slots only hold the names that fit in them: a longer one is looked up without limit.
+		if (pTimeoutMs > 0 && pDeviceName != NULL && strlen(pDeviceName) < WAIC_DEVICE_NAME_SIZE)
 		{
-			_hasError = true;
-			_errorsLog.append("[WindowsAudioInputsController] IsListening(").append(pDeviceName).append(") failed !\n");
+			_CallWithTimeout(WAIC_OP_IS_LISTENING, pDeviceName, WAIC_INVALID_DEVICE, false, pTimeoutMs, isListening);
+		}
+		else
+		{
+			_Call(WAIC_OP_IS_LISTENING, [&] { _IsListening(pDeviceName, isListening); });
 		}
 	}
 	return isListening;
 }
 
-bool WindowsAudioInputsController::SetListenToAudioInputDevice(const char* pDeviceName, bool pListen)
+bool WindowsAudioInputsController::SetListenToAudioInputDeviceWithTimeout(const char* pDeviceName, bool pListen, int pTimeoutMs)
+{
+	bool success = false;
+	if (pTimeoutMs > 0 && pDeviceName != NULL && strlen(pDeviceName) < WAIC_DEVICE_NAME_SIZE)
+	{
+		bool value = false;
+		success = _CallWithTimeout(WAIC_OP_SET_LISTEN, pDeviceName, WAIC_INVALID_DEVICE, pListen, pTimeoutMs, value);
+	}
+	else
+	{
+		_Call(WAIC_OP_SET_LISTEN, [&] { success = _SetListenToAudioInputDevice(pDeviceName, pListen); });
+	}
+	return success;
+}
+
+int WindowsAudioInputsController::SetListenToAudioInputDevices(const char* const* pDeviceNames, const bool* pListen, int pCount, bool* pResults)
+{
+	int successCount = 0;
+	_Call(WAIC_OP_SET_LISTEN_BATCH, [&] { successCount = _SetListenToAudioInputDevices(pDeviceNames, pListen, pCount, pResults); });
+	return successCount;
+}
+
+int WindowsAudioInputsController::GetListenStates(const char* const* pDeviceNames, int pCount, bool* pIsListening, bool* pResults)
+{
+	int successCount = 0;
+	_Call(WAIC_OP_GET_LISTEN_STATES, [&] { successCount = _GetListenStates(pDeviceNames, pCount, pIsListening, pResults); });
+	return successCount;
+}
+
+bool WindowsAudioInputsController::RefreshAudioInputs()
+{
+	bool success = false;
+	_Call(WAIC_OP_REFRESH, [&] { success = _RefreshAudioInputs(); });
+	return success;
+}
+
+int WindowsAudioInputsController::SaveListenProfile(void* pBuffer, int pSize)
+{
+	int size = 0;
+	_Call(WAIC_OP_SAVE_PROFILE, [&] { size = _SaveListenProfile(pBuffer, pSize); });
+	return size;
+}
+
+int WindowsAudioInputsController::RestoreListenProfile(const void* pBuffer, int pSize)
 {
-	WindowsAudioInput* audioInput = _GetOrCreate(pDeviceName);
-	if (audioInput != NULL)
+	int count = 0;
+	_Call(WAIC_OP_RESTORE_PROFILE, [&] { count = _RestoreListenProfile(pBuffer, pSize); });
+	return count;
+}
+
+int WindowsAudioInputsController::Snapshot(WAIC_DeviceSnapshot* pRecords, int pCapacity, int* pRequiredCount)
+{
+	int count = 0;
+	_Call(WAIC_OP_SNAPSHOT, [&] { count = _Snapshot(pRecords, pCapacity, pRequiredCount); });
+	return count;
+}
+
+WAIC_DeviceHandle WindowsAudioInputsController::OpenDevice(const char* pDeviceName)
+{
+	WAIC_DeviceHandle device = WAIC_INVALID_DEVICE;
+	_Call(WAIC_OP_OPEN_DEVICE, [&] { _ApplyNotifications(); device = _Open(pDeviceName, WAIC_OP_OPEN_DEVICE); });
+	return device;
+}
+
+WAIC_DeviceHandle WindowsAudioInputsController::OpenDeviceMatching(const char* pPattern, WAIC_MatchMode pMode)
+{
+	WAIC_DeviceHandle device = WAIC_INVALID_DEVICE;
+	_Call(WAIC_OP_OPEN_DEVICE, [&] { _ApplyNotifications(); device = _OpenMatching(pPattern, pMode, WAIC_OP_OPEN_DEVICE); });
+	return device;
+}
+
+bool WindowsAudioInputsController::GetMatchingDeviceName(const char* pPattern, WAIC_MatchMode pMode, char* pName, int pSize)
+{
+	bool found = false;
+	_Call(WAIC_OP_OPEN_DEVICE, [&]
 	{
-		bool success = audioInput->SetListen(pListen);
-		if (!success)
+		_ApplyNotifications();
+		const EndpointInfo* endpoint = _providerReady ? _audioInputsDirectory->Match(pPattern, pMode) : NULL;
+		if (endpoint != NULL && pName != NULL && pSize > 0)
 		{
-			_hasError = true;
-			_errorsLog.append("[WindowsAudioInputsController] SetListenToAudioInputDevice(")
-				.append(pDeviceName).append(", ").append(pListen ? "true" : "false").append(") failed !\n");
+			strncpy(pName, endpoint->friendlyName.c_str(), pSize - 1);
+			pName[pSize - 1] = '\0';
+			found = true;
 		}
-		return success;
-	}
-	return false;
+	});
+	return found;
 }
 
-WindowsAudioInput* WindowsAudioInputsController::_GetOrCreate(const char* pDeviceName)
+bool WindowsAudioInputsController::IsDeviceListening(WAIC_DeviceHandle pDevice)
 {
-	WindowsAudioInput* audioInput = NULL;
-	if (_deviceEnumerator != NULL)
+	bool isListening = false;
+	if (!_TryGetCachedListenState(pDevice, isListening))
 	{
-		// Device already exists ?
-		auto it = _audioInputs.find(pDeviceName);
-		if (it != _audioInputs.end())
+		int timeoutMs = _callTimeoutMs.load(std::memory_order_relaxed);
+		if (timeoutMs > 0 && pDevice != WAIC_INVALID_DEVICE)
 		{
-			audioInput = it->second;
+			_CallWithTimeout(WAIC_OP_IS_LISTENING, NULL, pDevice, false, timeoutMs, isListening);
 		}
 		else
 		{
-			// Try to create it, if not existing
-			audioInput = WindowsAudioInput::Create(_deviceEnumerator, pDeviceName);
-			if (audioInput != NULL)
-			{
-				_audioInputs[pDeviceName] = audioInput;
-			}
-			else
-			{
-				_hasError = true;
-				_errorsLog.append("[WindowsAudioInputsController] Audio device ").append(pDeviceName).append(" not found !\n");
-			}
+			_Call(WAIC_OP_IS_LISTENING, [&] { _IsDeviceListening(pDevice, isListening); });
 		}
 	}
+	return isListening;
+}
+
+bool WindowsAudioInputsController::SetListenToDevice(WAIC_DeviceHandle pDevice, bool pListen)
+{
+	bool success = false;
+	int timeoutMs = _callTimeoutMs.load(std::memory_order_relaxed);
+	if (timeoutMs > 0 && pDevice != WAIC_INVALID_DEVICE)
+	{
+		bool value = false;
+		success = _CallWithTimeout(WAIC_OP_SET_LISTEN, NULL, pDevice, pListen, timeoutMs, value);
+	}
 	else
 	{
-		_hasError = true;
-		_errorsLog.append("[WindowsAudioInputsController] IMMDeviceEnumerator is null !\n");
+		_Call(WAIC_OP_SET_LISTEN, [&] { success = _SetListenToDevice(pDevice, pListen); });
+	}
+	return success;
+}
+
+int WindowsAudioInputsController::SetListenToDevices(const WAIC_DeviceHandle* pDevices, const bool* pListen, int pCount, bool* pResults)
+{
+	int successCount = 0;
+	_Call(WAIC_OP_SET_LISTEN_BATCH, [&] { successCount = _SetListenToDevices(pDevices, pListen, pCount, pResults); });
+	return successCount;
+}
+
+int WindowsAudioInputsController::GetDeviceListenStates(const WAIC_DeviceHandle* pDevices, int pCount, bool* pIsListening, bool* pResults)
+{
+	int successCount = 0;
+	_Call(WAIC_OP_GET_LISTEN_STATES, [&] { successCount = _GetDeviceListenStates(pDevices, pCount, pIsListening, pResults); });
+	return successCount;
+}
+
+bool WindowsAudioInputsController::GetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool& pContinueOnBattery)
+{
+	bool success = false;
+	pContinueOnBattery = false;
+	_Call(WAIC_OP_CONTINUE_ON_BATTERY, [&] { success = _GetDeviceContinueOnBattery(pDevice, pContinueOnBattery); });
+	return success;
+}
+
+bool WindowsAudioInputsController::SetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool pContinueOnBattery)
+{
+	bool success = false;
+	_Call(WAIC_OP_CONTINUE_ON_BATTERY, [&] { success = _SetDeviceContinueOnBattery(pDevice, pContinueOnBattery); });
+	return success;
+}
+
+bool WindowsAudioInputsController::StartLevelMetering(int pRateHz)
+{
+	bool success = false;
+	_Call(WAIC_OP_LEVEL_METERING, [&] { success = _providerReady && _levelMeter.Start(_provider, pRateHz); });
+	return success;
+}
+
+bool WindowsAudioInputsController::WatchDeviceLevels(WAIC_DeviceHandle pDevice, bool pWatch)
+{
+	bool success = false;
+	_Call(WAIC_OP_LEVEL_METERING, [&] { success = _WatchDeviceLevels(pDevice, pWatch); });
+	return success;
+}
+
+bool WindowsAudioInputsController::StartMonitor(WAIC_DeviceHandle pDevice, WAIC_OutputHandle pOutput, int pBufferMs)
+{
+	bool success = false;
+	_Call(WAIC_OP_MONITOR, [&] { success = _StartMonitor(pDevice, pOutput, pBufferMs); });
+	return success;
+}
+
+bool WindowsAudioInputsController::StopMonitor(WAIC_DeviceHandle pDevice)
+{
+	bool success = false;
+	_Call(WAIC_OP_MONITOR, [&] { success = (_GetMonitor(pDevice, false) != NULL) && _monitors.erase(pDevice) != 0; });
+	return success;
+}
+
+bool WindowsAudioInputsController::SetMonitorGain(WAIC_DeviceHandle pDevice, float pGain)
+{
+	bool success = false;
+	_Call(WAIC_OP_MONITOR, [&]
+	{
+		AudioMonitor* monitor = _GetMonitor(pDevice, true);
+		if (monitor != NULL)
+		{
+			monitor->SetGain(pGain);
+			success = true;
+		}
+	});
+	return success;
+}
+
+bool WindowsAudioInputsController::SetMonitorChannelMap(WAIC_DeviceHandle pDevice, const int* pMap, int pCount)
+{
+	int8_t map[SAMPLES_MAX_CHANNELS];
+	pCount = std::max(0, std::min(pCount, SAMPLES_MAX_CHANNELS));
+	for (int c = 0; c < pCount; ++c)
+	{
+		map[c] = (int8_t)std::max(-1, std::min(pMap[c], 127));
+	}
+
+	bool success = false;
+	_Call(WAIC_OP_MONITOR, [&]
+	{
+		AudioMonitor* monitor = _GetMonitor(pDevice, true);
+		if (monitor != NULL)
+		{
+			monitor->SetChannelMap(map, pCount);
+			success = true;
+		}
+	});
+	return success;
+}
+
+bool WindowsAudioInputsController::GetMonitorStats(WAIC_DeviceHandle pDevice, WAIC_MonitorStats& pStats)
+{
+	memset(&pStats, 0, sizeof(pStats));
+	bool success = false;
+	_Call(WAIC_OP_MONITOR, [&]
+	{
+		// A device that is not monitored has empty stats.
+		AudioMonitor* monitor = _GetMonitor(pDevice, false);
+		if (monitor != NULL)
+		{
+			monitor->GetStats(pStats);
+		}
+		success = (_devices.Get(pDevice) != NULL);
+	});
+	return success;
+}
+
+WAIC_OutputHandle WindowsAudioInputsController::OpenOutputDevice(const char* pOutputDeviceName)
+{
+	WAIC_OutputHandle output = WAIC_INVALID_DEVICE;
+	_Call(WAIC_OP_OPEN_OUTPUT, [&] { _ApplyNotifications(); output = _OpenOutput(pOutputDeviceName, WAIC_OP_OPEN_OUTPUT); });
+	return output;
+}
+
+bool WindowsAudioInputsController::SetListenToAudioInputDeviceTarget(const char* pDeviceName, bool pListen, const char* pOutputDeviceName)
+{
+	bool success = false;
+	_Call(WAIC_OP_SET_LISTEN_TARGET, [&] { success = _SetListenToAudioInputDeviceTarget(pDeviceName, pListen, pOutputDeviceName); });
+	return success;
+}
+
+bool WindowsAudioInputsController::SetListenToDeviceTarget(WAIC_DeviceHandle pDevice, bool pListen, WAIC_OutputHandle pOutput)
+{
+	bool success = false;
+	_Call(WAIC_OP_SET_LISTEN_TARGET, [&] { success = _SetListenToDeviceTarget(pDevice, pListen, pOutput); });
+	return success;
+}
+
+uint64_t WindowsAudioInputsController::IsListeningAsync(const char* pDeviceName, WAIC_Callback pCallback, void* pUserData)
+{
+	return _SubmitAsync(WAIC_OP_IS_LISTENING, pDeviceName, false, pCallback, pUserData);
+}
+
+uint64_t WindowsAudioInputsController::SetListenToAudioInputDeviceAsync(const char* pDeviceName, bool pListen, WAIC_Callback pCallback, void* pUserData)
+{
+	return _SubmitAsync(WAIC_OP_SET_LISTEN, pDeviceName, pListen, pCallback, pUserData);
+}
+
+WAIC_TicketStatus WindowsAudioInputsController::PollTicket(uint64_t pTicket, bool* pSuccess, bool* pValue)
+{
+	uint32_t index = (uint32_t)(pTicket & 0xFFFFFFFF);
+	uint32_t generation = (uint32_t)(pTicket >> 32);
+	if (index == 0 || index > ASYNC_REQUESTS_CAPACITY) return WAIC_TICKET_INVALID;
+
+	AsyncRequest& request = _asyncRequests[index - 1];
+	uint32_t state = request.state.load(std::memory_order_acquire);
+	if (state == AsyncRequest::Free || request.generation.load(std::memory_order_relaxed) != generation || request.callback != NULL || request.timed)
+	{
+		return WAIC_TICKET_INVALID;
+	}
+	if (state == AsyncRequest::Queued) return WAIC_TICKET_PENDING;
+
+	if (pSuccess != NULL) *pSuccess = request.success;
+	if (pValue != NULL) *pValue = request.value;
+	// Only the owner of the ticket can release it.
+	uint32_t done = AsyncRequest::Done;
+	return request.state.compare_exchange_strong(done, AsyncRequest::Free, std::memory_order_acq_rel) ? WAIC_TICKET_DONE : WAIC_TICKET_INVALID;
+}
+
+uint64_t WindowsAudioInputsController::_SubmitAsync(WAIC_Operation pOperation, const char* pDeviceName, bool pListen, WAIC_Callback pCallback, void* pUserData)
+{
+	if (pDeviceName == NULL || strlen(pDeviceName) >= WAIC_DEVICE_NAME_SIZE) return 0;
+
+	AsyncRequest* request = _AcquireAsyncRequest();
+	if (request == NULL) return 0;
+
+	request->operation = pOperation;
+	request->device = WAIC_INVALID_DEVICE;
+	strcpy(request->deviceName, pDeviceName);
+	request->listen = pListen;
+	request->timed = false;
+	request->deadline = std::chrono::steady_clock::time_point::max();
+	request->callback = pCallback;
+	request->userData = pUserData;
+	request->success = false;
+	request->value = false;
+	uint64_t ticket = ((uint64_t)request->generation.load(std::memory_order_relaxed) << 32) | (uint32_t)(request - _asyncRequests + 1);
+	_backendThread.Submit(request);
+	return ticket;
+}
+
+WindowsAudioInputsController::AsyncRequest* WindowsAudioInputsController::_AcquireAsyncRequest()
+{
+	// Finds a free slot, starting after the last acquired one.
+	uint32_t start = _asyncCursor.fetch_add(1, std::memory_order_relaxed);
+	for (uint32_t i = 0; i < ASYNC_REQUESTS_CAPACITY; ++i)
+	{
+		AsyncRequest& request = _asyncRequests[(start + i) % ASYNC_REQUESTS_CAPACITY];
+		uint32_t state = AsyncRequest::Free;
+		if (!request.state.compare_exchange_strong(state, AsyncRequest::Queued, std::memory_order_acq_rel)) continue;
+
+		// Generation 0 is never used, so that a ticket is never 0.
+		uint32_t generation = request.generation.load(std::memory_order_relaxed) + 1;
+		if (generation == 0) generation = 1;
+		request.generation.store(generation, std::memory_order_relaxed);
+		return &request;
+	}
+	return NULL;
+}
+
+bool WindowsAudioInputsController::_CallWithTimeout(WAIC_Operation pOperation, const char* pDeviceName, WAIC_DeviceHandle pDevice, bool pListen, int pTimeoutMs,
+	bool& pValue)
+{
+	if (_failFast && _initState.load(std::memory_order_acquire) == InitState::Initializing)
+	{
+		_errors.Record(WAIC_ERROR_NOT_READY, pOperation, 0, NULL);
+		return false;
+	}
+
+	// Every slot is taken by pending requests (eg. abandoned calls stuck in the backend): waiting would time out as well.
+	AsyncRequest* request = _AcquireAsyncRequest();
+	if (request == NULL)
+	{
+		_errors.Record(WAIC_ERROR_TIMEOUT, pOperation, ENDPOINT_E_TIMEOUT, pDeviceName, (pOperation == WAIC_OP_SET_LISTEN) ? (pListen ? 1 : 0) : -1);
+		_stats.AddFault(WAIC_FAULT_TIMEOUT);
+		return false;
+	}
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(pTimeoutMs);
+	request->operation = pOperation;
+	request->device = pDevice;
+	request->deviceName[0] = '\0';
+	if (pDeviceName != NULL)
+	{
+		strcpy(request->deviceName, pDeviceName);
+	}
+	request->listen = pListen;
+	request->timed = true;
+	request->deadline = deadline;
+	request->callback = NULL;
+	request->userData = NULL;
+	request->success = false;
+	request->value = false;
+	_backendThread.Submit(request);
+
+	std::unique_lock<std::mutex> lock(_timedCallsMutex);
+	if (!_timedCallDone.wait_until(lock, deadline, [&] { return request->state.load(std::memory_order_acquire) == AsyncRequest::Done; }))
+	{
+		// Still queued or running: the backend thread releases the slot once done with it.
+		request->state.store(AsyncRequest::Abandoned, std::memory_order_release);
+		lock.unlock();
+		_errors.Record(WAIC_ERROR_TIMEOUT, pOperation, ENDPOINT_E_TIMEOUT, pDeviceName, (pOperation == WAIC_OP_SET_LISTEN) ? (pListen ? 1 : 0) : -1);
+		_stats.AddFault(WAIC_FAULT_TIMEOUT);
+		return false;
+	}
+
+	bool success = request->success;
+	pValue = request->value;
+	request->state.store(AsyncRequest::Free, std::memory_order_release);
+	return success;
+}
+
+void WindowsAudioInputsController::_CompleteTimedCall(AsyncRequest& pRequest)
+{
+	{
+		std::lock_guard<std::mutex> lock(_timedCallsMutex);
+		uint32_t state = AsyncRequest::Queued;
+		if (!pRequest.state.compare_exchange_strong(state, AsyncRequest::Done, std::memory_order_acq_rel))
+		{
+			// Abandoned by its caller.
+			pRequest.state.store(AsyncRequest::Free, std::memory_order_release);
+			return;
+		}
+	}
+	_timedCallDone.notify_all();
+}
+
+void WindowsAudioInputsController::AsyncRequest::Execute()
+{
+	// A timed call given up before it started is skipped: its caller has already failed.
+	if (state.load(std::memory_order_acquire) != Abandoned)
+	{
+		CallPolicy::DeadlineScope deadlineScope(deadline);
+		if (operation == WAIC_OP_IS_LISTENING)
+		{
+			success = (device != WAIC_INVALID_DEVICE) ? controller->_IsDeviceListening(device, value) : controller->_IsListening(deviceName, value);
+		}
+		else
+		{
+			success = (device != WAIC_INVALID_DEVICE) ? controller->_SetListenToDevice(device, listen) : controller->_SetListenToAudioInputDevice(deviceName, listen);
+			value = listen;
+		}
+	}
+
+	if (timed)
+	{
+		controller->_CompleteTimedCall(*this);
+	}
+	else if (callback != NULL)
+	{
+		uint64_t ticket = ((uint64_t)generation.load(std::memory_order_relaxed) << 32) | (uint32_t)(this - controller->_asyncRequests + 1);
+		callback(ticket, success, value, userData);
+		state.store(Free, std::memory_order_release);
+	}
+	else
+	{
+		state.store(Done, std::memory_order_release);
+	}
+}
+
+bool WindowsAudioInputsController::_TryGetCachedListenState(const char* pDeviceName, bool& pIsListening)
+{
+	WAIC_DeviceHandle device = WAIC_INVALID_DEVICE;
+	{
+		StatsTimer timer(&_stats, WAIC_STAGE_LOOKUP);
+		std::shared_lock<std::shared_mutex> lock(_audioInputsMutex);
+		auto it = _audioInputs.find(pDeviceName);
+		if (it == _audioInputs.end()) return false;
+		device = it->second;
+	}
+	return _TryGetCachedListenState(device, pIsListening);
+}
+
+bool WindowsAudioInputsController::_TryGetCachedListenState(WAIC_DeviceHandle pDevice, bool& pIsListening)
+{
+	// Pending notifications may change the device or its state: they must be applied by the backend thread first.
+	if (_hasNotifications.load(std::memory_order_acquire) || !_providerReady.load(std::memory_order_acquire)) return false;
+
+	// The slot may be released meanwhile by the backend thread: the handle is checked again once the state is read.
+	const WindowsAudioInput* audioInput = _devices.Get(pDevice);
+	if (audioInput != NULL && audioInput->TryGetCachedListenState(pIsListening) && _devices.IsCurrent(pDevice))
+	{
+		_stats.AddCacheHit(WAIC_CACHE_LISTEN_STATE);
+		return true;
+	}
+	return false;
+}
+
+bool WindowsAudioInputsController::_IsListening(const char* pDeviceName, bool& pIsListening)
+{
+	_ApplyNotifications();
+	return _ReadListenState(_GetOrCreate(pDeviceName, WAIC_OP_IS_LISTENING), pIsListening);
+}
+
+bool WindowsAudioInputsController::_SetListenToAudioInputDevice(const char* pDeviceName, bool pListen)
+{
+	_ApplyNotifications();
+	WAIC_DeviceHandle device = _Open(pDeviceName, WAIC_OP_SET_LISTEN);
+	return _SetListen(device, _devices.Get(device), pListen, DEFAULT_OUTPUT_DEVICE_ID);
+}
+
+bool WindowsAudioInputsController::_IsDeviceListening(WAIC_DeviceHandle pDevice, bool& pIsListening)
+{
+	_ApplyNotifications();
+	return _ReadListenState(_Resolve(pDevice, WAIC_OP_IS_LISTENING), pIsListening);
+}
+
+bool WindowsAudioInputsController::_SetListenToDevice(WAIC_DeviceHandle pDevice, bool pListen)
+{
+	_ApplyNotifications();
+	return _SetListen(pDevice, _Resolve(pDevice, WAIC_OP_SET_LISTEN), pListen, DEFAULT_OUTPUT_DEVICE_ID);
+}
+
+bool WindowsAudioInputsController::_GetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool& pContinueOnBattery)
+{
+	_ApplyNotifications();
+	pContinueOnBattery = false;
+	WindowsAudioInput* audioInput = _Resolve(pDevice, WAIC_OP_CONTINUE_ON_BATTERY);
+	if (audioInput == NULL) return false;
+
+	EndpointResult hr = audioInput->GetContinueOnBattery(pContinueOnBattery);
+	if (!EndpointSucceeded(hr))
+	{
+		_errors.Record(GetFailureCode(hr, WAIC_ERROR_READ_FAILED), WAIC_OP_CONTINUE_ON_BATTERY, hr, audioInput->GetName());
+		return false;
+	}
+	return true;
+}
+
+bool WindowsAudioInputsController::_SetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool pContinueOnBattery)
+{
+	_ApplyNotifications();
+	WindowsAudioInput* audioInput = _Resolve(pDevice, WAIC_OP_CONTINUE_ON_BATTERY);
+	if (audioInput == NULL) return false;
+
+	EndpointResult hr = audioInput->SetContinueOnBattery(pContinueOnBattery);
+	if (!EndpointSucceeded(hr))
+	{
+		_errors.Record(GetFailureCode(hr, WAIC_ERROR_WRITE_FAILED), WAIC_OP_CONTINUE_ON_BATTERY, hr, audioInput->GetName(), pContinueOnBattery ? 1 : 0);
+		return false;
+	}
+	return true;
+}
+
+bool WindowsAudioInputsController::_WatchDeviceLevels(WAIC_DeviceHandle pDevice, bool pWatch)
+{
+	_ApplyNotifications();
+	if (!pWatch)
+	{
+		_levelMeter.Unwatch(pDevice);
+		return true;
+	}
+
+	WindowsAudioInput* audioInput = _Resolve(pDevice, WAIC_OP_LEVEL_METERING);
+	if (audioInput == NULL) return false;
+
+	std::unique_ptr<IEndpointMeter> meter;
+	EndpointResult hr = audioInput->OpenMeter(meter);
+	if (!EndpointSucceeded(hr))
+	{
+		_errors.Record(WAIC_ERROR_READ_FAILED, WAIC_OP_LEVEL_METERING, hr, audioInput->GetName());
+		return false;
+	}
+	if (!_levelMeter.Watch(pDevice, meter))
+	{
+		_errors.Record(WAIC_ERROR_TOO_MANY_DEVICES, WAIC_OP_LEVEL_METERING, 0, audioInput->GetName());
+		return false;
+	}
+	return true;
+}
+
+bool WindowsAudioInputsController::_StartMonitor(WAIC_DeviceHandle pDevice, WAIC_OutputHandle pOutput, int pBufferMs)
+{
+	_ApplyNotifications();
+	WindowsAudioInput* audioInput = _Resolve(pDevice, WAIC_OP_MONITOR);
+	if (audioInput == NULL) return false;
+
+	std::string outputDeviceID;
+	if (pOutput != WAIC_INVALID_DEVICE)
+	{
+		const std::string* output = _outputDevices.Get(pOutput);
+		if (output == NULL)
+		{
+			_errors.Record(WAIC_ERROR_INVALID_HANDLE, WAIC_OP_MONITOR, 0, NULL);
+			return false;
+		}
+		outputDeviceID = *output;
+	}
+	else
+	{
+		EndpointResult hr = _provider->GetDefaultEndpointId(EndpointFlow::Render, outputDeviceID);
+		if (!EndpointSucceeded(hr))
+		{
+			_errors.Record(WAIC_ERROR_OUTPUT_NOT_FOUND, WAIC_OP_MONITOR, hr, "(default)");
+			return false;
+		}
+	}
+
+	// Restarting: the previous streams are released before opening the new ones.
+	_monitors.erase(pDevice);
+
+	uint32_t bufferUs = (uint32_t)std::max(1, std::min(pBufferMs, 1000)) * 1000;
+	std::unique_ptr<IEndpointStream> capture;
+	EndpointResult hr = audioInput->OpenStream(bufferUs, capture);
+	if (!EndpointSucceeded(hr))
+	{
+		_errors.Record(WAIC_ERROR_READ_FAILED, WAIC_OP_MONITOR, hr, audioInput->GetName());
+		return false;
+	}
+
+	std::unique_ptr<IAudioEndpoint> output;
+	std::unique_ptr<IEndpointStream> render;
+	hr = _provider->OpenEndpoint(outputDeviceID, output);
+	if (EndpointSucceeded(hr))
+	{
+		// At the capture rate: the audio engine converts it to the output mix rate.
+		hr = output->OpenStream(bufferUs, capture->GetFormat().sampleRate, render);
+	}
+	std::unique_ptr<AudioMonitor> monitor(new AudioMonitor());
+	if (EndpointSucceeded(hr))
+	{
+		hr = monitor->Start(_provider, capture, render);
+	}
+	if (!EndpointSucceeded(hr))
+	{
+		_errors.Record(WAIC_ERROR_WRITE_FAILED, WAIC_OP_MONITOR, hr, audioInput->GetName());
+		return false;
+	}
+	_monitors.emplace(pDevice, std::move(monitor));
+	return true;
+}
+
+AudioMonitor* WindowsAudioInputsController::_GetMonitor(WAIC_DeviceHandle pDevice, bool pRecordNotMonitored)
+{
+	_ApplyNotifications();
+	WindowsAudioInput* audioInput = _Resolve(pDevice, WAIC_OP_MONITOR);
+	if (audioInput == NULL) return NULL;
+
+	auto it = _monitors.find(pDevice);
+	if (it == _monitors.end())
+	{
+		if (pRecordNotMonitored)
+		{
+			_errors.Record(WAIC_ERROR_READ_FAILED, WAIC_OP_MONITOR, 0, audioInput->GetName());
+		}
+		return NULL;
+	}
+	return it->second.get();
+}
+
+bool WindowsAudioInputsController::_SetListenToAudioInputDeviceTarget(const char* pDeviceName, bool pListen, const char* pOutputDeviceName)
+{
+	_ApplyNotifications();
+	const std::string* outputDeviceID = &DEFAULT_OUTPUT_DEVICE_ID;
+	if (pOutputDeviceName != NULL && pOutputDeviceName[0] != '\0')
+	{
+		outputDeviceID = _outputDevices.Get(_OpenOutput(pOutputDeviceName, WAIC_OP_SET_LISTEN_TARGET));
+		if (outputDeviceID == NULL) return false;
+	}
+	WAIC_DeviceHandle device = _Open(pDeviceName, WAIC_OP_SET_LISTEN_TARGET);
+	return _SetListen(device, _devices.Get(device), pListen, *outputDeviceID);
+}
+
+bool WindowsAudioInputsController::_SetListenToDeviceTarget(WAIC_DeviceHandle pDevice, bool pListen, WAIC_OutputHandle pOutput)
+{
+	_ApplyNotifications();
+	const std::string* outputDeviceID = &DEFAULT_OUTPUT_DEVICE_ID;
+	if (pOutput != WAIC_INVALID_DEVICE)
+	{
+		outputDeviceID = _outputDevices.Get(pOutput);
+		if (outputDeviceID == NULL)
+		{
+			_errors.Record(WAIC_ERROR_INVALID_HANDLE, WAIC_OP_SET_LISTEN_TARGET, 0, NULL);
+			return false;
+		}
+	}
+	return _SetListen(pDevice, _Resolve(pDevice, WAIC_OP_SET_LISTEN_TARGET), pListen, *outputDeviceID);
+}
+
+bool WindowsAudioInputsController::_ReadListenState(WindowsAudioInput* pAudioInput, bool& pIsListening)
+{
+	pIsListening = false;
+	if (pAudioInput != NULL)
+	{
+		EndpointResult hr = pAudioInput->IsListening(pIsListening);
+		if (EndpointSucceeded(hr))
+		{
+			return true;
+		}
+		_errors.Record(GetFailureCode(hr, WAIC_ERROR_READ_FAILED), WAIC_OP_IS_LISTENING, hr, pAudioInput->GetName());
+	}
+	return false;
+}
+
+bool WindowsAudioInputsController::_WriteListenState(WindowsAudioInput* pAudioInput, bool pListen, const std::string& pOutputDeviceID)
+{
+	if (pAudioInput != NULL)
+	{
+		EndpointResult hr = pAudioInput->SetListen(pListen, pOutputDeviceID);
+		if (EndpointSucceeded(hr))
+		{
+			_savedWrites += (hr == ENDPOINT_S_FALSE) ? 1 : 0;
+			return true;
+		}
+		_errors.Record(GetFailureCode(hr, WAIC_ERROR_WRITE_FAILED), WAIC_OP_SET_LISTEN, hr, pAudioInput->GetName(), pListen ? 1 : 0);
+	}
+	return false;
+}
+
+bool WindowsAudioInputsController::_SetListen(WAIC_DeviceHandle pDevice, WindowsAudioInput* pAudioInput, bool pListen, const std::string& pOutputDeviceID)
+{
+	if (pAudioInput == NULL) return false;
+
+	int windowMs = _writeCoalescingWindowMs.load(std::memory_order_relaxed);
+	if (windowMs == 0)
+	{
+		return _WriteListenState(pAudioInput, pListen, pOutputDeviceID);
+	}
+
+	if (pAudioInput->SetPendingListen(pListen, pOutputDeviceID))
+	{
+		// The previous request of this device will never be written.
+		++_savedWrites;
+		return true;
+	}
+
+	// The first write opens the window, the state at its end is committed.
+	_pendingWrites.push_back(pDevice);
+	if (_pendingWrites.size() == 1)
+	{
+		_backendThread.SetTimer(std::chrono::steady_clock::now() + std::chrono::milliseconds(windowMs));
+	}
+	return true;
+}
+
+void WindowsAudioInputsController::_CommitPendingWrites()
+{
+	std::vector<WAIC_DeviceHandle> pendingWrites;
+	pendingWrites.swap(_pendingWrites);
+	for (WAIC_DeviceHandle device : pendingWrites)
+	{
+		WindowsAudioInput* audioInput = _devices.Get(device);
+		if (audioInput == NULL)
+		{
+			// Unplugged or changed within the window.
+			_errors.Record(WAIC_ERROR_INVALID_HANDLE, WAIC_OP_SET_LISTEN, 0, NULL);
+			continue;
+		}
+		// Already written by a direct or batched write meanwhile.
+		if (!audioInput->HasPendingListen()) continue;
+
+		EndpointResult hr = audioInput->CommitPendingListen();
+		if (hr == ENDPOINT_S_FALSE)
+		{
+			++_savedWrites;
+		}
+		else if (!EndpointSucceeded(hr))
+		{
+			_errors.Record(GetFailureCode(hr, WAIC_ERROR_WRITE_FAILED), WAIC_OP_SET_LISTEN, hr, audioInput->GetName());
+		}
+	}
+}
+
+int WindowsAudioInputsController::_SetListenToAudioInputDevices(const char* const* pDeviceNames, const bool* pListen, int pCount, bool* pResults)
+{
+	_ApplyNotifications();
+	if (pCount <= 0) return 0;
+
+	// Resolve all the devices first, on this thread.
+	std::vector<WindowsAudioInput*> audioInputs(pCount, NULL);
+	for (int i = 0; i < pCount; ++i)
+	{
+		audioInputs[i] = _GetOrCreate(pDeviceNames[i], WAIC_OP_SET_LISTEN_BATCH);
+	}
+	return _SetListenBatch(audioInputs, pListen, NULL, pResults, WAIC_OP_SET_LISTEN_BATCH);
+}
+
+int WindowsAudioInputsController::_GetListenStates(const char* const* pDeviceNames, int pCount, bool* pIsListening, bool* pResults)
+{
+	_ApplyNotifications();
+	if (pCount <= 0) return 0;
+
+	std::vector<WindowsAudioInput*> audioInputs(pCount, NULL);
+	for (int i = 0; i < pCount; ++i)
+	{
+		audioInputs[i] = _GetOrCreate(pDeviceNames[i], WAIC_OP_GET_LISTEN_STATES);
+	}
+	return _GetListenStatesBatch(audioInputs, pIsListening, pResults, WAIC_OP_GET_LISTEN_STATES);
+}
+
+int WindowsAudioInputsController::_SetListenToDevices(const WAIC_DeviceHandle* pDevices, const bool* pListen, int pCount, bool* pResults)
+{
+	_ApplyNotifications();
+	if (pCount <= 0) return 0;
+
+	std::vector<WindowsAudioInput*> audioInputs(pCount, NULL);
+	for (int i = 0; i < pCount; ++i)
+	{
+		audioInputs[i] = _Resolve(pDevices[i], WAIC_OP_SET_LISTEN_BATCH);
+	}
+	return _SetListenBatch(audioInputs, pListen, NULL, pResults, WAIC_OP_SET_LISTEN_BATCH);
+}
+
+int WindowsAudioInputsController::_GetDeviceListenStates(const WAIC_DeviceHandle* pDevices, int pCount, bool* pIsListening, bool* pResults)
+{
+	_ApplyNotifications();
+	if (pCount <= 0) return 0;
+
+	std::vector<WindowsAudioInput*> audioInputs(pCount, NULL);
+	for (int i = 0; i < pCount; ++i)
+	{
+		audioInputs[i] = _Resolve(pDevices[i], WAIC_OP_GET_LISTEN_STATES);
+	}
+	return _GetListenStatesBatch(audioInputs, pIsListening, pResults, WAIC_OP_GET_LISTEN_STATES);
+}
+
+int WindowsAudioInputsController::_SetListenBatch(const std::vector<WindowsAudioInput*>& pAudioInputs, const bool* pListen, const std::string* pOutputDeviceIDs,
+	bool* pResults, WAIC_Operation pOperation)
+{
+	// Only the last request of a device is applied.
+	int count = (int)pAudioInputs.size();
+	std::unordered_map<WindowsAudioInput*, int> lastRequests;
+	for (int i = 0; i < count; ++i)
+	{
+		if (pAudioInputs[i] != NULL)
+		{
+			lastRequests[pAudioInputs[i]] = i;
+		}
+	}
+
+	std::vector<int> requests;
+	requests.reserve(lastRequests.size());
+	for (const auto& it : lastRequests)
+	{
+		requests.push_back(it.second);
+	}
+
+	int resolvedCount = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		resolvedCount += (pAudioInputs[i] != NULL) ? 1 : 0;
+	}
+	_savedWrites += resolvedCount - (int)requests.size();
+
+	std::vector<EndpointResult> results(count, ENDPOINT_E_NOTFOUND);
+	_GetWorkerPool((int)requests.size())->ParallelFor((int)requests.size(), [&](int pRequest)
+	{
+		int index = requests[pRequest];
+		results[index] = pAudioInputs[index]->SetListen(pListen[index], (pOutputDeviceIDs != NULL) ? pOutputDeviceIDs[index] : DEFAULT_OUTPUT_DEVICE_ID);
+	});
+
+	int successCount = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		bool success = false;
+		if (pAudioInputs[i] != NULL)
+		{
+			int lastRequest = lastRequests[pAudioInputs[i]];
+			results[i] = results[lastRequest];
+			success = EndpointSucceeded(results[i]);
+			if (lastRequest == i && results[i] == ENDPOINT_S_FALSE)
+			{
+				++_savedWrites;
+			}
+			if (!success && lastRequest == i)
+			{
+				_errors.Record(GetFailureCode(results[i], WAIC_ERROR_WRITE_FAILED), pOperation, results[i], pAudioInputs[i]->GetName(), pListen[i] ? 1 : 0);
+			}
+		}
+		successCount += success ? 1 : 0;
+		if (pResults != NULL)
+		{
+			pResults[i] = success;
+		}
+	}
+	return successCount;
+}
+
+int WindowsAudioInputsController::_GetListenStatesBatch(const std::vector<WindowsAudioInput*>& pAudioInputs, bool* pIsListening, bool* pResults, WAIC_Operation pOperation)
+{
+	// Cached states are read directly, the unknown ones are read in parallel.
+	int count = (int)pAudioInputs.size();
+	std::vector<WindowsAudioInput*> unknownStates;
+	for (int i = 0; i < count; ++i)
+	{
+		if (pAudioInputs[i] != NULL && !pAudioInputs[i]->IsListenStateKnown()
+			&& std::find(unknownStates.begin(), unknownStates.end(), pAudioInputs[i]) == unknownStates.end())
+		{
+			unknownStates.push_back(pAudioInputs[i]);
+		}
+	}
+
+	_GetWorkerPool((int)unknownStates.size())->ParallelFor((int)unknownStates.size(), [&](int pIndex)
+	{
+		unknownStates[pIndex]->RefreshListenState();
+	});
+
+	int successCount = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		bool isListening = false;
+		bool success = false;
+		if (pAudioInputs[i] != NULL)
+		{
+			EndpointResult hr = pAudioInputs[i]->IsListening(isListening);
+			success = EndpointSucceeded(hr);
+			if (!success)
+			{
+				_errors.Record(GetFailureCode(hr, WAIC_ERROR_READ_FAILED), pOperation, hr, pAudioInputs[i]->GetName());
+			}
+		}
+		successCount += success ? 1 : 0;
+		pIsListening[i] = isListening;
+		if (pResults != NULL)
+		{
+			pResults[i] = success;
+		}
+	}
+	return successCount;
+}
+
+bool WindowsAudioInputsController::_RefreshAudioInputs()
+{
+	_ApplyNotifications();
+	if (_providerReady)
+	{
+		// Opened devices are kept: they are still valid as long as the endpoint exists. Their property stores are reopened on their next use.
+		// The output devices are re-enumerated on their next lookup.
+		for (auto& it : _audioInputs)
+		{
+			_devices.Get(it.second)->ClosePropertySession();
+		}
+		_outputsDirectory->Invalidate();
+		if (_audioInputsDirectory->Refresh())
+		{
+			return true;
+		}
+		_errors.Record(WAIC_ERROR_ENUMERATION_FAILED, WAIC_OP_REFRESH, ENDPOINT_E_FAIL, NULL);
+	}
+	return false;
+}
+
+int WindowsAudioInputsController::_Snapshot(WAIC_DeviceSnapshot* pRecords, int pCapacity, int* pRequiredCount)
+{
+	_ApplyNotifications();
+	if (pRequiredCount != NULL)
+	{
+		*pRequiredCount = 0;
+	}
+	if (!_providerReady) return 0;
+
+	if (!_audioInputsDirectory->IsValid() && !_audioInputsDirectory->Refresh())
+	{
+		_errors.Record(WAIC_ERROR_ENUMERATION_FAILED, WAIC_OP_SNAPSHOT, ENDPOINT_E_FAIL, NULL);
+		return 0;
+	}
+
+	const std::vector<EndpointInfo>& endpoints = _audioInputsDirectory->GetEndpoints();
+	int count = ((int)endpoints.size() < pCapacity) ? (int)endpoints.size() : pCapacity;
+	if (pRequiredCount != NULL)
+	{
+		*pRequiredCount = (int)endpoints.size();
+	}
+
+	_OpenCaptureEndpoints(count, WAIC_OP_SNAPSHOT);
+
+	for (int i = 0; i < count; ++i)
+	{
+		const EndpointInfo& endpoint = endpoints[i];
+		WAIC_DeviceSnapshot& record = pRecords[i];
+		strncpy(record.name, endpoint.friendlyName.c_str(), WAIC_DEVICE_NAME_SIZE - 1);
+		record.name[WAIC_DEVICE_NAME_SIZE - 1] = '\0';
+		strncpy(record.endpointId, endpoint.id.c_str(), WAIC_ENDPOINT_ID_SIZE - 1);
+		record.endpointId[WAIC_ENDPOINT_ID_SIZE - 1] = '\0';
+		record.listenTarget[0] = '\0';
+		record.state = endpoint.state;
+		record.listen = -1;
+
+		bool isListening = false;
+		if (_snapshotAudioInputs[i] != NULL && _snapshotAudioInputs[i]->TryGetCachedListenState(isListening))
+		{
+			record.listen = isListening ? 1 : 0;
+			_snapshotAudioInputs[i]->CopyListenTarget(record.listenTarget, WAIC_ENDPOINT_ID_SIZE);
+		}
+	}
+	return count;
+}
+
+int WindowsAudioInputsController::_SaveListenProfile(void* pBuffer, int pSize)
+{
+	_ApplyNotifications();
+	if (!_providerReady) return 0;
+
+	if (!_audioInputsDirectory->IsValid() && !_audioInputsDirectory->Refresh())
+	{
+		_errors.Record(WAIC_ERROR_ENUMERATION_FAILED, WAIC_OP_SAVE_PROFILE, ENDPOINT_E_FAIL, NULL);
+		return 0;
+	}
+
+	const std::vector<EndpointInfo>& endpoints = _audioInputsDirectory->GetEndpoints();
+	_OpenCaptureEndpoints((int)endpoints.size(), WAIC_OP_SAVE_PROFILE);
+
+	// Devices whose state could not be read are not saved.
+	std::vector<ListenProfileEntry> entries;
+	entries.reserve(endpoints.size());
+	for (size_t i = 0; i < endpoints.size(); ++i)
+	{
+		ListenProfileEntry entry;
+		WindowsAudioInput* audioInput = _snapshotAudioInputs[i];
+		if (audioInput != NULL && audioInput->TryGetCachedListenState(entry.listen)
+			&& EndpointSucceeded(audioInput->GetListenTarget(entry.listenTarget)))
+		{
+			entry.endpointId = endpoints[i].id;
+			entries.push_back(entry);
+		}
+	}
+	return (int)ListenProfile::Write(entries, (uint8_t*)pBuffer, (pSize > 0) ? (size_t)pSize : 0);
+}
+
+int WindowsAudioInputsController::_RestoreListenProfile(const void* pBuffer, int pSize)
+{
+	_ApplyNotifications();
+	std::vector<ListenProfileEntry> entries;
+	if (pSize <= 0 || !ListenProfile::Read((const uint8_t*)pBuffer, (size_t)pSize, entries))
+	{
+		_errors.Record(WAIC_ERROR_INVALID_PROFILE, WAIC_OP_RESTORE_PROFILE, ENDPOINT_E_INVALIDARG, NULL);
+		return -1;
+	}
+	if (!_providerReady)
+	{
+		_errors.Record(WAIC_ERROR_NOT_INITIALIZED, WAIC_OP_RESTORE_PROFILE, 0, NULL);
+		return -1;
+	}
+
+	// Endpoints are looked up by id. Those not present on this machine are skipped.
+	std::vector<WindowsAudioInput*> audioInputs(entries.size(), NULL);
+	std::vector<WindowsAudioInput*> unknownStates;
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const EndpointInfo* endpoint = _audioInputsDirectory->FindById(entries[i].endpointId);
+		if (endpoint == NULL)
+		{
+			_errors.Record(WAIC_ERROR_DEVICE_NOT_FOUND, WAIC_OP_RESTORE_PROFILE, 0, entries[i].endpointId.c_str());
+			continue;
+		}
+		WindowsAudioInput* audioInput = _devices.Get(_OpenByEndpoint(*endpoint, WAIC_OP_RESTORE_PROFILE));
+		if (audioInput != NULL)
+		{
+			audioInputs[i] = audioInput;
+			if (!audioInput->IsListenStateKnown())
+			{
+				unknownStates.push_back(audioInput);
+			}
+		}
+	}
+
+	_GetWorkerPool((int)unknownStates.size())->ParallelFor((int)unknownStates.size(), [&](int pIndex)
+	{
+		unknownStates[pIndex]->RefreshListenState();
+	});
+
+	// Only the differences are written, in one batch.
+	std::vector<WindowsAudioInput*> writes;
+	std::vector<std::string> targets;
+	std::unique_ptr<bool[]> listen(new bool[entries.size() + 1]);
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		if (audioInputs[i] != NULL && !audioInputs[i]->MatchesListenState(entries[i].listen, entries[i].listenTarget))
+		{
+			listen[writes.size()] = entries[i].listen;
+			writes.push_back(audioInputs[i]);
+			targets.push_back(entries[i].listenTarget);
+		}
+	}
+	if (writes.empty()) return 0;
+
+	return _SetListenBatch(writes, listen.get(), targets.data(), NULL, WAIC_OP_RESTORE_PROFILE);
+}
+
+void WindowsAudioInputsController::_OpenCaptureEndpoints(int pCount, WAIC_Operation pOperation)
+{
+	const std::vector<EndpointInfo>& endpoints = _audioInputsDirectory->GetEndpoints();
+
+	// Only the unknown listen states are read, in parallel.
+	_snapshotAudioInputs.assign(pCount, NULL);
+	_snapshotUnknownStates.clear();
+	for (int i = 0; i < pCount; ++i)
+	{
+		WindowsAudioInput* audioInput = _devices.Get(_OpenByEndpoint(endpoints[i], pOperation));
+		if (audioInput != NULL)
+		{
+			_snapshotAudioInputs[i] = audioInput;
+			if (!audioInput->IsListenStateKnown())
+			{
+				_snapshotUnknownStates.push_back(audioInput);
+			}
+		}
+	}
+
+	if (!_snapshotUnknownStates.empty())
+	{
+		std::vector<WindowsAudioInput*>& unknownStates = _snapshotUnknownStates;
+		_GetWorkerPool((int)unknownStates.size())->ParallelFor((int)unknownStates.size(), [&unknownStates](int pIndex)
+		{
+			unknownStates[pIndex]->RefreshListenState();
+		});
+	}
+}
+
+void WindowsAudioInputsController::OnEndpointAdded(const std::string& pEndpointId)
+{
+	_QueueNotification(EndpointNotification::Added, pEndpointId);
+}
+
+void WindowsAudioInputsController::OnEndpointRemoved(const std::string& pEndpointId)
+{
+	_QueueNotification(EndpointNotification::Removed, pEndpointId);
+}
+
+void WindowsAudioInputsController::OnEndpointStateChanged(const std::string& pEndpointId, uint32_t)
+{
+	_QueueNotification(EndpointNotification::StateChanged, pEndpointId);
+}
+
+void WindowsAudioInputsController::OnEndpointPropertyChanged(const std::string& pEndpointId, const EndpointPropertyKey& pKey)
+{
+	if (pKey.fmtid == LISTEN_SETTING_GUID)
+	{
+		_QueueNotification(EndpointNotification::ListenPropertyChanged, pEndpointId);
+	}
+	else if (pKey == ENDPOINT_PKEY_FRIENDLY_NAME)
+	{
+		// Renamed: updated as a state change, so that the name index and the devices opened by the old name follow.
+		_QueueNotification(EndpointNotification::StateChanged, pEndpointId);
+	}
+}
+
+void WindowsAudioInputsController::_QueueNotification(EndpointNotification::Type pType, const std::string& pEndpointId)
+{
+	std::lock_guard<std::mutex> lock(_notificationsMutex);
+	EndpointNotification notification;
+	notification.type = pType;
+	notification.endpointId = pEndpointId;
+	_notifications.push_back(notification);
+	_hasNotifications = true;
+
+	if (!_notificationsScheduled.exchange(true))
+	{
+		_backendThread.Submit(&_notificationsRequest);
+	}
+}
+
+void WindowsAudioInputsController::NotificationsRequest::Execute()
+{
+	controller->_notificationsScheduled = false;
+	controller->_ApplyNotifications();
+}
+
+void WindowsAudioInputsController::_ApplyNotifications()
+{
+	if (!_hasNotifications) return;
+
+	std::vector<EndpointNotification> notifications;
+	{
+		std::lock_guard<std::mutex> lock(_notificationsMutex);
+		notifications.swap(_notifications);
+	}
+
+	std::string lastRefreshedId;
+	for (const EndpointNotification& notification : notifications)
+	{
+		if (notification.type == EndpointNotification::ListenPropertyChanged)
+		{
+			// A single write usually changes both listen properties: refresh once.
+			if (notification.endpointId != lastRefreshedId && _RefreshListenStates(notification.endpointId))
+			{
+				lastRefreshedId = notification.endpointId;
+			}
+			continue;
+		}
+		lastRefreshedId.clear();
+
+		// The opened device may be stale (unplugged/replugged): it will be re-opened on its next use.
+		_ReleaseAudioInputs(notification.endpointId);
+		_ReleaseOutputDevices(notification.endpointId);
+
+		// Known active audio input, before the update (the directory is not enumerated just for the events).
+		EndpointInfo previousInfo;
+		const EndpointInfo* previous = _audioInputsDirectory->IsValid() ? _audioInputsDirectory->FindById(notification.endpointId) : NULL;
+		if (previous != NULL)
+		{
+			previousInfo = *previous;
+		}
+
+		// Each directory ignores the endpoints of the other flow.
+		EndpointInfo info;
+		bool isAudioInput = false;
+		if (notification.type != EndpointNotification::Removed
+			&& EndpointSucceeded(_provider->GetEndpointInfo(notification.endpointId, info)))
+		{
+			_audioInputsDirectory->AddEndpoint(info);
+			_outputsDirectory->AddEndpoint(info);
+			isAudioInput = (info.flow == EndpointFlow::Capture && (info.state & ENDPOINT_STATE_ACTIVE) != 0);
+		}
+		else
+		{
+			_audioInputsDirectory->RemoveEndpoint(notification.endpointId);
+			_outputsDirectory->RemoveEndpoint(notification.endpointId);
+		}
+
+		if (previous == NULL && isAudioInput)
+		{
+			_RaiseEvent(WAIC_EVENT_DEVICE_ADDED, &info, NULL, WAIC_INVALID_DEVICE);
+		}
+		else if (previous != NULL && !isAudioInput)
+		{
+			_RaiseEvent(WAIC_EVENT_DEVICE_REMOVED, &previousInfo, NULL, WAIC_INVALID_DEVICE);
+		}
+	}
+
+	// The cached states can be served again once every received notification has been applied.
+	std::lock_guard<std::mutex> lock(_notificationsMutex);
+	_hasNotifications = !_notifications.empty();
+}
+
+void WindowsAudioInputsController::_ReleaseAudioInputs(const std::string& pEndpointId)
+{
+	auto range = _audioInputsByEndpointId.equal_range(pEndpointId);
+	if (range.first == range.second) return;
+
+	std::vector<WAIC_DeviceHandle> released;
+	{
+		std::unique_lock<std::shared_mutex> lock(_audioInputsMutex);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			WAIC_DeviceHandle device = it->second->second;
+			WindowsAudioInput* audioInput = _devices.Get(device);
+			// Bumps the generation first: the handles of the device become stale before it is closed.
+			_devices.Release(device);
+			audioInput->Close();
+			_audioInputs.erase(it->second);
+			released.push_back(device);
+		}
+		_audioInputsByEndpointId.erase(range.first, range.second);
+	}
+
+	// Out of the lock: stopping a monitor joins its thread, the readers of the opened devices do not wait for it.
+	// The monitors and meters own their streams, they do not use the closed devices.
+	for (WAIC_DeviceHandle device : released)
+	{
+		_levelMeter.Unwatch(device);
+		_monitors.erase(device);
+	}
+}
+
+bool WindowsAudioInputsController::_RefreshListenStates(const std::string& pEndpointId)
+{
+	bool refreshed = false;
+	auto range = _audioInputsByEndpointId.equal_range(pEndpointId);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		WAIC_DeviceHandle device = it->second->second;
+		WindowsAudioInput* audioInput = _devices.Get(device);
+		if (!audioInput->ConsumeOwnWriteNotification())
+		{
+			refreshed = true;
+			// Writes made through the controller are already cached: only the changes made outside raise events.
+			bool listen = false, previousListen = false;
+			std::string target, previousTarget;
+			bool wasKnown = audioInput->GetCachedListenState(previousListen, previousTarget);
+			audioInput->RefreshListenState();
+			if (wasKnown && audioInput->GetCachedListenState(listen, target))
+			{
+				if (listen != previousListen)
+				{
+					_RaiseEvent(WAIC_EVENT_LISTEN_CHANGED, NULL, audioInput, device);
+				}
+				if (target != previousTarget)
+				{
+					_RaiseEvent(WAIC_EVENT_TARGET_CHANGED, NULL, audioInput, device);
+				}
+			}
+		}
+	}
+	return refreshed;
+}
+
+void WindowsAudioInputsController::_RaiseEvent(WAIC_EventType pType, const EndpointInfo* pEndpoint, const WindowsAudioInput* pAudioInput, WAIC_DeviceHandle pDevice)
+{
+	WAIC_Event event;
+	event.sequence = 0;
+	event.type = pType;
+	event.listen = -1;
+	event.device = pDevice;
+	event.listenTarget[0] = '\0';
+	const char* name = (pEndpoint != NULL) ? pEndpoint->friendlyName.c_str() : pAudioInput->GetName();
+	const char* endpointId = (pEndpoint != NULL) ? pEndpoint->id.c_str() : pAudioInput->GetEndpointId().c_str();
+	strncpy(event.name, name, WAIC_DEVICE_NAME_SIZE - 1);
+	event.name[WAIC_DEVICE_NAME_SIZE - 1] = '\0';
+	strncpy(event.endpointId, endpointId, WAIC_ENDPOINT_ID_SIZE - 1);
+	event.endpointId[WAIC_ENDPOINT_ID_SIZE - 1] = '\0';
+
+	bool listen = false;
+	if (pAudioInput != NULL && pAudioInput->TryGetCachedListenState(listen))
+	{
+		event.listen = listen ? 1 : 0;
+		pAudioInput->CopyListenTarget(event.listenTarget, WAIC_ENDPOINT_ID_SIZE);
+	}
+
+	if (_eventCallback != NULL)
+	{
+		event.sequence = _events.NextSequence();
+		_eventCallback(&event, _eventCallbackUserData);
+	}
+	else
+	{
+		_events.Push(event);
+	}
+}
+
+void WindowsAudioInputsController::SetEventCallback(WAIC_EventCallback pCallback, void* pUserData)
+{
+	// Swapped on the backend thread, between two events.
+	_backendThread.Call([&]
+	{
+		_eventCallback = pCallback;
+		_eventCallbackUserData = pUserData;
+	});
+}
+
+WorkerPool* WindowsAudioInputsController::_GetWorkerPool(int pBatchSize)
+{
+	if (_workerPool == NULL)
+	{
+		IAudioEndpointProvider* provider = _provider;
+		_workerPool = new WorkerPool(0,
+			[provider] { provider->InitializeThread(); },
+			[provider] { provider->UninitializeThread(); });
+	}
+	// Sized to the largest batch so far: each device gets its own thread, so a batch takes about as long as one device.
+	_workerPool->Reserve(std::min(pBatchSize - 1, MAX_BATCH_WORKER_THREADS));
+	return _workerPool;
+}
+
+WAIC_DeviceHandle WindowsAudioInputsController::_Open(const char* pDeviceName, WAIC_Operation pOperation)
+{
+	if (!_providerReady)
+	{
+		_errors.Record(WAIC_ERROR_NOT_INITIALIZED, pOperation, 0, pDeviceName);
+		return WAIC_INVALID_DEVICE;
+	}
+
+	StatsTimer timer(&_stats, WAIC_STAGE_LOOKUP);
+
+	// Device already opened ?
+	auto it = _audioInputs.find(pDeviceName);
+	if (it != _audioInputs.end())
+	{
+		_stats.AddCacheHit(WAIC_CACHE_DEVICE);
+		return it->second;
+	}
+	_stats.AddCacheMiss(WAIC_CACHE_DEVICE);
+
+	// Try to open it, if not existing
+	std::string endpointId;
+	if (!_audioInputsDirectory->FindIdByName(pDeviceName, endpointId))
+	{
+		_errors.Record(WAIC_ERROR_DEVICE_NOT_FOUND, pOperation, 0, pDeviceName);
+		return WAIC_INVALID_DEVICE;
+	}
+	return _OpenEndpoint(pDeviceName, endpointId, pDeviceName, pOperation);
+}
+
+WAIC_DeviceHandle WindowsAudioInputsController::_OpenMatching(const char* pPattern, WAIC_MatchMode pMode, WAIC_Operation pOperation)
+{
+	if (!_providerReady)
+	{
+		_errors.Record(WAIC_ERROR_NOT_INITIALIZED, pOperation, 0, pPattern);
+		return WAIC_INVALID_DEVICE;
+	}
+
+	const EndpointInfo* endpoint = _audioInputsDirectory->Match(pPattern, pMode);
+	if (endpoint == NULL)
+	{
+		_errors.Record(WAIC_ERROR_DEVICE_NOT_FOUND, pOperation, 0, pPattern);
+		return WAIC_INVALID_DEVICE;
+	}
+	return _OpenByEndpoint(*endpoint, pOperation);
+}
+
+WAIC_DeviceHandle WindowsAudioInputsController::_OpenByEndpoint(const EndpointInfo& pEndpoint, WAIC_Operation pOperation)
+{
+	// Opened under its name, as OpenDevice does, unless another endpoint has the same name: it is then opened under its endpoint id.
+	const EndpointInfo* namedEndpoint = _audioInputsDirectory->FindByName(pEndpoint.friendlyName);
+	bool byName = (namedEndpoint != NULL && namedEndpoint->id == pEndpoint.id);
+
+	// Already opened: no allocation (Snapshot).
+	auto it = _audioInputs.find(byName ? pEndpoint.friendlyName : pEndpoint.id);
+	if (it != _audioInputs.end())
+	{
+		if (byName)
+		{
+			_stats.AddCacheHit(WAIC_CACHE_DEVICE);
+		}
+		return it->second;
+	}
+
+	if (byName)
+	{
+		return _Open(pEndpoint.friendlyName.c_str(), pOperation);
+	}
+	return _OpenEndpoint(pEndpoint.id, pEndpoint.id, pEndpoint.friendlyName.c_str(), pOperation);
+}
+
+WAIC_DeviceHandle WindowsAudioInputsController::_OpenEndpoint(const std::string& pKey, const std::string& pEndpointId, const char* pName, WAIC_Operation pOperation)
+{
+	WAIC_DeviceHandle device = _devices.Acquire();
+	if (device == WAIC_INVALID_DEVICE)
+	{
+		_errors.Record(WAIC_ERROR_TOO_MANY_DEVICES, pOperation, 0, pName);
+		return WAIC_INVALID_DEVICE;
+	}
+
+	EndpointResult hr = _devices.Get(device)->Open(_provider, pEndpointId, pName, &_listenStateReads, &_stats, &_callPolicy);
+	if (!EndpointSucceeded(hr))
+	{
+		_devices.Release(device);
+		_errors.Record(WAIC_ERROR_DEVICE_NOT_FOUND, pOperation, hr, pName);
+		return WAIC_INVALID_DEVICE;
+	}
+
+	std::unique_lock<std::shared_mutex> lock(_audioInputsMutex);
+	auto inserted = _audioInputs.emplace(pKey, device);
+	_audioInputsByEndpointId.emplace(pEndpointId, inserted.first);
+	return device;
+}
+
+WAIC_OutputHandle WindowsAudioInputsController::_OpenOutput(const char* pOutputDeviceName, WAIC_Operation pOperation)
+{
+	if (!_providerReady)
+	{
+		_errors.Record(WAIC_ERROR_NOT_INITIALIZED, pOperation, 0, pOutputDeviceName);
+		return WAIC_INVALID_DEVICE;
+	}
+
+	auto it = _outputs.find(pOutputDeviceName);
+	if (it != _outputs.end())
+	{
+		return it->second;
+	}
+
+	// Resolved from the render endpoints index: no enumeration once it is built.
+	std::string endpointId;
+	if (!_outputsDirectory->FindIdByName(pOutputDeviceName, endpointId))
+	{
+		_errors.Record(WAIC_ERROR_OUTPUT_NOT_FOUND, pOperation, 0, pOutputDeviceName);
+		return WAIC_INVALID_DEVICE;
+	}
+
+	WAIC_OutputHandle output = _outputDevices.Acquire();
+	if (output == WAIC_INVALID_DEVICE)
+	{
+		_errors.Record(WAIC_ERROR_TOO_MANY_DEVICES, pOperation, 0, pOutputDeviceName);
+		return WAIC_INVALID_DEVICE;
+	}
+	_outputDevices.Get(output)->swap(endpointId);
+	_outputs.emplace(pOutputDeviceName, output);
+	return output;
+}
+
+void WindowsAudioInputsController::_ReleaseOutputDevices(const std::string& pEndpointId)
+{
+	for (auto it = _outputs.begin(); it != _outputs.end();)
+	{
+		std::string* endpointId = _outputDevices.Get(it->second);
+		if (*endpointId == pEndpointId)
+		{
+			_outputDevices.Release(it->second);
+			endpointId->clear();
+			it = _outputs.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+WindowsAudioInput* WindowsAudioInputsController::_Resolve(WAIC_DeviceHandle pDevice, WAIC_Operation pOperation)
+{
+	WindowsAudioInput* audioInput = _devices.Get(pDevice);
+	if (audioInput == NULL)
+	{
+		_errors.Record(WAIC_ERROR_INVALID_HANDLE, pOperation, 0, NULL);
 	}
 	return audioInput;
 }
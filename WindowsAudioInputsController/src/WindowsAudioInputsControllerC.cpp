@@ -16,18 +16,98 @@
 * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
 ******************************************************************************************************************************************************/
 
+#include "ServiceClient.h"
 #include "WindowsAudioInputsController.h"
-#include "..\include\WindowsAudioInputsControllerC.h"
+#include "WindowsAudioInputsControllerC.h"
 
+// Only written by the Init functions and Terminate, which must not run concurrently with the other calls: the other functions only read them.
 static WindowsAudioInputsController* sWAIC = NULL;
+// Client mode (InitClient): the forwarded calls go to the controller service instead of sWAIC.
+static ServiceClient* sClient = NULL;
+
+static bool IsInitialized()
+{
+    return sWAIC != NULL || sClient != NULL;
+}
 
 void Init()
 {
+    if (IsInitialized()) return;
     sWAIC = new WindowsAudioInputsController();
 }
 
+bool InitClient(const char* pServiceName)
+{
+    if (IsInitialized()) return false;
+    sClient = new ServiceClient((pServiceName != NULL) ? pServiceName : WAIC_DEFAULT_SERVICE_NAME);
+    return sClient->Connect();
+}
+
+void InitWithProvider(IAudioEndpointProvider* pProvider)
+{
+    if (IsInitialized())
+    {
+        delete pProvider;
+        return;
+    }
+    sWAIC = new WindowsAudioInputsController(pProvider);
+}
+
+static WindowsAudioInputsController::InitOptions GetAsyncInitOptions(const char* const* pPrewarmDeviceNames, int pCount, bool pFailFast)
+{
+    WindowsAudioInputsController::InitOptions options;
+    options.async = true;
+    options.failFast = pFailFast;
+    for (int i = 0; i < pCount; ++i)
+    {
+        if (pPrewarmDeviceNames[i] != NULL)
+        {
+            options.prewarmDeviceNames.push_back(pPrewarmDeviceNames[i]);
+        }
+    }
+    return options;
+}
+
+void InitAsync(const char* const* pPrewarmDeviceNames, int pCount, bool pFailFast)
+{
+    if (IsInitialized()) return;
+    sWAIC = new WindowsAudioInputsController(GetAsyncInitOptions(pPrewarmDeviceNames, pCount, pFailFast));
+}
+
+void InitAsyncWithProvider(IAudioEndpointProvider* pProvider, const char* const* pPrewarmDeviceNames, int pCount, bool pFailFast)
+{
+    if (IsInitialized())
+    {
+        delete pProvider;
+        return;
+    }
+    sWAIC = new WindowsAudioInputsController(pProvider, GetAsyncInitOptions(pPrewarmDeviceNames, pCount, pFailFast));
+}
+
+bool IsReady()
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->IsReady();
+    }
+    return false;
+}
+
+bool WaitReady(int pTimeoutMs)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->WaitReady(pTimeoutMs);
+    }
+    return false;
+}
+
 bool IsListening(const char* pDeviceName)
 {
+    if (sClient != NULL)
+    {
+        return sClient->IsListening(pDeviceName);
+    }
     if (sWAIC != NULL)
     {
         return sWAIC->IsListening(pDeviceName);
@@ -37,6 +117,10 @@ bool IsListening(const char* pDeviceName)
 
 bool SetListenToAudioInputDevice(const char* pDeviceName, bool pListen)
 {
+    if (sClient != NULL)
+    {
+        return sClient->SetListenToAudioInputDevice(pDeviceName, pListen);
+    }
     if (sWAIC != NULL)
     {
         return sWAIC->SetListenToAudioInputDevice(pDeviceName, pListen);
@@ -44,8 +128,441 @@ bool SetListenToAudioInputDevice(const char* pDeviceName, bool pListen)
     return false;
 }
 
+int SetListenToAudioInputDevices(const char* const* pDeviceNames, const bool* pListen, int pCount, bool* pResults)
+{
+    if (sClient != NULL)
+    {
+        return sClient->SetListenToAudioInputDevices(pDeviceNames, pListen, pCount, pResults);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SetListenToAudioInputDevices(pDeviceNames, pListen, pCount, pResults);
+    }
+    return 0;
+}
+
+int GetListenStates(const char* const* pDeviceNames, int pCount, bool* pIsListening, bool* pResults)
+{
+    if (sClient != NULL)
+    {
+        return sClient->GetListenStates(pDeviceNames, pCount, pIsListening, pResults);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->GetListenStates(pDeviceNames, pCount, pIsListening, pResults);
+    }
+    return 0;
+}
+
+WAIC_DeviceHandle OpenDevice(const char* pDeviceName)
+{
+    if (sClient != NULL)
+    {
+        return sClient->OpenDevice(pDeviceName);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->OpenDevice(pDeviceName);
+    }
+    return WAIC_INVALID_DEVICE;
+}
+
+WAIC_DeviceHandle OpenDeviceMatching(const char* pPattern, WAIC_MatchMode pMode)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->OpenDeviceMatching(pPattern, pMode);
+    }
+    return WAIC_INVALID_DEVICE;
+}
+
+bool GetMatchingDeviceName(const char* pPattern, WAIC_MatchMode pMode, char* pName, int pSize)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->GetMatchingDeviceName(pPattern, pMode, pName, pSize);
+    }
+    return false;
+}
+
+bool IsDeviceHandleValid(WAIC_DeviceHandle pDevice)
+{
+    if (sClient != NULL)
+    {
+        return sClient->IsDeviceHandleValid(pDevice);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->IsDeviceHandleValid(pDevice);
+    }
+    return false;
+}
+
+bool IsDeviceListening(WAIC_DeviceHandle pDevice)
+{
+    if (sClient != NULL)
+    {
+        return sClient->IsDeviceListening(pDevice);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->IsDeviceListening(pDevice);
+    }
+    return false;
+}
+
+bool SetListenToDevice(WAIC_DeviceHandle pDevice, bool pListen)
+{
+    if (sClient != NULL)
+    {
+        return sClient->SetListenToDevice(pDevice, pListen);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SetListenToDevice(pDevice, pListen);
+    }
+    return false;
+}
+
+int SetListenToDevices(const WAIC_DeviceHandle* pDevices, const bool* pListen, int pCount, bool* pResults)
+{
+    if (sClient != NULL)
+    {
+        return sClient->SetListenToDevices(pDevices, pListen, pCount, pResults);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SetListenToDevices(pDevices, pListen, pCount, pResults);
+    }
+    return 0;
+}
+
+int GetDeviceListenStates(const WAIC_DeviceHandle* pDevices, int pCount, bool* pIsListening, bool* pResults)
+{
+    if (sClient != NULL)
+    {
+        return sClient->GetDeviceListenStates(pDevices, pCount, pIsListening, pResults);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->GetDeviceListenStates(pDevices, pCount, pIsListening, pResults);
+    }
+    return 0;
+}
+
+bool GetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool* pContinueOnBattery)
+{
+    if (sWAIC != NULL && pContinueOnBattery != NULL)
+    {
+        return sWAIC->GetDeviceContinueOnBattery(pDevice, *pContinueOnBattery);
+    }
+    return false;
+}
+
+bool SetDeviceContinueOnBattery(WAIC_DeviceHandle pDevice, bool pContinueOnBattery)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SetDeviceContinueOnBattery(pDevice, pContinueOnBattery);
+    }
+    return false;
+}
+
+WAIC_OutputHandle OpenOutputDevice(const char* pOutputDeviceName)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->OpenOutputDevice(pOutputDeviceName);
+    }
+    return WAIC_INVALID_DEVICE;
+}
+
+bool IsOutputHandleValid(WAIC_OutputHandle pOutput)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->IsOutputHandleValid(pOutput);
+    }
+    return false;
+}
+
+bool SetListenToAudioInputDeviceTarget(const char* pDeviceName, bool pListen, const char* pOutputDeviceName)
+{
+    if (sClient != NULL)
+    {
+        return sClient->SetListenToAudioInputDeviceTarget(pDeviceName, pListen, pOutputDeviceName);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SetListenToAudioInputDeviceTarget(pDeviceName, pListen, pOutputDeviceName);
+    }
+    return false;
+}
+
+bool SetListenToDeviceTarget(WAIC_DeviceHandle pDevice, bool pListen, WAIC_OutputHandle pOutput)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SetListenToDeviceTarget(pDevice, pListen, pOutput);
+    }
+    return false;
+}
+
+uint64_t IsListeningAsync(const char* pDeviceName, WAIC_Callback pCallback, void* pUserData)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->IsListeningAsync(pDeviceName, pCallback, pUserData);
+    }
+    return 0;
+}
+
+uint64_t SetListenToAudioInputDeviceAsync(const char* pDeviceName, bool pListen, WAIC_Callback pCallback, void* pUserData)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SetListenToAudioInputDeviceAsync(pDeviceName, pListen, pCallback, pUserData);
+    }
+    return 0;
+}
+
+int PollTicket(uint64_t pTicket, bool* pSuccess, bool* pValue)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->PollTicket(pTicket, pSuccess, pValue);
+    }
+    return WAIC_TICKET_INVALID;
+}
+
+int Snapshot(WAIC_DeviceSnapshot* pRecords, int pCapacity, int* pRequiredCount)
+{
+    if (sClient != NULL)
+    {
+        return sClient->Snapshot(pRecords, pCapacity, pRequiredCount);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->Snapshot(pRecords, pCapacity, pRequiredCount);
+    }
+    if (pRequiredCount != NULL)
+    {
+        *pRequiredCount = 0;
+    }
+    return 0;
+}
+
+int SaveListenProfile(void* pBuffer, int pSize)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SaveListenProfile(pBuffer, pSize);
+    }
+    return 0;
+}
+
+int RestoreListenProfile(const void* pBuffer, int pSize)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->RestoreListenProfile(pBuffer, pSize);
+    }
+    return -1;
+}
+
+bool RefreshAudioInputs()
+{
+    if (sClient != NULL)
+    {
+        return sClient->RefreshAudioInputs();
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->RefreshAudioInputs();
+    }
+    return false;
+}
+
+unsigned long long GetListenStateReadCount()
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->GetListenStateReads();
+    }
+    return 0;
+}
+
+void SetWriteCoalescingWindow(int pMilliseconds)
+{
+    if (sWAIC != NULL)
+    {
+        sWAIC->SetWriteCoalescingWindow(pMilliseconds);
+    }
+}
+
+unsigned long long GetSavedWriteCount()
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->GetSavedWrites();
+    }
+    return 0;
+}
+
+void SetCallTimeout(int pMilliseconds)
+{
+    if (sWAIC != NULL)
+    {
+        sWAIC->SetCallTimeout(pMilliseconds);
+    }
+}
+
+bool IsListeningWithTimeout(const char* pDeviceName, int pTimeoutMs)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->IsListeningWithTimeout(pDeviceName, pTimeoutMs);
+    }
+    return false;
+}
+
+bool SetListenToAudioInputDeviceWithTimeout(const char* pDeviceName, bool pListen, int pTimeoutMs)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SetListenToAudioInputDeviceWithTimeout(pDeviceName, pListen, pTimeoutMs);
+    }
+    return false;
+}
+
+void SetRetryPolicy(int pMaxAttempts, int pInitialBackoffMs, int pMaxBackoffMs)
+{
+    if (sWAIC != NULL)
+    {
+        sWAIC->SetRetryPolicy(pMaxAttempts, pInitialBackoffMs, pMaxBackoffMs);
+    }
+}
+
+void SetCircuitBreaker(int pFailureThreshold, int pCooldownMs)
+{
+    if (sWAIC != NULL)
+    {
+        sWAIC->SetCircuitBreaker(pFailureThreshold, pCooldownMs);
+    }
+}
+
+int DrainEvents(WAIC_Event* pEvents, int pCapacity)
+{
+    if (sWAIC != NULL && pEvents != NULL)
+    {
+        return sWAIC->DrainEvents(pEvents, pCapacity);
+    }
+    return 0;
+}
+
+void SetEventCallback(WAIC_EventCallback pCallback, void* pUserData)
+{
+    if (sWAIC != NULL)
+    {
+        sWAIC->SetEventCallback(pCallback, pUserData);
+    }
+}
+
+unsigned long long GetDroppedEventCount()
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->GetDroppedEventCount();
+    }
+    return 0;
+}
+
+bool StartLevelMetering(int pRateHz)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->StartLevelMetering(pRateHz);
+    }
+    return false;
+}
+
+void StopLevelMetering()
+{
+    if (sWAIC != NULL)
+    {
+        sWAIC->StopLevelMetering();
+    }
+}
+
+bool WatchDeviceLevels(WAIC_DeviceHandle pDevice, bool pWatch)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->WatchDeviceLevels(pDevice, pWatch);
+    }
+    return false;
+}
+
+int ReadLevels(WAIC_Level* pLevels, int pCapacity)
+{
+    if (sWAIC != NULL && pLevels != NULL)
+    {
+        return sWAIC->ReadLevels(pLevels, pCapacity);
+    }
+    return 0;
+}
+
+bool StartMonitor(WAIC_DeviceHandle pDevice, WAIC_OutputHandle pOutput, int pBufferMs)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->StartMonitor(pDevice, pOutput, pBufferMs);
+    }
+    return false;
+}
+
+bool StopMonitor(WAIC_DeviceHandle pDevice)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->StopMonitor(pDevice);
+    }
+    return false;
+}
+
+bool SetMonitorGain(WAIC_DeviceHandle pDevice, float pGain)
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->SetMonitorGain(pDevice, pGain);
+    }
+    return false;
+}
+
+bool SetMonitorChannelMap(WAIC_DeviceHandle pDevice, const int* pMap, int pCount)
+{
+    if (sWAIC != NULL && (pMap != NULL || pCount <= 0))
+    {
+        return sWAIC->SetMonitorChannelMap(pDevice, pMap, pCount);
+    }
+    return false;
+}
+
+bool GetMonitorStats(WAIC_DeviceHandle pDevice, WAIC_MonitorStats* pStats)
+{
+    if (sWAIC != NULL && pStats != NULL)
+    {
+        return sWAIC->GetMonitorStats(pDevice, *pStats);
+    }
+    return false;
+}
+
 bool HasError()
 {
+    if (sClient != NULL)
+    {
+        return sClient->HasError();
+    }
     if (sWAIC != NULL)
     {
         return sWAIC->HasError();
@@ -53,8 +570,39 @@ bool HasError()
     return false;
 }
 
+bool GetStats(WAIC_Stats* pStats)
+{
+    if (sWAIC != NULL && pStats != NULL)
+    {
+        sWAIC->GetStats(*pStats);
+        return true;
+    }
+    return false;
+}
+
+const char* GetStatsJson()
+{
+    if (sWAIC != NULL)
+    {
+        return sWAIC->GetStatsJson();
+    }
+    return NULL;
+}
+
+void ResetStats()
+{
+    if (sWAIC != NULL)
+    {
+        sWAIC->ResetStats();
+    }
+}
+
 const char* GetErrors()
 {
+    if (sClient != NULL)
+    {
+        return sClient->GetErrors();
+    }
     if (sWAIC != NULL)
     {
         return sWAIC->GetErrors();
@@ -62,8 +610,36 @@ const char* GetErrors()
     return NULL;
 }
 
+int DrainErrors(WAIC_ErrorRecord* pRecords, int pCapacity)
+{
+    if (sClient != NULL)
+    {
+        return sClient->DrainErrors(pRecords, pCapacity);
+    }
+    if (sWAIC != NULL)
+    {
+        return sWAIC->DrainErrors(pRecords, pCapacity);
+    }
+    return 0;
+}
+
+void ClearErrors()
+{
+    if (sClient != NULL)
+    {
+        sClient->ClearErrors();
+        return;
+    }
+    if (sWAIC != NULL)
+    {
+        sWAIC->ClearErrors();
+    }
+}
+
 void Terminate()
 {
     delete sWAIC;
     sWAIC = NULL;
+    delete sClient;
+    sClient = NULL;
 }
\ No newline at end of file
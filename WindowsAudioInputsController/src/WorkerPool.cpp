@@ -0,0 +1,111 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int pThreadCount, const std::function<void()>& pThreadInit, const std::function<void()>& pThreadExit)
+	: _threadInit(pThreadInit), _threadExit(pThreadExit), _threads(), _parallelForMutex(), _mutex(), _wakeUp(), _workerDone(),
+	_batch(NULL), _batchId(0), _stop(false)
+{
+	Reserve(pThreadCount);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wakeUp.notify_all();
+	for (std::thread& thread : _threads)
+	{
+		thread.join();
+	}
+}
+
+void WorkerPool::ParallelFor(int pCount, const std::function<void(int)>& pTask)
+{
+	if (pCount <= 0) return;
+
+	std::lock_guard<std::mutex> parallelForLock(_parallelForMutex);
+	Batch batch;
+	batch.task = &pTask;
+	batch.count = pCount;
+	batch.next = 0;
+	batch.workers = 0;
+
+	if (pCount > 1 && !_threads.empty())
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_batch = &batch;
+		++_batchId;
+		_wakeUp.notify_all();
+	}
+
+	_Work(&batch);
+
+	// The batch lives on this stack: wait for the workers which joined it to leave it.
+	std::unique_lock<std::mutex> lock(_mutex);
+	_batch = NULL;
+	_workerDone.wait(lock, [&batch] { return batch.workers == 0; });
+}
+
+void WorkerPool::Reserve(int pThreadCount)
+{
+	// The threads vector is not resized during a batch. A new thread only joins the next one.
+	std::lock_guard<std::mutex> parallelForLock(_parallelForMutex);
+	while ((int)_threads.size() < pThreadCount)
+	{
+		_threads.emplace_back(&WorkerPool::_Run, this);
+	}
+}
+
+void WorkerPool::_Run()
+{
+	if (_threadInit) _threadInit();
+
+	uint64_t lastBatchId = 0;
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_wakeUp.wait(lock, [this, lastBatchId] { return _stop || (_batch != NULL && _batchId != lastBatchId); });
+		if (_stop) break;
+
+		Batch* batch = _batch;
+		lastBatchId = _batchId;
+		++batch->workers;
+		lock.unlock();
+
+		_Work(batch);
+
+		lock.lock();
+		--batch->workers;
+		_workerDone.notify_all();
+	}
+	lock.unlock();
+
+	if (_threadExit) _threadExit();
+}
+
+void WorkerPool::_Work(Batch* pBatch)
+{
+	for (int i = pBatch->next++; i < pBatch->count; i = pBatch->next++)
+	{
+		(*pBatch->task)(i);
+	}
+}
@@ -0,0 +1,405 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "MockEndpointProvider.h"
+#include "SampleConversion.h"
+#include "SampleRing.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs the C API against the MockEndpointProvider, with N capture devices and a simulated latency per backend call.
+// Usage: WindowsAudioInputsControllerBenchmark [--devices 1,100,1000,10000] [--latency-us 0] [--threads 4] [--iterations 10000]
+//                                              [--fault-rate 0] [--stall-rate 0] [--stall-us 0] [--timeout-ms 0]
+//                                              [--json results.json] [--csv results.csv] [--smoke]
+// With the fault options, a seeded share of the property reads/writes fail with a transient error or stall, so that the tail latency
+// under failure (retries, timeouts) can be measured and compared from one run to another.
+
+struct BenchmarkOptions
+{
+    std::vector<int> deviceCounts = { 1, 100, 1000, 10000 };
+    int latencyUs = 0;
+    int threadCount = 4;
+    int iterations = 10000;
+    double faultRate = 0.0;
+    double stallRate = 0.0;
+    int stallUs = 0;
+    int timeoutMs = 0;
+    std::string jsonPath;
+    std::string csvPath;
+};
+
+struct BenchmarkResult
+{
+    std::string scenario;
+    int deviceCount;
+    int threadCount;
+    int operationCount;
+    double seconds;
+    double operationsPerSecond;
+    double p50Us;
+    double p99Us;
+    double maxUs;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static std::string GetDeviceName(int pIndex)
+{
+    return "Microphone " + std::to_string(pIndex);
+}
+
+static double GetPercentileUs(std::vector<int64_t>& pLatenciesNs, double pPercentile)
+{
+    if (pLatenciesNs.empty()) return 0.0;
+
+    size_t rank = (size_t)(pPercentile / 100.0 * (double)(pLatenciesNs.size() - 1) + 0.5);
+    std::nth_element(pLatenciesNs.begin(), pLatenciesNs.begin() + rank, pLatenciesNs.end());
+    return (double)pLatenciesNs[rank] / 1000.0;
+}
+
+/// <summary>
+/// Runs pOperation(thread, i) pCount times in total, split over pThreadCount threads, and measures each call.
+/// </summary>
+template<typename Operation>
+static BenchmarkResult Measure(const char* pScenario, int pDeviceCount, int pThreadCount, int pCount, const Operation& pOperation)
+{
+    std::vector<std::vector<int64_t>> latencies(pThreadCount);
+    auto run = [&](int pThread)
+    {
+        std::vector<int64_t>& threadLatencies = latencies[pThread];
+        threadLatencies.reserve(pCount / pThreadCount + 1);
+        for (int i = pThread; i < pCount; i += pThreadCount)
+        {
+            Clock::time_point start = Clock::now();
+            pOperation(pThread, i);
+            threadLatencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        }
+    };
+
+    Clock::time_point start = Clock::now();
+    if (pThreadCount == 1)
+    {
+        run(0);
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < pThreadCount; ++t)
+        {
+            threads.emplace_back(run, t);
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<int64_t> allLatencies;
+    allLatencies.reserve(pCount);
+    for (const std::vector<int64_t>& threadLatencies : latencies)
+    {
+        allLatencies.insert(allLatencies.end(), threadLatencies.begin(), threadLatencies.end());
+    }
+
+    BenchmarkResult result;
+    result.scenario = pScenario;
+    result.deviceCount = pDeviceCount;
+    result.threadCount = pThreadCount;
+    result.operationCount = pCount;
+    result.seconds = seconds;
+    result.operationsPerSecond = (seconds > 0.0) ? (double)pCount / seconds : 0.0;
+    result.maxUs = allLatencies.empty() ? 0.0 : (double)*std::max_element(allLatencies.begin(), allLatencies.end()) / 1000.0;
+    result.p50Us = GetPercentileUs(allLatencies, 50.0);
+    result.p99Us = GetPercentileUs(allLatencies, 99.0);
+    return result;
+}
+
+static void RunDeviceCount(const BenchmarkOptions& pOptions, int pDeviceCount, std::vector<BenchmarkResult>& pResults)
+{
+    MockEndpointProvider* provider = new MockEndpointProvider();
+    provider->AddCaptureEndpoints(pDeviceCount);
+    provider->SetLatency(std::chrono::microseconds(pOptions.latencyUs));
+    InitWithProvider(provider);
+
+    std::vector<std::string> names(pDeviceCount);
+    for (int i = 0; i < pDeviceCount; ++i)
+    {
+        names[i] = GetDeviceName(i);
+    }
+
+    // Same pseudo-random device sequence for every run.
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> distribution(0, pDeviceCount - 1);
+    std::vector<int> devices(pOptions.iterations);
+    for (int& device : devices)
+    {
+        device = distribution(random);
+    }
+
+    // Name resolution: first opening of each device (the first one also enumerates the endpoints), then cache hits.
+    int coldCount = std::min(pDeviceCount, pOptions.iterations);
+    pResults.push_back(Measure("resolve_cold", pDeviceCount, 1, coldCount, [&](int, int pIndex)
+    {
+        OpenDevice(names[pIndex].c_str());
+    }));
+    // Opens the remaining devices, so that every measure below runs on opened devices.
+    for (int i = coldCount; i < pDeviceCount; ++i)
+    {
+        OpenDevice(names[i].c_str());
+    }
+    pResults.push_back(Measure("resolve_warm", pDeviceCount, 1, pOptions.iterations, [&](int, int pIndex)
+    {
+        OpenDevice(names[devices[pIndex]].c_str());
+    }));
+
+    // Injected once the devices are opened: only the property accesses fail or stall.
+    if (pOptions.faultRate > 0.0 || pOptions.stallRate > 0.0)
+    {
+        provider->SetFaultSeed(42);
+        MockFault fault;
+        fault.calls = MOCK_CALL_GET_VALUE | MOCK_CALL_SET_VALUE;
+        fault.result = ENDPOINT_E_BUSY;
+        fault.probability = pOptions.faultRate;
+        provider->AddFault(fault);
+        fault.result = ENDPOINT_OK;
+        fault.probability = pOptions.stallRate;
+        fault.stall = std::chrono::microseconds(pOptions.stallUs);
+        provider->AddFault(fault);
+    }
+    SetCallTimeout(pOptions.timeoutMs);
+
+    // Listen state reads, cached after the first one.
+    pResults.push_back(Measure("is_listening", pDeviceCount, 1, pOptions.iterations, [&](int, int pIndex)
+    {
+        IsListening(names[devices[pIndex]].c_str());
+    }));
+    pResults.push_back(Measure("is_listening", pDeviceCount, pOptions.threadCount, pOptions.iterations, [&](int, int pIndex)
+    {
+        IsListening(names[devices[pIndex]].c_str());
+    }));
+
+    // Every write toggles its device, so that none is skipped as redundant.
+    std::vector<char> listenStates(pDeviceCount, 0);
+    pResults.push_back(Measure("set_listen", pDeviceCount, 1, pOptions.iterations, [&](int, int pIndex)
+    {
+        int device = devices[pIndex];
+        listenStates[device] = !listenStates[device];
+        SetListenToAudioInputDevice(names[device].c_str(), listenStates[device] != 0);
+    }));
+    // Each thread toggles its own devices (device % threadCount == thread), hence at most one thread per device.
+    int threadCount = std::min(pOptions.threadCount, pDeviceCount);
+    pResults.push_back(Measure("set_listen", pDeviceCount, threadCount, pOptions.iterations, [&](int pThread, int pIndex)
+    {
+        int threadDeviceCount = (pDeviceCount - pThread + threadCount - 1) / threadCount;
+        int device = pThread + threadCount * (devices[pIndex] % threadDeviceCount);
+        listenStates[device] = !listenStates[device];
+        SetListenToAudioInputDevice(names[device].c_str(), listenStates[device] != 0);
+    }));
+
+    if (pOptions.faultRate > 0.0 || pOptions.stallRate > 0.0)
+    {
+        WAIC_Stats stats;
+        GetStats(&stats);
+        std::cout << pDeviceCount << " devices: " << provider->GetInjectedFaultCount() << " injected faults, " << stats.faults[WAIC_FAULT_RETRY]
+            << " retries, " << stats.faults[WAIC_FAULT_TIMEOUT] << " timeouts" << std::endl;
+        // The injected failures are expected: only report the other ones.
+        WAIC_ErrorRecord record;
+        while (DrainErrors(&record, 1) == 1)
+        {
+            if (record.hresult != (int32_t)ENDPOINT_E_BUSY && record.code != WAIC_ERROR_TIMEOUT)
+            {
+                std::cerr << "Error " << record.code << " on " << record.device << std::endl;
+            }
+        }
+    }
+    else if (HasError())
+    {
+        std::cerr << GetErrors() << std::endl;
+    }
+    Terminate();
+}
+
+// Software monitor kernels on synthetic 10 ms stereo buffers at 48 kHz (no device: reported with 0 devices).
+static void RunSampleKernels(const BenchmarkOptions& pOptions, std::vector<BenchmarkResult>& pResults)
+{
+    const size_t frames = 480;
+    const size_t samples = frames * 2;
+    std::vector<float> input(samples), output(samples);
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; ++i)
+    {
+        input[i] = 0.5f * (float)sin(0.01 * (double)i);
+    }
+    const int8_t swap[2] = { 1, 0 };
+    SampleRing ring;
+    ring.Reset(samples * 4);
+
+    pResults.push_back(Measure("from_float_i16", 0, 1, pOptions.iterations, [&](int, int)
+    {
+        ConvertFromFloat(EndpointSampleType::Int16, input.data(), pcm.data(), samples);
+    }));
+    pResults.push_back(Measure("to_float_i16", 0, 1, pOptions.iterations, [&](int, int)
+    {
+        ConvertToFloat(EndpointSampleType::Int16, pcm.data(), output.data(), samples);
+    }));
+    pResults.push_back(Measure("map_channels", 0, 1, pOptions.iterations, [&](int, int)
+    {
+        MapChannels(input.data(), 2, output.data(), 2, swap, 0.5f, frames);
+    }));
+    pResults.push_back(Measure("ring_copy", 0, 1, pOptions.iterations, [&](int, int)
+    {
+        ring.Write(input.data(), samples);
+        ring.Read(output.data(), samples);
+    }));
+}
+
+static bool WriteJson(const BenchmarkOptions& pOptions, const std::vector<BenchmarkResult>& pResults)
+{
+    std::ofstream file(pOptions.jsonPath);
+    if (!file) return false;
+
+    file << "{\n  \"latencyUs\": " << pOptions.latencyUs << ",\n  \"faultRate\": " << pOptions.faultRate << ",\n  \"stallRate\": " << pOptions.stallRate
+        << ",\n  \"stallUs\": " << pOptions.stallUs << ",\n  \"timeoutMs\": " << pOptions.timeoutMs << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < pResults.size(); ++i)
+    {
+        const BenchmarkResult& result = pResults[i];
+        file << "    {\"scenario\": \"" << result.scenario << "\", \"devices\": " << result.deviceCount << ", \"threads\": " << result.threadCount
+            << ", \"operations\": " << result.operationCount << ", \"seconds\": " << result.seconds << ", \"opsPerSecond\": " << result.operationsPerSecond
+            << ", \"p50Us\": " << result.p50Us << ", \"p99Us\": " << result.p99Us << ", \"maxUs\": " << result.maxUs << "}"
+            << ((i + 1 < pResults.size()) ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+    return (bool)file;
+}
+
+static bool WriteCsv(const BenchmarkOptions& pOptions, const std::vector<BenchmarkResult>& pResults)
+{
+    std::ofstream file(pOptions.csvPath);
+    if (!file) return false;
+
+    file << "scenario,devices,threads,latencyUs,operations,seconds,opsPerSecond,p50Us,p99Us,maxUs\n";
+    for (const BenchmarkResult& result : pResults)
+    {
+        file << result.scenario << "," << result.deviceCount << "," << result.threadCount << "," << pOptions.latencyUs << "," << result.operationCount << ","
+            << result.seconds << "," << result.operationsPerSecond << "," << result.p50Us << "," << result.p99Us << "," << result.maxUs << "\n";
+    }
+    return (bool)file;
+}
+
+static std::vector<int> ParseList(const char* pText)
+{
+    std::vector<int> values;
+    for (const char* text = pText; *text != '\0'; )
+    {
+        char* end = NULL;
+        long value = strtol(text, &end, 10);
+        if (end == text) break;
+        values.push_back((int)value);
+        text = (*end == ',') ? end + 1 : end;
+    }
+    return values;
+}
+
+static bool ParseOptions(int pArgc, char** pArgv, BenchmarkOptions& pOptions)
+{
+    for (int i = 1; i < pArgc; ++i)
+    {
+        const char* arg = pArgv[i];
+        const char* value = (i + 1 < pArgc) ? pArgv[i + 1] : NULL;
+        if (strcmp(arg, "--smoke") == 0)
+        {
+            pOptions.deviceCounts = { 1, 100 };
+            pOptions.iterations = 200;
+            pOptions.threadCount = 2;
+            continue;
+        }
+        if (value == NULL) return false;
+
+        if (strcmp(arg, "--devices") == 0) pOptions.deviceCounts = ParseList(value);
+        else if (strcmp(arg, "--latency-us") == 0) pOptions.latencyUs = atoi(value);
+        else if (strcmp(arg, "--threads") == 0) pOptions.threadCount = atoi(value);
+        else if (strcmp(arg, "--iterations") == 0) pOptions.iterations = atoi(value);
+        else if (strcmp(arg, "--fault-rate") == 0) pOptions.faultRate = atof(value);
+        else if (strcmp(arg, "--stall-rate") == 0) pOptions.stallRate = atof(value);
+        else if (strcmp(arg, "--stall-us") == 0) pOptions.stallUs = atoi(value);
+        else if (strcmp(arg, "--timeout-ms") == 0) pOptions.timeoutMs = atoi(value);
+        else if (strcmp(arg, "--json") == 0) pOptions.jsonPath = value;
+        else if (strcmp(arg, "--csv") == 0) pOptions.csvPath = value;
+        else return false;
+        ++i;
+    }
+
+    for (int deviceCount : pOptions.deviceCounts)
+    {
+        if (deviceCount < 1) return false;
+    }
+    return !pOptions.deviceCounts.empty() && pOptions.latencyUs >= 0 && pOptions.threadCount >= 1 && pOptions.iterations >= 1
+        && pOptions.faultRate >= 0.0 && pOptions.faultRate <= 1.0 && pOptions.stallRate >= 0.0 && pOptions.stallRate <= 1.0 && pOptions.stallUs >= 0
+        && pOptions.timeoutMs >= 0;
+}
+
+int main(int pArgc, char** pArgv)
+{
+    BenchmarkOptions options;
+    if (!ParseOptions(pArgc, pArgv, options))
+    {
+        std::cerr << "Usage: WindowsAudioInputsControllerBenchmark [--devices 1,100,1000,10000] [--latency-us 0] [--threads 4] [--iterations 10000]"
+            << " [--fault-rate 0] [--stall-rate 0] [--stall-us 0] [--timeout-ms 0] [--json path] [--csv path] [--smoke]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (int deviceCount : options.deviceCounts)
+    {
+        RunDeviceCount(options, deviceCount, results);
+    }
+    RunSampleKernels(options, results);
+
+    std::cout << "scenario        devices threads       ops/s     p50 (us)     p99 (us)     max (us)\n";
+    for (const BenchmarkResult& result : results)
+    {
+        char line[160];
+        snprintf(line, sizeof(line), "%-14s %8d %7d %11.0f %12.2f %12.2f %12.2f\n", result.scenario.c_str(), result.deviceCount, result.threadCount,
+            result.operationsPerSecond, result.p50Us, result.p99Us, result.maxUs);
+        std::cout << line;
+    }
+
+    if (!options.jsonPath.empty() && !WriteJson(options, results))
+    {
+        std::cerr << "Could not write " << options.jsonPath << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!options.csvPath.empty() && !WriteCsv(options, results))
+    {
+        std::cerr << "Could not write " << options.csvPath << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
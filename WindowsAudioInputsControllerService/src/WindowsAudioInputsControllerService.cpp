@@ -0,0 +1,95 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "ControllerService.h"
+#include "MockEndpointProvider.h"
+#include "WindowsAudioInputsController.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Shared controller process: owns the endpoint backend and the device cache, for all the processes using InitClient().
+// Usage: WindowsAudioInputsControllerService [--name WindowsAudioInputsController] [--mock 8]
+//   --mock N: uses a MockEndpointProvider with N capture devices instead of WASAPI (the only backend outside Windows).
+
+static std::atomic<bool> sStop(false);
+
+static void OnSignal(int)
+{
+    sStop = true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string name = WAIC_DEFAULT_SERVICE_NAME;
+    int mockDeviceCount = -1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--name") == 0 && i + 1 < argc)
+        {
+            name = argv[++i];
+        }
+        else if (strcmp(argv[i], "--mock") == 0 && i + 1 < argc)
+        {
+            mockDeviceCount = atoi(argv[++i]);
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--name " << WAIC_DEFAULT_SERVICE_NAME << "] [--mock 8]" << std::endl;
+            return 1;
+        }
+    }
+
+    WindowsAudioInputsController* controller = NULL;
+#if defined(_WIN32)
+    if (mockDeviceCount < 0)
+    {
+        controller = new WindowsAudioInputsController();
+    }
+#endif
+    if (controller == NULL)
+    {
+        MockEndpointProvider* provider = new MockEndpointProvider();
+        provider->AddCaptureEndpoints((mockDeviceCount > 0) ? mockDeviceCount : 8);
+        controller = new WindowsAudioInputsController(provider);
+    }
+
+    ControllerService service(controller);
+    if (!service.Start(name))
+    {
+        std::cerr << "Could not listen on " << ServiceChannel::GetPath(name) << std::endl;
+        return 1;
+    }
+    std::cout << "Listening on " << ServiceChannel::GetPath(name) << std::endl;
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    while (!sStop)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    service.Stop();
+    return 0;
+}
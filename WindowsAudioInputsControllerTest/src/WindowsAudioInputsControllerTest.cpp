@@ -47,6 +47,21 @@ int main()
             quit = true;
         }
 
+        // Changes made outside of this app (eg. from the Windows Sound panel), without polling each device.
+        WAIC_Event events[16];
+        int eventCount = DrainEvents(events, 16);
+        for (int i = 0; i < eventCount; ++i)
+        {
+            if (events[i].type == WAIC_EVENT_LISTEN_CHANGED)
+            {
+                std::cout << "Listening to device " << events[i].name << (events[i].listen == 1 ? " enabled" : " disabled") << " from outside.\n";
+            }
+            else if (events[i].type == WAIC_EVENT_DEVICE_ADDED || events[i].type == WAIC_EVENT_DEVICE_REMOVED)
+            {
+                std::cout << "Device " << events[i].name << (events[i].type == WAIC_EVENT_DEVICE_ADDED ? " added" : " removed") << ".\n";
+            }
+        }
+
         if (HasError())
         {
             std::cout << GetErrors() << std::endl;
@@ -0,0 +1,62 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "MockEndpointProvider.h"
+#include "UnitTest.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Batched calls against the mock backend: parallelism and the writes reaching the endpoints.
+
+static const int DEVICE_COUNT = 32;
+
+// Time taken by one SetListenToAudioInputDevices of the first pCount devices, all of them succeeding.
+static double TimeBatchMs(const std::vector<const char*>& pNames, int pCount, bool pListen)
+{
+    bool listen[DEVICE_COUNT];
+    std::fill(listen, listen + pCount, pListen);
+    auto start = std::chrono::steady_clock::now();
+    CHECK_EQUAL(pCount, SetListenToAudioInputDevices(pNames.data(), listen, pCount, NULL));
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+UNIT_TEST(Batches, ScalesWithSize)
+{
+    MockEndpointProvider* provider = InitMock(DEVICE_COUNT);
+    std::vector<std::string> names;
+    for (int i = 0; i < DEVICE_COUNT; ++i) names.push_back("Microphone " + std::to_string(i));
+    std::vector<const char*> pointers;
+    for (const std::string& name : names) pointers.push_back(name.c_str());
+
+    // Opened and read first: only the writes are timed.
+    bool states[DEVICE_COUNT];
+    CHECK_EQUAL(DEVICE_COUNT, GetListenStates(pointers.data(), DEVICE_COUNT, states, NULL));
+    provider->SetLatency(std::chrono::milliseconds(20));
+
+    // Each device gets its own worker: a batch of 32 takes about as long as one device, not ceil(32 / 8) times as long.
+    double oneMs = TimeBatchMs(pointers, 1, true);
+    double allMs = TimeBatchMs(pointers, DEVICE_COUNT, true);
+    CHECK(allMs < oneMs * 2.5);
+    provider->SetLatency(std::chrono::microseconds(0));
+    CHECK(!HasError());
+    Terminate();
+}
@@ -0,0 +1,293 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "CallPolicy.h"
+#include "MockEndpointProvider.h"
+#include "UnitTest.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <thread>
+#include <vector>
+
+// Retries, circuit breakers and deadlines: CallPolicy on its own, then through the controller with seeded mock faults.
+
+static const char* const DEVICE_ID = "{mock.capture.0}";
+static const char* const DEVICE_NAME = "Microphone 0";
+
+#if WAIC_ENABLE_STATS
+static uint64_t GetFaultCount(const ControllerStats& pStats, WAIC_Fault pFault)
+{
+    WAIC_Stats stats;
+    pStats.Read(stats);
+    return stats.faults[pFault];
+}
+#endif
+
+// Fails with each of pResults in turn, then succeeds.
+struct FailingCall
+{
+    explicit FailingCall(std::vector<EndpointResult> pResults) : results(pResults), attempts(0) {}
+
+    EndpointResult operator()()
+    {
+        EndpointResult result = (attempts < (int)results.size()) ? results[attempts] : ENDPOINT_OK;
+        ++attempts;
+        return result;
+    }
+
+    std::vector<EndpointResult> results;
+    int attempts;
+};
+
+UNIT_TEST(CallPolicy, RetryCount)
+{
+    ControllerStats stats;
+    CallPolicy policy(&stats);
+    CircuitBreaker breaker;
+    policy.SetRetry(4, 0, 0);
+
+    // Transient failures are retried, up to 4 attempts in all.
+    FailingCall transient({ ENDPOINT_E_BUSY, ENDPOINT_E_RETRY_LATER, ENDPOINT_E_DISCONNECTED });
+    CHECK_EQUAL(ENDPOINT_OK, policy.Run(breaker, [&] { return transient(); }));
+    CHECK_EQUAL(4, transient.attempts);
+
+    FailingCall exhausted({ ENDPOINT_E_BUSY, ENDPOINT_E_BUSY, ENDPOINT_E_BUSY, ENDPOINT_E_CALL_REJECTED });
+    CHECK_EQUAL(ENDPOINT_E_CALL_REJECTED, policy.Run(breaker, [&] { return exhausted(); }));
+    CHECK_EQUAL(4, exhausted.attempts);
+
+    // The other ones are not.
+    FailingCall permanent({ ENDPOINT_E_NOTFOUND });
+    CHECK_EQUAL(ENDPOINT_E_NOTFOUND, policy.Run(breaker, [&] { return permanent(); }));
+    CHECK_EQUAL(1, permanent.attempts);
+#if WAIC_ENABLE_STATS
+    CHECK_EQUAL((uint64_t)6, GetFaultCount(stats, WAIC_FAULT_RETRY));
+#endif
+}
+
+UNIT_TEST(CallPolicy, Deadline)
+{
+    ControllerStats stats;
+    CallPolicy policy(&stats);
+    CircuitBreaker breaker;
+    policy.SetRetry(3, 50, 50);
+
+    // Already passed: the call is not made.
+    FailingCall late({});
+    {
+        CallPolicy::DeadlineScope deadline(CallPolicy::Clock::now() - std::chrono::milliseconds(1));
+        CHECK_EQUAL(ENDPOINT_E_TIMEOUT, policy.Run(breaker, [&] { return late(); }));
+    }
+    CHECK_EQUAL(0, late.attempts);
+
+    // The retry would start past the deadline: the failure is returned without waiting.
+    FailingCall transient({ ENDPOINT_E_BUSY });
+    CallPolicy::Clock::time_point start = CallPolicy::Clock::now();
+    {
+        CallPolicy::DeadlineScope deadline(start + std::chrono::milliseconds(20));
+        CHECK_EQUAL(ENDPOINT_E_BUSY, policy.Run(breaker, [&] { return transient(); }));
+    }
+    CHECK_EQUAL(1, transient.attempts);
+    CHECK(CallPolicy::Clock::now() - start < std::chrono::milliseconds(50));
+
+    // Outside of the scope, no deadline.
+    CHECK(CallPolicy::GetDeadline() == CallPolicy::Clock::time_point::max());
+#if WAIC_ENABLE_STATS
+    CHECK_EQUAL((uint64_t)1, GetFaultCount(stats, WAIC_FAULT_TIMEOUT));
+    CHECK_EQUAL((uint64_t)0, GetFaultCount(stats, WAIC_FAULT_RETRY));
+#endif
+}
+
+UNIT_TEST(CallPolicy, CircuitBreakerStates)
+{
+    CircuitBreaker breaker;
+    CircuitBreaker::Clock::time_point now = CircuitBreaker::Clock::now();
+    const int threshold = 3;
+    const int cooldownMs = 100;
+
+    // Opens at the threshold.
+    for (int i = 1; i < threshold; ++i)
+    {
+        CHECK(breaker.Allow(now));
+        CHECK(!breaker.Record(false, threshold, cooldownMs, now));
+    }
+    CHECK(breaker.Allow(now));
+    CHECK(breaker.Record(false, threshold, cooldownMs, now));
+    CHECK(breaker.IsOpen());
+    CHECK(!breaker.Allow(now + std::chrono::milliseconds(cooldownMs - 1)));
+
+    // Half-open after the cooldown: a single trial call, which reopens it on failure.
+    now += std::chrono::milliseconds(cooldownMs);
+    CHECK(breaker.Allow(now));
+    CHECK(!breaker.IsOpen());
+    CHECK(!breaker.Allow(now));
+    CHECK(breaker.Record(false, threshold, cooldownMs, now));
+    CHECK(!breaker.Allow(now + std::chrono::milliseconds(cooldownMs - 1)));
+
+    // A successful trial closes it.
+    now += std::chrono::milliseconds(cooldownMs);
+    CHECK(breaker.Allow(now));
+    CHECK(!breaker.Record(true, threshold, cooldownMs, now));
+    CHECK(breaker.Allow(now));
+    CHECK(breaker.Allow(now));
+}
+
+UNIT_TEST(CallPolicy, CircuitOpenRejects)
+{
+    ControllerStats stats;
+    CallPolicy policy(&stats);
+    CircuitBreaker breaker;
+    policy.SetRetry(1, 0, 0);
+    policy.SetCircuitBreaker(2, 50);
+
+    FailingCall failing({ ENDPOINT_E_FAIL, ENDPOINT_E_FAIL });
+    CHECK_EQUAL(ENDPOINT_E_FAIL, policy.Run(breaker, [&] { return failing(); }));
+    CHECK(!breaker.IsOpen());
+    CHECK_EQUAL(ENDPOINT_E_FAIL, policy.Run(breaker, [&] { return failing(); }));
+    CHECK(breaker.IsOpen());
+    CHECK_EQUAL(ENDPOINT_E_CIRCUIT_OPEN, policy.Run(breaker, [&] { return failing(); }));
+    CHECK_EQUAL(2, failing.attempts);
+
+    // The trial call after the cooldown succeeds and closes it.
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    CHECK_EQUAL(ENDPOINT_OK, policy.Run(breaker, [&] { return failing(); }));
+    CHECK(!breaker.IsOpen());
+    CHECK_EQUAL(3, failing.attempts);
+#if WAIC_ENABLE_STATS
+    CHECK_EQUAL((uint64_t)1, GetFaultCount(stats, WAIC_FAULT_CIRCUIT_OPENED));
+    CHECK_EQUAL((uint64_t)1, GetFaultCount(stats, WAIC_FAULT_CIRCUIT_REJECTED));
+#endif
+}
+
+// Retries without backoff, so that the tests do not sleep.
+static MockEndpointProvider* InitWithRetries()
+{
+    MockEndpointProvider* provider = InitMock(2, 1234);
+    SetRetryPolicy(3, 0, 0);
+    return provider;
+}
+
+static MockFault GetFault(uint32_t pCalls, EndpointResult pResult, int pCount)
+{
+    MockFault fault;
+    fault.calls = pCalls;
+    fault.endpointId = DEVICE_ID;
+    fault.result = pResult;
+    fault.count = pCount;
+    return fault;
+}
+
+static int DrainErrorCode()
+{
+    WAIC_ErrorRecord record;
+    int code = (DrainErrors(&record, 1) == 1) ? record.code : 0;
+    ClearErrors();
+    return code;
+}
+
+UNIT_TEST(CallPolicy, ControllerRetries)
+{
+    MockEndpointProvider* provider = InitWithRetries();
+    provider->AddFault(GetFault(MOCK_CALL_SET_VALUE, ENDPOINT_E_BUSY, 2));
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, true));
+    CHECK_EQUAL((uint64_t)2, provider->GetInjectedFaultCount());
+    CHECK(IsListening(DEVICE_NAME));
+    CHECK(!HasError());
+#if WAIC_ENABLE_STATS
+    WAIC_Stats stats;
+    CHECK(GetStats(&stats));
+    CHECK_EQUAL((uint64_t)2, stats.faults[WAIC_FAULT_RETRY]);
+#endif
+
+    // Seeded: the same probabilistic faults are drawn on each run.
+    MockFault fault = GetFault(MOCK_CALL_SET_VALUE, ENDPOINT_E_NOTFOUND, -1);
+    fault.probability = 0.5;
+    uint64_t injected[2];
+    for (int run = 0; run < 2; ++run)
+    {
+        provider->ClearFaults();
+        provider->SetFaultSeed(99);
+        provider->AddFault(fault);
+        uint64_t before = provider->GetInjectedFaultCount();
+        for (int i = 0; i < 16; ++i)
+        {
+            SetListenToAudioInputDevice(DEVICE_NAME, (i & 1) != 0);
+        }
+        injected[run] = provider->GetInjectedFaultCount() - before;
+    }
+    CHECK_EQUAL(injected[0], injected[1]);
+    CHECK(injected[0] > 0 && injected[0] < 16);
+    provider->ClearFaults();
+    ClearErrors();
+    Terminate();
+}
+
+UNIT_TEST(CallPolicy, ControllerCircuitBreaker)
+{
+    MockEndpointProvider* provider = InitWithRetries();
+    SetCircuitBreaker(2, 100);
+    CHECK(!IsListening(DEVICE_NAME));
+    provider->AddFault(GetFault(MOCK_CALL_SET_VALUE, ENDPOINT_E_FAIL, -1));
+
+    CHECK(!SetListenToAudioInputDevice(DEVICE_NAME, true));
+    CHECK_EQUAL((int)WAIC_ERROR_WRITE_FAILED, DrainErrorCode());
+    CHECK(!SetListenToAudioInputDevice(DEVICE_NAME, true));
+    CHECK_EQUAL((int)WAIC_ERROR_WRITE_FAILED, DrainErrorCode());
+
+    // Open: rejected without calling the backend. The other devices are not affected.
+    uint64_t injected = provider->GetInjectedFaultCount();
+    CHECK(!SetListenToAudioInputDevice(DEVICE_NAME, true));
+    CHECK_EQUAL((int)WAIC_ERROR_CIRCUIT_OPEN, DrainErrorCode());
+    CHECK_EQUAL(injected, provider->GetInjectedFaultCount());
+    CHECK(SetListenToAudioInputDevice("Microphone 1", true));
+
+    // Half-open after the cooldown: the trial call succeeds and closes it.
+    provider->ClearFaults();
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, true));
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, false));
+    CHECK(!HasError());
+#if WAIC_ENABLE_STATS
+    WAIC_Stats stats;
+    CHECK(GetStats(&stats));
+    CHECK_EQUAL((uint64_t)1, stats.faults[WAIC_FAULT_CIRCUIT_OPENED]);
+    CHECK_EQUAL((uint64_t)1, stats.faults[WAIC_FAULT_CIRCUIT_REJECTED]);
+#endif
+    Terminate();
+}
+
+UNIT_TEST(CallPolicy, ControllerTimeout)
+{
+    MockEndpointProvider* provider = InitWithRetries();
+    MockFault stall = GetFault(MOCK_CALL_SET_VALUE, ENDPOINT_OK, 1);
+    stall.stall = std::chrono::milliseconds(200);
+    provider->AddFault(stall);
+
+    // The write is still running at the timeout: the call fails without waiting for it.
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CHECK(!SetListenToAudioInputDeviceWithTimeout(DEVICE_NAME, true, 20));
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(150));
+    CHECK_EQUAL((int)WAIC_ERROR_TIMEOUT, DrainErrorCode());
+
+    // Queued behind the stalled write: its deadline has passed when it starts, so it is not made.
+    CHECK(!SetListenToAudioInputDeviceWithTimeout("Microphone 1", true, 20));
+    CHECK_EQUAL((int)WAIC_ERROR_TIMEOUT, DrainErrorCode());
+    CHECK(WaitFor([&] { return IsListening(DEVICE_NAME); }));
+    CHECK(!IsListening("Microphone 1"));
+    ClearErrors();
+    Terminate();
+}
@@ -0,0 +1,107 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "EndpointProperties.h"
+#include "MockEndpointProvider.h"
+#include "UnitTest.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <chrono>
+#include <thread>
+
+// Writes skipped or coalesced by the controller: counted in the property writes reaching the mock endpoints.
+
+static const char* const DEVICE_ID = "{mock.capture.1}";
+static const char* const DEVICE_NAME = "Microphone 1";
+// A listen write sets the enabled and the target properties.
+static const uint64_t WRITES_PER_LISTEN = 2;
+
+static bool IsEndpointListening(MockEndpointProvider* pProvider)
+{
+    EndpointPropertyValue value;
+    return pProvider->GetEndpointProperty(DEVICE_ID, ListenEnabledProperty::GetKey(), value) && value.type == EndpointPropertyValue::Bool && value.boolValue;
+}
+
+UNIT_TEST(Coalescing, SkipsNoOpWrites)
+{
+    MockEndpointProvider* provider = InitMock(3);
+    CHECK(!IsListening(DEVICE_NAME));
+    uint64_t writes = provider->GetWriteCount();
+    unsigned long long saved = GetSavedWriteCount();
+
+    // Already in the requested state: nothing is sent.
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, false));
+    CHECK_EQUAL(writes, provider->GetWriteCount());
+    CHECK_EQUAL(saved + 1, GetSavedWriteCount());
+
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, true));
+    CHECK_EQUAL(writes + WRITES_PER_LISTEN, provider->GetWriteCount());
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, true));
+    CHECK_EQUAL(writes + WRITES_PER_LISTEN, provider->GetWriteCount());
+    CHECK_EQUAL(saved + 2, GetSavedWriteCount());
+    CHECK(IsEndpointListening(provider));
+    CHECK(!HasError());
+    Terminate();
+}
+
+UNIT_TEST(Coalescing, LastWriteWins)
+{
+    MockEndpointProvider* provider = InitMock(3);
+    CHECK(!IsListening(DEVICE_NAME));
+    SetWriteCoalescingWindow(100);
+    uint64_t writes = provider->GetWriteCount();
+    unsigned long long saved = GetSavedWriteCount();
+
+    // Push-to-talk burst: 9 toggles ending on listening. The requested state is returned before it is written.
+    for (int i = 0; i < 9; ++i)
+    {
+        CHECK(SetListenToAudioInputDevice(DEVICE_NAME, i % 2 == 0));
+    }
+    CHECK(IsListening(DEVICE_NAME));
+    CHECK(WaitFor([&] { return IsEndpointListening(provider); }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+
+    // Only the last state is written, the 8 superseded requests are saved.
+    CHECK_EQUAL(writes + WRITES_PER_LISTEN, provider->GetWriteCount());
+    CHECK_EQUAL(saved + 8, GetSavedWriteCount());
+    CHECK(IsListening(DEVICE_NAME));
+    CHECK(!HasError());
+    SetWriteCoalescingWindow(0);
+    Terminate();
+}
+
+UNIT_TEST(Coalescing, BurstBackToCurrentState)
+{
+    MockEndpointProvider* provider = InitMock(3);
+    CHECK(!IsListening(DEVICE_NAME));
+    SetWriteCoalescingWindow(50);
+    uint64_t writes = provider->GetWriteCount();
+    unsigned long long saved = GetSavedWriteCount();
+
+    // Toggled on and back off within the window: the committed state is the current one, nothing is written.
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, true));
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, false));
+    CHECK(WaitFor([&] { return GetSavedWriteCount() == saved + 2; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK_EQUAL(writes, provider->GetWriteCount());
+    CHECK_EQUAL(saved + 2, GetSavedWriteCount());
+    CHECK(!IsListening(DEVICE_NAME));
+    CHECK(!HasError());
+    SetWriteCoalescingWindow(0);
+    Terminate();
+}
@@ -0,0 +1,143 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "LevelMeter.h"
+#include "MockEndpointProvider.h"
+#include "UnitTest.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// Level metering: the published peak, the RMS over the last RMS_WINDOW_MS, and the failures of the meters.
+
+// Returns pPeaks in order, then blocks until Release(), then fails with pFailure.
+class ScriptedMeter : public IEndpointMeter
+{
+public:
+    ScriptedMeter(const std::vector<float>& pPeaks, EndpointResult pFailure) : _peaks(pPeaks), _failure(pFailure), _next(0), _blocked(false), _released(false) {}
+
+    EndpointResult GetPeakValue(float& pPeak) override
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_next < _peaks.size())
+        {
+            pPeak = _peaks[_next++];
+            return ENDPOINT_OK;
+        }
+        _blocked = true;
+        _releasedCondition.wait(lock, [this] { return _released; });
+        pPeak = 0.0f;
+        return _failure;
+    }
+
+    // True once every peak has been returned: the last one is published.
+    bool IsBlocked()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _blocked;
+    }
+
+    void Release()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _released = true;
+        _releasedCondition.notify_all();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _releasedCondition;
+    std::vector<float> _peaks;
+    EndpointResult _failure;
+    size_t _next;
+    bool _blocked;
+    bool _released;
+};
+
+UNIT_TEST(LevelMeter, PeakAndRmsWindow)
+{
+    // 100 Hz: the RMS window holds the last 10 peaks, ie. 5 * 0.2 and 5 * 1.0.
+    const int rateHz = 100;
+    std::vector<float> peaks(10, 0.2f);
+    peaks.insert(peaks.end(), 5, 1.0f);
+    ScriptedMeter* meter = new ScriptedMeter(peaks, ENDPOINT_E_DEVICE_INVALIDATED);
+    std::unique_ptr<IEndpointMeter> ownedMeter(meter);
+
+    MockEndpointProvider provider;
+    LevelMeter levelMeter;
+    const WAIC_DeviceHandle device = 42;
+    CHECK(levelMeter.Watch(device, ownedMeter));
+    CHECK(levelMeter.Start(&provider, rateHz));
+    CHECK(WaitFor([&] { return meter->IsBlocked(); }));
+
+    WAIC_Level level;
+    CHECK_EQUAL(1, levelMeter.Read(&level, 1));
+    CHECK_EQUAL(device, level.device);
+    CHECK_EQUAL(0, level.hresult);
+    CHECK(level.timestampUs > 0);
+    CHECK_NEAR(1.0, level.peak, 1e-6);
+    CHECK_NEAR(sqrt((5 * 0.2 * 0.2 + 5 * 1.0 * 1.0) / 10.0), level.rms, 1e-5);
+
+    // A failing meter keeps the device listed, with its result and a zero level.
+    meter->Release();
+    CHECK(WaitFor([&] { return levelMeter.Read(&level, 1) == 1 && level.hresult != 0; }));
+    CHECK_EQUAL((int32_t)ENDPOINT_E_DEVICE_INVALIDATED, level.hresult);
+    CHECK_EQUAL(device, level.device);
+    CHECK_EQUAL(0.0f, level.peak);
+    CHECK_EQUAL(0.0f, level.rms);
+
+    levelMeter.Stop();
+    provider.InitializeThread();
+    levelMeter.UnwatchAll();
+    provider.UninitializeThread();
+}
+
+UNIT_TEST(LevelMeter, MockEndpointLevel)
+{
+    MockEndpointProvider* provider = CreateMock(1);
+    provider->SetEndpointLevel("{mock.capture.0}", 0.25f);
+    InitWithProvider(provider);
+    WAIC_DeviceHandle device = OpenDevice("Microphone 0");
+    CHECK(WatchDeviceLevels(device, true));
+    CHECK(StartLevelMetering(200));
+
+    // Constant peak: so is the RMS.
+    WAIC_Level level;
+    CHECK(WaitFor([&] { return ReadLevels(&level, 1) == 1 && level.timestampUs != 0; }));
+    CHECK_EQUAL(device, level.device);
+    CHECK_EQUAL(0, level.hresult);
+    CHECK_NEAR(0.25, level.peak, 1e-6);
+    CHECK_NEAR(0.25, level.rms, 1e-6);
+
+    MockFault fault;
+    fault.calls = MOCK_CALL_GET_VALUE;
+    fault.endpointId = "{mock.capture.0}";
+    fault.result = ENDPOINT_E_FAIL;
+    provider->AddFault(fault);
+    CHECK(WaitFor([&] { return ReadLevels(&level, 1) == 1 && level.hresult != 0; }));
+    CHECK_EQUAL((int32_t)ENDPOINT_E_FAIL, level.hresult);
+    CHECK_EQUAL(0.0f, level.peak);
+    CHECK_EQUAL(0.0f, level.rms);
+
+    provider->ClearFaults();
+    StopLevelMetering();
+    Terminate();
+}
@@ -0,0 +1,169 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "EndpointProperties.h"
+#include "MockEndpointProvider.h"
+#include "UnitTest.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <string>
+
+// Device matching on the name index: "Line In", "Microphone 0" to "Microphone 2" and "USB Headset", in lowercase name order.
+
+static const char* const LINE_IN_ID = "{mock.capture.line}";
+static const char* const HEADSET_ID = "{mock.capture.usb}";
+
+static MockEndpointProvider* InitNames()
+{
+    MockEndpointProvider* provider = CreateMock(3);
+    provider->AddEndpoint(EndpointFlow::Capture, HEADSET_ID, "USB Headset");
+    provider->AddEndpoint(EndpointFlow::Capture, LINE_IN_ID, "Line In");
+    InitWithProvider(provider);
+    return provider;
+}
+
+// Name of the device matching pPattern, empty if none.
+static std::string Match(const char* pPattern, WAIC_MatchMode pMode)
+{
+    char name[WAIC_DEVICE_NAME_SIZE];
+    return GetMatchingDeviceName(pPattern, pMode, name, sizeof(name)) ? name : "";
+}
+
+UNIT_TEST(Matching, Prefix)
+{
+    InitNames();
+    // Binary search: the first name not below the prefix, if it starts with it.
+    CHECK_EQUAL(std::string("Microphone 0"), Match("micro", WAIC_MATCH_PREFIX));
+    CHECK_EQUAL(std::string("Microphone 2"), Match("Microphone 2", WAIC_MATCH_PREFIX));
+    CHECK_EQUAL(std::string("Line In"), Match("", WAIC_MATCH_PREFIX));
+    CHECK_EQUAL(std::string("USB Headset"), Match("usb", WAIC_MATCH_PREFIX));
+    CHECK_EQUAL(std::string(), Match("microphone 3", WAIC_MATCH_PREFIX));
+    CHECK_EQUAL(std::string(), Match("n", WAIC_MATCH_PREFIX));
+    CHECK_EQUAL(std::string(), Match("zz", WAIC_MATCH_PREFIX));
+
+    WAIC_DeviceHandle device = OpenDeviceMatching("usb h", WAIC_MATCH_PREFIX);
+    CHECK(IsDeviceHandleValid(device));
+    CHECK_EQUAL(device, OpenDevice("USB Headset"));
+    CHECK(!HasError());
+    Terminate();
+}
+
+UNIT_TEST(Matching, Substring)
+{
+    InitNames();
+    CHECK_EQUAL(std::string("Microphone 1"), Match("phone 1", WAIC_MATCH_SUBSTRING));
+    CHECK_EQUAL(std::string("Microphone 0"), Match("phone", WAIC_MATCH_SUBSTRING));
+    CHECK_EQUAL(std::string("Line In"), Match("in", WAIC_MATCH_SUBSTRING));
+    CHECK_EQUAL(std::string("USB Headset"), Match("set", WAIC_MATCH_SUBSTRING));
+    CHECK_EQUAL(std::string(), Match("speaker", WAIC_MATCH_SUBSTRING));
+    // Answered again from the cache.
+    CHECK_EQUAL(std::string("Microphone 1"), Match("phone 1", WAIC_MATCH_SUBSTRING));
+    CHECK_EQUAL(std::string(), Match("speaker", WAIC_MATCH_SUBSTRING));
+    CHECK(!HasError());
+    Terminate();
+}
+
+UNIT_TEST(Matching, Wildcard)
+{
+    InitNames();
+    CHECK_EQUAL(std::string("Line In"), Match("*", WAIC_MATCH_WILDCARD));
+    CHECK_EQUAL(std::string("Microphone 0"), Match("m?c*", WAIC_MATCH_WILDCARD));
+    CHECK_EQUAL(std::string("Microphone 0"), Match("*e ?", WAIC_MATCH_WILDCARD));
+    // Backtracking: the first 'o' and 'e' candidates fail, the later ones match.
+    CHECK_EQUAL(std::string("Microphone 2"), Match("*o*o*e 2", WAIC_MATCH_WILDCARD));
+    CHECK_EQUAL(std::string("Line In"), Match("*in", WAIC_MATCH_WILDCARD));
+    CHECK_EQUAL(std::string("USB Headset"), Match("*s*t", WAIC_MATCH_WILDCARD));
+    CHECK_EQUAL(std::string("Microphone 1"), Match("**phone?1**", WAIC_MATCH_WILDCARD));
+    // The whole name must match.
+    CHECK_EQUAL(std::string(), Match("*phone", WAIC_MATCH_WILDCARD));
+    CHECK_EQUAL(std::string(), Match("microphone 1?", WAIC_MATCH_WILDCARD));
+    CHECK_EQUAL(std::string(), Match("?", WAIC_MATCH_WILDCARD));
+    CHECK(!HasError());
+    Terminate();
+}
+
+UNIT_TEST(Matching, CaseFolding)
+{
+    InitNames();
+    CHECK_EQUAL(std::string("USB Headset"), Match("uSb HEAD", WAIC_MATCH_PREFIX));
+    CHECK_EQUAL(std::string("USB Headset"), Match("HEADSET", WAIC_MATCH_SUBSTRING));
+    CHECK_EQUAL(std::string("Line In"), Match("L?NE*", WAIC_MATCH_WILDCARD));
+    // Exact names and endpoint ids are compared as is.
+    CHECK_EQUAL(std::string("USB Headset"), Match("USB Headset", WAIC_MATCH_NAME));
+    CHECK_EQUAL(std::string(), Match("usb headset", WAIC_MATCH_NAME));
+    CHECK_EQUAL(std::string("USB Headset"), Match(HEADSET_ID, WAIC_MATCH_ENDPOINT_ID));
+    CHECK_EQUAL(std::string(), Match("{MOCK.CAPTURE.USB}", WAIC_MATCH_ENDPOINT_ID));
+
+    // Truncated to the given size.
+    char name[5];
+    CHECK(GetMatchingDeviceName("usb", WAIC_MATCH_PREFIX, name, sizeof(name)));
+    CHECK_EQUAL(std::string("USB "), std::string(name));
+    CHECK(!HasError());
+    Terminate();
+}
+
+UNIT_TEST(Matching, CacheInvalidation)
+{
+    MockEndpointProvider* provider = InitNames();
+    // Negative and positive answers cached.
+    CHECK_EQUAL(std::string(), Match("*speaker*", WAIC_MATCH_WILDCARD));
+    CHECK_EQUAL(std::string(), Match("speaker", WAIC_MATCH_SUBSTRING));
+    CHECK_EQUAL(std::string("Microphone 2"), Match("phone 2", WAIC_MATCH_SUBSTRING));
+
+    provider->SetEndpointProperty("{mock.capture.1}", ENDPOINT_PKEY_FRIENDLY_NAME, EndpointPropertyValue::FromString("Desk Speaker"));
+    CHECK(WaitFor([] { return Match("*speaker*", WAIC_MATCH_WILDCARD) == "Desk Speaker"; }));
+    CHECK_EQUAL(std::string("Desk Speaker"), Match("speaker", WAIC_MATCH_SUBSTRING));
+    CHECK_EQUAL(std::string("Desk Speaker"), Match("", WAIC_MATCH_PREFIX));
+    CHECK_EQUAL(std::string(), Match("phone 1", WAIC_MATCH_SUBSTRING));
+
+    provider->RemoveEndpoint("{mock.capture.2}");
+    CHECK(WaitFor([] { return Match("phone 2", WAIC_MATCH_SUBSTRING).empty(); }));
+    CHECK_EQUAL(std::string(), Match("*2", WAIC_MATCH_WILDCARD));
+    CHECK_EQUAL(std::string("Microphone 0"), Match("microphone", WAIC_MATCH_PREFIX));
+    CHECK_EQUAL((WAIC_DeviceHandle)WAIC_INVALID_DEVICE, OpenDeviceMatching("phone 2", WAIC_MATCH_SUBSTRING));
+    ClearErrors();
+    Terminate();
+}
+
+UNIT_TEST(Matching, SharedNameFallsBackToEndpointId)
+{
+    static const char* const FIRST_ID = "{mock.capture.first}";
+    static const char* const SECOND_ID = "{mock.capture.second}";
+    MockEndpointProvider* provider = CreateMock(0);
+    provider->AddEndpoint(EndpointFlow::Capture, FIRST_ID, "Microphone");
+    provider->AddEndpoint(EndpointFlow::Capture, SECOND_ID, "Microphone");
+    InitWithProvider(provider);
+
+    // The name opens the first endpoint. The second one, matched by id, is opened under its id: its own device, not the first one's.
+    WAIC_DeviceHandle byName = OpenDevice("Microphone");
+    WAIC_DeviceHandle second = OpenDeviceMatching(SECOND_ID, WAIC_MATCH_ENDPOINT_ID);
+    CHECK(IsDeviceHandleValid(byName));
+    CHECK(IsDeviceHandleValid(second));
+    CHECK(second != byName);
+    CHECK_EQUAL(byName, OpenDeviceMatching(FIRST_ID, WAIC_MATCH_ENDPOINT_ID));
+    CHECK_EQUAL(second, OpenDeviceMatching(SECOND_ID, WAIC_MATCH_ENDPOINT_ID));
+
+    CHECK(SetListenToDevice(second, true));
+    EndpointPropertyValue first, secondValue;
+    CHECK(provider->GetEndpointProperty(FIRST_ID, ListenEnabledProperty::GetKey(), first));
+    CHECK(provider->GetEndpointProperty(SECOND_ID, ListenEnabledProperty::GetKey(), secondValue));
+    CHECK(!first.boolValue);
+    CHECK(secondValue.boolValue);
+    CHECK(!HasError());
+    Terminate();
+}
@@ -0,0 +1,181 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "EndpointProperties.h"
+#include "MockEndpointProvider.h"
+#include "UnitTest.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <cstring>
+
+// Endpoint notifications fired by the mock backend: the opened devices must follow without any RefreshAudioInputs().
+
+static const char* const DEVICE_ID = "{mock.capture.1}";
+static const char* const DEVICE_NAME = "Microphone 1";
+
+// Drains the pending events into pEvents until it holds at least pCount of them, then a bit longer to catch unexpected ones.
+static void CollectEvents(std::vector<WAIC_Event>& pEvents, size_t pCount)
+{
+    auto drain = [&]
+    {
+        WAIC_Event events[16];
+        int count = DrainEvents(events, 16);
+        pEvents.insert(pEvents.end(), events, events + count);
+        return pEvents.size() >= pCount;
+    };
+    WaitFor(drain);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    drain();
+}
+
+static int CountEvents(const std::vector<WAIC_Event>& pEvents, WAIC_EventType pType, const char* pName)
+{
+    int count = 0;
+    for (const WAIC_Event& event : pEvents)
+    {
+        if (event.type == pType && strcmp(event.name, pName) == 0) ++count;
+    }
+    return count;
+}
+
+UNIT_TEST(Notifications, RemovedThenAddedDevice)
+{
+    MockEndpointProvider* provider = InitMock(3);
+    WAIC_DeviceHandle device = OpenDevice(DEVICE_NAME);
+    CHECK(IsDeviceHandleValid(device));
+    CHECK(SetListenToDevice(device, true));
+
+    provider->RemoveEndpoint(DEVICE_ID);
+    CHECK(WaitFor([&] { return !IsDeviceHandleValid(device); }));
+    std::vector<WAIC_Event> events;
+    CollectEvents(events, 1);
+    CHECK_EQUAL(1, (int)events.size());
+    CHECK_EQUAL(1, CountEvents(events, WAIC_EVENT_DEVICE_REMOVED, DEVICE_NAME));
+
+    // The stale handle is refused, the name is not found anymore.
+    ClearErrors();
+    CHECK(!SetListenToDevice(device, false));
+    WAIC_ErrorRecord record;
+    CHECK_EQUAL(1, DrainErrors(&record, 1));
+    CHECK_EQUAL((int)WAIC_ERROR_INVALID_HANDLE, record.code);
+    CHECK_EQUAL((WAIC_DeviceHandle)WAIC_INVALID_DEVICE, OpenDevice(DEVICE_NAME));
+    ClearErrors();
+
+    provider->AddEndpoint(EndpointFlow::Capture, DEVICE_ID, DEVICE_NAME);
+    events.clear();
+    CollectEvents(events, 1);
+    CHECK_EQUAL(1, (int)events.size());
+    CHECK_EQUAL(1, CountEvents(events, WAIC_EVENT_DEVICE_ADDED, DEVICE_NAME));
+
+    // Re-opened on its next use, with a new handle.
+    WAIC_DeviceHandle reopened = OpenDevice(DEVICE_NAME);
+    CHECK(reopened != WAIC_INVALID_DEVICE);
+    CHECK(reopened != device);
+    CHECK(!IsDeviceHandleValid(device));
+    CHECK(SetListenToDevice(reopened, true));
+    CHECK(IsListening(DEVICE_NAME));
+    CHECK(!HasError());
+    Terminate();
+}
+
+UNIT_TEST(Notifications, DisabledThenEnabledDevice)
+{
+    MockEndpointProvider* provider = InitMock(3);
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, true));
+    WAIC_DeviceHandle device = OpenDevice(DEVICE_NAME);
+    CHECK(IsDeviceHandleValid(device));
+
+    provider->SetEndpointState(DEVICE_ID, ENDPOINT_STATE_DISABLED);
+    CHECK(WaitFor([&] { return !IsDeviceHandleValid(device); }));
+    std::vector<WAIC_Event> events;
+    CollectEvents(events, 1);
+    CHECK_EQUAL(1, (int)events.size());
+    CHECK_EQUAL(1, CountEvents(events, WAIC_EVENT_DEVICE_REMOVED, DEVICE_NAME));
+    CHECK(!SetListenToAudioInputDevice(DEVICE_NAME, false));
+    ClearErrors();
+
+    provider->SetEndpointState(DEVICE_ID, ENDPOINT_STATE_ACTIVE);
+    events.clear();
+    CollectEvents(events, 1);
+    CHECK_EQUAL(1, (int)events.size());
+    CHECK_EQUAL(1, CountEvents(events, WAIC_EVENT_DEVICE_ADDED, DEVICE_NAME));
+
+    // The name is resolved again on its next use: the listen state is read from the endpoint, not from the released device.
+    uint64_t readCount = GetListenStateReadCount();
+    CHECK(IsListening(DEVICE_NAME));
+    CHECK_EQUAL((unsigned long long)readCount + 1, GetListenStateReadCount());
+    CHECK(SetListenToAudioInputDevice(DEVICE_NAME, false));
+    WAIC_DeviceHandle reopened = OpenDevice(DEVICE_NAME);
+    CHECK(IsDeviceHandleValid(reopened));
+    CHECK(reopened != device);
+    CHECK(!HasError());
+    Terminate();
+}
+
+UNIT_TEST(Notifications, RenamedDevice)
+{
+    MockEndpointProvider* provider = InitMock(3);
+    WAIC_DeviceHandle device = OpenDevice(DEVICE_NAME);
+    // Negative answer cached by the name index.
+    CHECK_EQUAL((WAIC_DeviceHandle)WAIC_INVALID_DEVICE, OpenDevice("Headset"));
+    ClearErrors();
+
+    provider->SetEndpointProperty(DEVICE_ID, ENDPOINT_PKEY_FRIENDLY_NAME, EndpointPropertyValue::FromString("Headset"));
+    CHECK(WaitFor([&] { return !IsDeviceHandleValid(device); }));
+    WAIC_DeviceHandle renamed = OpenDevice("Headset");
+    CHECK(IsDeviceHandleValid(renamed));
+    CHECK_EQUAL((WAIC_DeviceHandle)WAIC_INVALID_DEVICE, OpenDevice(DEVICE_NAME));
+
+    // Renaming is neither an addition nor a removal.
+    std::vector<WAIC_Event> events;
+    CollectEvents(events, 0);
+    CHECK_EQUAL(0, CountEvents(events, WAIC_EVENT_DEVICE_ADDED, "Headset") + CountEvents(events, WAIC_EVENT_DEVICE_REMOVED, DEVICE_NAME));
+    Terminate();
+}
+
+UNIT_TEST(Notifications, OwnListenWrites)
+{
+    MockEndpointProvider* provider = InitMock(3);
+    WAIC_DeviceHandle device = OpenDevice(DEVICE_NAME);
+    CHECK(IsDeviceHandleValid(device));
+    CHECK(SetListenToDevice(device, true));
+    std::vector<WAIC_Event> events;
+    CollectEvents(events, 0);
+
+    // The notifications echoing the writes of the controller are not read again, and raise no event.
+    uint64_t readCount = GetListenStateReadCount();
+    for (int i = 0; i < 10; ++i)
+    {
+        CHECK(SetListenToDevice(device, i % 2 == 0));
+    }
+    events.clear();
+    CollectEvents(events, 0);
+    CHECK(!IsListening(DEVICE_NAME));
+    CHECK_EQUAL((unsigned long long)readCount, GetListenStateReadCount());
+    CHECK_EQUAL(0, CountEvents(events, WAIC_EVENT_LISTEN_CHANGED, DEVICE_NAME));
+
+    // A change made outside of the controller is still read.
+    provider->SetEndpointProperty(DEVICE_ID, ListenEnabledProperty::GetKey(), EndpointPropertyValue::FromBool(true));
+    events.clear();
+    CollectEvents(events, 1);
+    CHECK_EQUAL((unsigned long long)readCount + 1, GetListenStateReadCount());
+    CHECK_EQUAL(1, CountEvents(events, WAIC_EVENT_LISTEN_CHANGED, DEVICE_NAME));
+    CHECK(IsListening(DEVICE_NAME));
+    CHECK(!HasError());
+    Terminate();
+}
@@ -0,0 +1,108 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "EndpointProperties.h"
+#include "MockEndpointProvider.h"
+#include "UnitTest.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Snapshot and listen profiles: the endpoints are keyed by endpoint id, two of them sharing a friendly name are both handled.
+
+static const char* const FIRST_ID = "{mock.capture.first}";
+static const char* const SECOND_ID = "{mock.capture.second}";
+static const char* const SHARED_NAME = "Microphone";
+
+static MockEndpointProvider* InitSharedName(bool pSecondListening)
+{
+    MockEndpointProvider* provider = CreateMock(0);
+    provider->AddEndpoint(EndpointFlow::Capture, FIRST_ID, SHARED_NAME);
+    provider->AddEndpoint(EndpointFlow::Capture, SECOND_ID, SHARED_NAME);
+    provider->SetEndpointProperty(SECOND_ID, ListenEnabledProperty::GetKey(), EndpointPropertyValue::FromBool(pSecondListening));
+    InitWithProvider(provider);
+    return provider;
+}
+
+static const WAIC_DeviceSnapshot* FindRecord(const WAIC_DeviceSnapshot* pRecords, int pCount, const char* pEndpointId)
+{
+    for (int i = 0; i < pCount; ++i)
+    {
+        if (strcmp(pRecords[i].endpointId, pEndpointId) == 0) return &pRecords[i];
+    }
+    return NULL;
+}
+
+UNIT_TEST(Profiles, SnapshotSharedName)
+{
+    InitSharedName(true);
+    WAIC_DeviceSnapshot records[4];
+    int count = Snapshot(records, 4, NULL);
+    CHECK_EQUAL(2, count);
+    const WAIC_DeviceSnapshot* first = FindRecord(records, count, FIRST_ID);
+    const WAIC_DeviceSnapshot* second = FindRecord(records, count, SECOND_ID);
+    CHECK(first != NULL && second != NULL);
+    if (first != NULL && second != NULL)
+    {
+        CHECK_EQUAL(0, first->listen);
+        CHECK_EQUAL(1, second->listen);
+    }
+    CHECK(!HasError());
+    Terminate();
+}
+
+UNIT_TEST(Profiles, SnapshotAllocations)
+{
+    InitMock(100);
+    std::vector<WAIC_DeviceSnapshot> records(100);
+    CHECK_EQUAL(100, Snapshot(records.data(), 100, NULL));
+
+    // Every device opened and its listen state cached: no allocation anymore.
+    uint64_t allocationCount = GetAllocationCount();
+    for (int i = 0; i < 10; ++i)
+    {
+        CHECK_EQUAL(100, Snapshot(records.data(), 100, NULL));
+    }
+    CHECK_EQUAL(allocationCount, GetAllocationCount());
+    CHECK(!HasError());
+    Terminate();
+}
+
+UNIT_TEST(Profiles, RestoreSharedName)
+{
+    InitSharedName(true);
+    int size = SaveListenProfile(NULL, 0);
+    CHECK(size > 0);
+    std::vector<uint8_t> profile((size_t)size);
+    CHECK_EQUAL(size, SaveListenProfile(profile.data(), size));
+    Terminate();
+
+    // Only the second endpoint differs from the profile.
+    MockEndpointProvider* provider = InitSharedName(false);
+    CHECK_EQUAL(1, RestoreListenProfile(profile.data(), size));
+    EndpointPropertyValue first, second;
+    CHECK(provider->GetEndpointProperty(FIRST_ID, ListenEnabledProperty::GetKey(), first));
+    CHECK(provider->GetEndpointProperty(SECOND_ID, ListenEnabledProperty::GetKey(), second));
+    CHECK(!first.boolValue);
+    CHECK(second.boolValue);
+    CHECK_EQUAL(0, RestoreListenProfile(profile.data(), size));
+    CHECK(!HasError());
+    Terminate();
+}
@@ -0,0 +1,167 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "SampleConversion.h"
+#include "SampleRing.h"
+#include "UnitTest.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+// Sample conversions and the sample ring. The conversions of 8 samples run the SSE2 kernels (where available), those of one sample the scalar code.
+
+static int32_t ReadInt24(const uint8_t* pBytes)
+{
+    return (int32_t)(((uint32_t)pBytes[0] << 8) | ((uint32_t)pBytes[1] << 16) | ((uint32_t)pBytes[2] << 24)) >> 8;
+}
+
+// Converts pInput to pType in one call, then one sample at a time: both must agree. Returns the samples as int32.
+static std::vector<int32_t> FromFloat(EndpointSampleType pType, const std::vector<float>& pInput)
+{
+    size_t sampleSize = (pType == EndpointSampleType::Int16) ? 2 : ((pType == EndpointSampleType::Int24) ? 3 : 4);
+    std::vector<uint8_t> all(pInput.size() * sampleSize);
+    std::vector<uint8_t> single(pInput.size() * sampleSize);
+    ConvertFromFloat(pType, pInput.data(), all.data(), pInput.size());
+    for (size_t i = 0; i < pInput.size(); ++i)
+    {
+        ConvertFromFloat(pType, &pInput[i], &single[i * sampleSize], 1);
+    }
+
+    std::vector<int32_t> samples(pInput.size());
+    for (size_t i = 0; i < pInput.size(); ++i)
+    {
+        const uint8_t* sample = &all[i * sampleSize];
+        if (pType == EndpointSampleType::Int16) samples[i] = *(const int16_t*)sample;
+        else if (pType == EndpointSampleType::Int24) samples[i] = ReadInt24(sample);
+        else samples[i] = *(const int32_t*)sample;
+        CHECK(memcmp(sample, &single[i * sampleSize], sampleSize) == 0);
+    }
+    return samples;
+}
+
+UNIT_TEST(Samples, Int16RoundTrip)
+{
+    std::vector<int16_t> input(65536 + 3);
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        input[i] = (int16_t)(i - 32768);
+    }
+    std::vector<float> samples(input.size());
+    std::vector<int16_t> output(input.size());
+    ConvertToFloat(EndpointSampleType::Int16, input.data(), samples.data(), input.size());
+    ConvertFromFloat(EndpointSampleType::Int16, samples.data(), output.data(), output.size());
+    CHECK(input == output);
+    CHECK_EQUAL(-1.0f, samples[0]);
+}
+
+UNIT_TEST(Samples, Int24RoundTrip)
+{
+    std::vector<int32_t> values = { -8388608, -8388607, -65536, -1, 0, 1, 255, 256, 65535, 4194304, 8388607 };
+    std::vector<uint8_t> input(values.size() * 3);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        input[i * 3] = (uint8_t)(values[i] & 0xFF);
+        input[i * 3 + 1] = (uint8_t)((values[i] >> 8) & 0xFF);
+        input[i * 3 + 2] = (uint8_t)((values[i] >> 16) & 0xFF);
+    }
+    std::vector<float> samples(values.size());
+    ConvertToFloat(EndpointSampleType::Int24, input.data(), samples.data(), values.size());
+    CHECK_EQUAL(-1.0f, samples[0]);
+    CHECK(FromFloat(EndpointSampleType::Int24, samples) == values);
+}
+
+UNIT_TEST(Samples, Int32RoundTrip)
+{
+    // A float holds 24 significant bits: the multiples of 256 round trip exactly.
+    std::vector<int32_t> values = { INT32_MIN, INT32_MIN + 256, -65536, -256, 0, 256, 65536, 1 << 30, INT32_MAX - 255 };
+    std::vector<float> samples(values.size());
+    ConvertToFloat(EndpointSampleType::Int32, values.data(), samples.data(), values.size());
+    CHECK_EQUAL(-1.0f, samples[0]);
+    CHECK(FromFloat(EndpointSampleType::Int32, samples) == values);
+}
+
+UNIT_TEST(Samples, Clamping)
+{
+    const float infinity = std::numeric_limits<float>::infinity();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    std::vector<float> input = { 2.0f, -2.0f, 1.0f, -1.0f, infinity, -infinity, nan, -nan };
+
+    std::vector<int32_t> int16 = FromFloat(EndpointSampleType::Int16, input);
+    CHECK((int16 == std::vector<int32_t>{ 32767, -32768, 32767, -32768, 32767, -32768, 0, 0 }));
+
+    std::vector<int32_t> int24 = FromFloat(EndpointSampleType::Int24, input);
+    CHECK((int24 == std::vector<int32_t>{ 8388607, -8388608, 8388607, -8388608, 8388607, -8388608, 0, 0 }));
+
+    // The largest float below 1.0, times 2^31.
+    std::vector<int32_t> int32 = FromFloat(EndpointSampleType::Int32, input);
+    CHECK((int32 == std::vector<int32_t>{ 2147483520, INT32_MIN, 2147483520, INT32_MIN, 2147483520, INT32_MIN, 0, 0 }));
+}
+
+UNIT_TEST(Samples, FloatClamping)
+{
+    const float infinity = std::numeric_limits<float>::infinity();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const std::vector<float> input = { 2.0f, -2.0f, 1.0f, -1.0f, infinity, -infinity, nan, 0.5f };
+    const std::vector<float> expected = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.5f };
+
+    std::vector<float> all(input.size());
+    ConvertFromFloat(EndpointSampleType::Float32, input.data(), all.data(), input.size());
+    CHECK(all == expected);
+    std::vector<float> single(input.size());
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        ConvertFromFloat(EndpointSampleType::Float32, &input[i], &single[i], 1);
+    }
+    CHECK(single == expected);
+
+    // The monitor path of a float output: mapped with a gain in the render buffer, then clamped in place.
+    const int8_t map[2] = { 1, 0 };
+    std::vector<float> stereo = { nan, 0.25f, 0.75f, -0.75f, 0.1f, nan, 0.5f, -0.5f };
+    std::vector<float> output(stereo.size());
+    MapChannels(stereo.data(), 2, output.data(), 2, map, 2.0f, 4);
+    ClampSamples(output.data(), output.size());
+    CHECK((output == std::vector<float>{ 0.5f, 0.0f, -1.0f, 1.0f, 0.0f, 0.2f, -1.0f, 1.0f }));
+}
+
+UNIT_TEST(Samples, RingWraparound)
+{
+    SampleRing ring;
+    ring.Reset(6);
+    CHECK_EQUAL((size_t)8, ring.GetCapacity());
+
+    float input[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    float output[8] = {};
+    CHECK_EQUAL((size_t)6, ring.Write(input, 6));
+    CHECK_EQUAL((size_t)6, ring.Read(output, 6));
+
+    // Written from index 6: wraps after 2 samples. Full after 8.
+    CHECK_EQUAL((size_t)8, ring.Write(input, 8));
+    CHECK_EQUAL((size_t)0, ring.Write(input, 1));
+    CHECK_EQUAL((size_t)8, ring.GetAvailable());
+    CHECK_EQUAL((size_t)3, ring.Skip(3));
+    CHECK_EQUAL((size_t)5, ring.Read(output, 8));
+    for (int i = 0; i < 5; ++i)
+    {
+        CHECK_EQUAL(input[i + 3], output[i]);
+    }
+    CHECK_EQUAL((size_t)0, ring.GetAvailable());
+    CHECK_EQUAL((size_t)0, ring.Read(output, 1));
+}
@@ -0,0 +1,89 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "ControllerService.h"
+#include "MockEndpointProvider.h"
+#include "UnitTest.h"
+#include "WindowsAudioInputsController.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <string>
+
+// Client mode: the calls are forwarded to a controller service started in this process, on the mock backend.
+
+static std::string GetServiceName()
+{
+    return "WAIC_UnitTest_" + std::to_string((unsigned long long)std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+UNIT_TEST(Service, DeviceHandles)
+{
+    ControllerService service(new WindowsAudioInputsController(CreateMock(2)));
+    std::string name = GetServiceName();
+    CHECK(service.Start(name));
+    CHECK(InitClient(name.c_str()));
+
+    WAIC_DeviceHandle devices[2] = { OpenDevice("Microphone 0"), OpenDevice("Microphone 1") };
+    CHECK(IsDeviceHandleValid(devices[0]));
+    CHECK(IsDeviceHandleValid(devices[1]));
+    CHECK(!IsDeviceHandleValid(WAIC_INVALID_DEVICE));
+
+    bool listen[2] = { true, false };
+    bool results[2] = { false, false };
+    CHECK_EQUAL(2, SetListenToDevices(devices, listen, 2, results));
+    CHECK(results[0] && results[1]);
+
+    bool isListening[2] = { false, true };
+    CHECK_EQUAL(2, GetDeviceListenStates(devices, 2, isListening, results));
+    CHECK(results[0] && results[1]);
+    CHECK(isListening[0]);
+    CHECK(!isListening[1]);
+    CHECK(IsListening("Microphone 0"));
+
+    // Refused by the service: the errors come back to the client.
+    WAIC_DeviceHandle invalid[1] = { WAIC_INVALID_DEVICE };
+    CHECK_EQUAL(0, GetDeviceListenStates(invalid, 1, isListening, results));
+    CHECK(!results[0]);
+    CHECK(HasError());
+    ClearErrors();
+
+    Terminate();
+    service.Stop();
+}
+
+UNIT_TEST(Service, EmptyDeviceName)
+{
+    ControllerService service(new WindowsAudioInputsController(CreateMock(1)));
+    std::string name = GetServiceName();
+    CHECK(service.Start(name));
+    CHECK(InitClient(name.c_str()));
+
+    // Sent as empty strings, the last field of their request: refused by the service, which keeps serving.
+    CHECK(!IsListening(""));
+    CHECK(!IsListening(NULL));
+    CHECK_EQUAL((WAIC_DeviceHandle)WAIC_INVALID_DEVICE, OpenDevice(""));
+    WAIC_ErrorRecord record;
+    CHECK_EQUAL(1, DrainErrors(&record, 1));
+    CHECK_EQUAL((int)WAIC_ERROR_DEVICE_NOT_FOUND, record.code);
+    ClearErrors();
+    CHECK(SetListenToAudioInputDevice("Microphone 0", true));
+    CHECK(IsListening("Microphone 0"));
+
+    Terminate();
+    service.Stop();
+}
@@ -0,0 +1,119 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#pragma once
+
+#include "MockEndpointProvider.h"
+#include "WindowsAudioInputsControllerC.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Minimal test framework: each UNIT_TEST registers itself, the runner executes the tests of the suite given on its command line
+// (all of them without argument). A failed CHECK reports the expression and lets the test go on.
+
+typedef void (*UnitTestFunction)();
+
+struct UnitTest
+{
+    const char* suite;
+    const char* name;
+    UnitTestFunction function;
+};
+
+std::vector<UnitTest>& GetUnitTests();
+// Number of operator new calls since the start, on all the threads.
+uint64_t GetAllocationCount();
+void ReportFailure(const char* pFile, int pLine, const std::string& pMessage);
+
+struct UnitTestRegistration
+{
+    UnitTestRegistration(const char* pSuite, const char* pName, UnitTestFunction pFunction)
+    {
+        GetUnitTests().push_back({ pSuite, pName, pFunction });
+    }
+};
+
+#define UNIT_TEST(pSuite, pName) \
+    static void pSuite##_##pName(); \
+    static UnitTestRegistration pSuite##_##pName##_Registration(#pSuite, #pName, pSuite##_##pName); \
+    static void pSuite##_##pName()
+
+#define CHECK(pCondition) \
+    do { if (!(pCondition)) ReportFailure(__FILE__, __LINE__, "CHECK(" #pCondition ")"); } while (0)
+
+#define CHECK_EQUAL(pExpected, pActual) \
+    do \
+    { \
+        auto expected_ = (pExpected); \
+        auto actual_ = (pActual); \
+        if (!(expected_ == actual_)) \
+        { \
+            std::ostringstream message_; \
+            message_ << "CHECK_EQUAL(" #pExpected ", " #pActual "): expected " << expected_ << ", got " << actual_; \
+            ReportFailure(__FILE__, __LINE__, message_.str()); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(pExpected, pActual, pTolerance) \
+    do \
+    { \
+        double expected_ = (double)(pExpected); \
+        double actual_ = (double)(pActual); \
+        if (!(actual_ >= expected_ - (pTolerance) && actual_ <= expected_ + (pTolerance))) \
+        { \
+            std::ostringstream message_; \
+            message_ << "CHECK_NEAR(" #pExpected ", " #pActual "): expected " << expected_ << " +/- " << (pTolerance) << ", got " << actual_; \
+            ReportFailure(__FILE__, __LINE__, message_.str()); \
+        } \
+    } while (0)
+
+// Polls pCondition until it is true, at most pTimeoutMs milliseconds (the notifications are applied asynchronously, on the library worker thread).
+inline bool WaitFor(const std::function<bool()>& pCondition, int pTimeoutMs = 2000)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(pTimeoutMs);
+    while (!pCondition())
+    {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Mock backend with pDeviceCount active capture endpoints ({mock.capture.0} "Microphone 0" to {mock.capture.<n-1>} "Microphone <n-1>"),
+// its injected faults drawn from pFaultSeed. The library or service it is given to owns it.
+inline MockEndpointProvider* CreateMock(int pDeviceCount, uint64_t pFaultSeed = 1234)
+{
+    MockEndpointProvider* provider = new MockEndpointProvider();
+    provider->AddCaptureEndpoints(pDeviceCount);
+    provider->SetFaultSeed(pFaultSeed);
+    return provider;
+}
+
+// Same as CreateMock, then initializes the library with it.
+inline MockEndpointProvider* InitMock(int pDeviceCount, uint64_t pFaultSeed = 1234)
+{
+    MockEndpointProvider* provider = CreateMock(pDeviceCount, pFaultSeed);
+    InitWithProvider(provider);
+    return provider;
+}
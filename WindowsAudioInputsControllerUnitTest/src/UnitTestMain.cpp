@@ -0,0 +1,87 @@
+/******************************************************************************************************************************************************
+* MIT License																																		  *
+*																																					  *
+* Copyright (c) 2024																																  *
+* Emmanuel Badier <emmanuel.badier@gmail.com>																										  *
+* 																																					  *
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),  *
+* to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  *
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:		  *
+* 																																					  *
+* The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.					  *
+* 																																					  *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 																							  *
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 		  *
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.							  *
+******************************************************************************************************************************************************/
+
+#include "UnitTest.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+static int sFailureCount = 0;
+static std::atomic<uint64_t> sAllocationCount(0);
+
+// Counts the allocations of every thread (see GetAllocationCount).
+void* operator new(size_t pSize)
+{
+    sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* memory = malloc((pSize > 0) ? pSize : 1);
+    if (memory == NULL) throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void* pMemory) noexcept
+{
+    free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+    free(pMemory);
+}
+
+uint64_t GetAllocationCount()
+{
+    return sAllocationCount.load(std::memory_order_relaxed);
+}
+
+std::vector<UnitTest>& GetUnitTests()
+{
+    static std::vector<UnitTest> tests;
+    return tests;
+}
+
+void ReportFailure(const char* pFile, int pLine, const std::string& pMessage)
+{
+    std::cerr << pFile << "(" << pLine << "): " << pMessage << std::endl;
+    ++sFailureCount;
+}
+
+// Usage: WindowsAudioInputsControllerUnitTest [suite]
+int main(int pArgc, char** pArgv)
+{
+    const char* suite = (pArgc > 1) ? pArgv[1] : NULL;
+    int runCount = 0;
+    int failedCount = 0;
+    for (const UnitTest& test : GetUnitTests())
+    {
+        if (suite != NULL && strcmp(suite, test.suite) != 0) continue;
+
+        int previousFailureCount = sFailureCount;
+        test.function();
+        ++runCount;
+        bool failed = (sFailureCount != previousFailureCount);
+        failedCount += failed ? 1 : 0;
+        std::cout << (failed ? "[FAILED] " : "[  OK  ] ") << test.suite << "." << test.name << std::endl;
+    }
+
+    std::cout << runCount << " tests, " << failedCount << " failed" << std::endl;
+    // An unknown suite is an error too: its tests would silently never run.
+    return (runCount > 0 && failedCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}